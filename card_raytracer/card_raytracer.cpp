@@ -1,309 +1,546 @@
-﻿/**
-Исходный тест https://github.com/Mark-Kovalyov/CardRaytracerBenchmark/blob/master/cpp/card-raytracer.cpp
-
-Пример преобразования однопоточного кода генератора картинки img.ppm размером 512*512
-img.ppm можно посмотреть каким-нибудь просмотрщиком изображений, например IrfanView
-
-Исходный вариант решения (original()) открывает файл, в двух вложенных циклах (высота, ширина) последовательно
-обсчитывает каждый пиксель изображения и сохраняет в файл. 
-
-По модели акторов создается три актора:
-1. Считатель. Обсчитывает один пиксель. Код Считателя потокобезопасный, т.к. не имеет меняющегося окружения, 
-   поэтому его можно запускать параллельно.
-2. Упорядочиватель. Однопоточный. Восстанавливает порядок следования сообщений.
-3. Писатель. Однопоточный. Пишет результат в файл.
-
-В начале работы (actor_start(int threads)) создается 260 тыс. сообщений, заданий на обсчет каждой точки и 
-отправляются Считателю. По окончанию обсчета точки Считатель отправляет результат Упорядочивателю, который
-кэширует пришедшие не по порядку сообщения и отправляет Писателю сообщения в соответствии с изначальным 
-порядком.
-
-
------------------------------------------------------------------------------------------------------------
-Запускать с параметром количество потоков
-
-card_raytracer.exe [threads]
-
-если указать 0 запустится оригинальный вариант без акторов
-по умолчанию threads = 4 
-
-
-*/
-
-#define _CRT_SECURE_NO_WARNINGS
-#include <stdlib.h>   
-#include <stdio.h>
-#include <math.h>
-#include <assert.h>
-#define LT_STAT
-#ifdef NDEBUG
-#undef NDEBUG
-#endif
-#include "../lite_thread_util.h"
-
-#define WIDTH  512
-#define HEIGHT 512
-
-#define FILE_NAME "img.ppm"
-
-
-
-struct Vector {
-
-	Vector() {
-	}
-
-	Vector(double a, double b, double c) {
-		x = a;
-		y = b;
-		z = c;
-	}
-
-	void init(double a, double b, double c) {
-		x = a;
-		y = b;
-		z = c;
-	}
-
-	double x, y, z;
-
-	Vector operator+(const Vector &r) {
-		return Vector(x + r.x, y + r.y, z + r.z);
-	}
-
-	Vector operator*(double r) {
-		return Vector(x * r, y * r, z * r);
-	}
-
-	double operator%(const Vector &r) {
-		return x * r.x + y * r.y + z * r.z;
-	}
-
-	Vector operator^(const Vector &r) {
-		return Vector(y * r.z - z * r.y, z * r.x - x * r.z, x * r.y - y * r.x);
-	}
-
-	Vector operator!() {
-		return *this * (1 / sqrt(*this % *this));
-	}
-
-	void print(FILE* out) {
-		fprintf(out, "%c%c%c", (int)x, (int)y, (int)z);
-	}
-};
-
-int G[] = {
-	0x0003C712,  // 00111100011100010010 
-	0x00044814,  // 01000100100000010100
-	0x00044818,  // 01000100100000011000
-	0x0003CF94,  // 00111100111110010100
-	0x00004892,  // 00000100100010010010
-	0x00004891,  // 00000100100010010001
-	0x00038710,  // 00111000011100010000
-	0x00000010,  // 00000000000000010000
-	0x00000010,  // 00000000000000010000
-};
-
-double Random() {
-	return (double)rand() / RAND_MAX;
-}
-
-int tracer(Vector o, Vector d, double &t, Vector& n) {
-	t = 1e9;
-	int m = 0;
-	double p = -o.z / d.z;
-	if (.01 < p) {
-		t = p;
-		n = Vector(0, 0, 1);
-		m = 1;
-	}
-	for (int k = 19; k--;)
-		for (int j = 9; j--;)
-			if (G[j] & 1 << k) {
-				Vector p = o + Vector(-k, 0, -j - 4);
-				double b = p % d;
-				double c = p % p - 1;
-				double q = b * b - c;
-				if (q > 0) {
-					double s = -b - sqrt(q);
-					if (s < t && s > .01) {
-						t = s;
-						n = !(p + d * t);
-						m = 2;
-					}
-				}
-			}
-	return m;
-}
-
-Vector sampler(Vector o, Vector d) {
-	double t;
-	Vector n;
-	int m = tracer(o, d, t, n);
-	if (!m) {
-		return Vector(.7, .6, 1) * pow(1 - d.z, 4);
-	}
-	Vector h = o + d * t;
-	Vector l = !(Vector(9 + Random(), 9 + Random(), 16) + h * -1);
-	Vector r = d + n * (n % d * -2);
-	double b = l % n;
-	if (b < 0 || tracer(h, l, t, n)) {
-		b = 0;
-	}
-	double p = pow(l % r * (b > 0), 99);
-	if (m & 1) {
-		h = h * .2;
-		return ((int)(ceil(h.x) + ceil(h.y)) & 1 ? Vector(3, 1, 1) : Vector(3, 3, 3)) * (b * .2 + .1);
-	}
-	return Vector(p, p, p) + sampler(h, r) * .5;
-}
-
-//----------------------------------------------------------------------
-// Исходный вариант без акторов
-void original() {
-	FILE *out = fopen(FILE_NAME, "w");
-	assert(out != NULL);
-	fprintf(out, "P6 %d %d 255 ", WIDTH, HEIGHT);
-	Vector g = !Vector(-6, -16, 0);
-	Vector a = !(Vector(0, 0, 1) ^ g) * .002;
-	Vector b = !(g ^ a) * .002;
-	Vector c = (a + b) * -256 + g;
-	for (int y = HEIGHT; y--;) {
-		for (int x = WIDTH; x--;) {
-			Vector p(13, 13, 13);
-			for (int r = 64; r--;) {
-				Vector t = a * (Random() - .5) * 99 + b * (Random() - .5) * 99;
-				p = sampler(Vector(17, 16, 8) + t, !(t * -1 + (a * (Random() + x) + b * (y + Random()) + c) * 16)) * 3.5 + p;
-			}
-			p.print(out);
-		}
-	}
-	fclose(out);
-}
-
-//----------------------------------------------------------------------
-//Вариант с акторами
-struct msg_t : public lite_msg_t {
-	size_t idx;
-	int x;
-	int y;
-	Vector result;
-};
-
-// Писатель (однопоточный)
-class writer_t : public lite_actor_t {
-	FILE *out;
-public:
-	writer_t() {
-		type_add(lite_msg_type<msg_t>()); // Разрешение принимать сообщение типа msg_t
-		out = fopen(FILE_NAME, "w");
-		assert(out != NULL);
-		fprintf(out, "P6 %d %d 255 ", WIDTH, HEIGHT);
-	}
-
-	~writer_t() {
-		fclose(out);
-	}
-
-	// Обработка сообщения
-	void recv(lite_msg_t* msg) override {
-		msg_t* m = static_cast<msg_t*>(msg);
-		assert(m != NULL);
-		m->result.print(out);
-	}
-};
-
-
-// Считатель (потокобезопасный)
-class worker_t : public lite_actor_t {
-	Vector g = !Vector(-6, -16, 0);
-	Vector a = !(Vector(0, 0, 1) ^ g) * .002;
-	Vector b = !(g ^ a) * .002;
-	Vector c = (a + b) * -256 + g;
-	lite_actor_t* order; // Упорядочиватель
-
-public:
-	worker_t() {
-		order = lite_actor_get("order"); // Получение упорядочивателя по имени
-		assert(order != NULL);
-		type_add(lite_msg_type<msg_t>()); // Разрешение принимать сообщение типа msg_t
-	}
-
-	// Расчет одного пикселя
-	void calc(int x, int y, Vector& p) {
-		p.init(13, 13, 13);
-		for (int r = 64; r--;) {
-			Vector t = a * (Random() - .5) * 99 + b * (Random() - .5) * 99;
-			p = sampler(Vector(17, 16, 8) + t, !(t * -1 + (a * (Random() + x) + b * (y + Random()) + c) * 16)) * 3.5 + p;
-		}
-	}
-
-	// Прием сообщения
-	void recv(lite_msg_t* msg) override {
-		msg_t* m = static_cast<msg_t*>(msg); // Указатель на содержимое
-		assert(m != NULL);
-		calc(m->x, m->y, m->result); // Расчет
-		order->run(msg); // Отправка
-	}
-
-};
-
-// Запуск расчета
-void actor_start(int threads) {
-	// Создание акторов
-	// Писатель
-	writer_t* writer = new writer_t;
-	writer->name_set("writer");
-
-	// Упорядочиватель (из lite_thread_util.h)
-	lite_order_t<msg_t>* order = new lite_order_t<msg_t>("writer");
-	order->name_set("order");
-
-	// Считатель 
-	worker_t* worker = new worker_t;
-	worker->name_set("worker");
-	worker->parallel_set(threads);
-
-	// Ограничение количества потоков
-	lite_thread_max(threads);
-
-	// Создание сообщений
-	size_t idx = 0; // номер сообщения
-	for (int y = HEIGHT; y--;) {
-		for (int x = WIDTH; x--;) {
-			// Создание сообщения
-			msg_t* msg = new msg_t;
-			// Заполнение
-			msg->idx = idx++;
-			msg->x = x;
-			msg->y = y;
-			// Отправка
-			worker->run(msg);
-		}
-	}
-
-	printf("Init end: %lld msec\n", lite_time_now());
-
-	lite_thread_end(); // Ожидание окончания расчета
-}
-
-int main(int argc, char **argv) {
-	int threads = 0;
-	if (argc > 1) {
-		// Количество потоков
-		for (char* p = argv[1]; *p != 0 && *p >= '0' && *p <= '9'; p++) threads = threads * 10 + *p - '0';
-	} else {
-		threads = 4;
-	}
-	printf("compile %s %s\n", __DATE__, __TIME__);
-	lite_time_now(); // Начало отсчета времени
-	if(threads == 0) { // Запуск оригинального кода
-		printf("original code ...\n");
-		original();
-	} else { // запуск кода на lite_thread
-		printf("lite_thread %d threads ...\n", threads);
-		actor_start(threads);
-	}
-	printf("Time: %lld msec\n", lite_time_now());
-	return 0;
+﻿/**
+Исходный тест https://github.com/Mark-Kovalyov/CardRaytracerBenchmark/blob/master/cpp/card-raytracer.cpp
+
+Пример преобразования однопоточного кода генератора картинки img.ppm размером 512*512
+img.ppm можно посмотреть каким-нибудь просмотрщиком изображений, например IrfanView
+
+Исходный вариант решения (original()) открывает файл, в двух вложенных циклах (высота, ширина) последовательно
+обсчитывает каждый пиксель изображения и сохраняет в файл. 
+
+По модели акторов создается три актора:
+1. Считатель. Обсчитывает один пиксель. Код Считателя потокобезопасный, т.к. не имеет меняющегося окружения, 
+   поэтому его можно запускать параллельно.
+2. Упорядочиватель. Однопоточный. Восстанавливает порядок следования сообщений.
+3. Писатель. Однопоточный. Пишет результат в файл.
+
+В начале работы (actor_start(int threads)) создается 260 тыс. сообщений, заданий на обсчет каждой точки и 
+отправляются Считателю. По окончанию обсчета точки Считатель отправляет результат Упорядочивателю, который
+кэширует пришедшие не по порядку сообщения и отправляет Писателю сообщения в соответствии с изначальным 
+порядком.
+
+
+-----------------------------------------------------------------------------------------------------------
+Запускать с параметром количество потоков
+
+card_raytracer.exe [threads] [scalar|sse2|avx]
+
+если указать 0 запустится оригинальный вариант без акторов
+по умолчанию threads = 4 
+
+card_raytracer.exe --sweep [max_threads] [reps] [scalar|sse2|avx]
+
+замер масштабируемости: расчет на 1..max_threads потоках по reps раз (по умолчанию все ядра и 3 раза)
+с выводом CSV: время, сообщений в секунду, ускорение, эффективность и счетчики LT_STAT каждого прогона.
+
+Параметр scalar|sse2|avx принудительно задает вариант поиска пересечений луча со сферами, по умолчанию
+выбирается лучший из поддерживаемых процессором. Для сравнения ускорения от SIMD запускать
+с 1 и с N потоками для каждого варианта.
+
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdlib.h>   
+#include <stdio.h>
+#include <math.h>
+#include <assert.h>
+#define LT_STAT
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include "../lite_thread_util.h"
+
+#define WIDTH  512
+#define HEIGHT 512
+
+#define FILE_NAME "img.ppm"
+
+
+
+struct Vector {
+
+	Vector() {
+	}
+
+	Vector(double a, double b, double c) {
+		x = a;
+		y = b;
+		z = c;
+	}
+
+	void init(double a, double b, double c) {
+		x = a;
+		y = b;
+		z = c;
+	}
+
+	double x, y, z;
+
+	Vector operator+(const Vector &r) {
+		return Vector(x + r.x, y + r.y, z + r.z);
+	}
+
+	Vector operator*(double r) {
+		return Vector(x * r, y * r, z * r);
+	}
+
+	double operator%(const Vector &r) {
+		return x * r.x + y * r.y + z * r.z;
+	}
+
+	Vector operator^(const Vector &r) {
+		return Vector(y * r.z - z * r.y, z * r.x - x * r.z, x * r.y - y * r.x);
+	}
+
+	Vector operator!() {
+		return *this * (1 / sqrt(*this % *this));
+	}
+
+	void print(FILE* out) {
+		fprintf(out, "%c%c%c", (int)x, (int)y, (int)z);
+	}
+};
+
+int G[] = {
+	0x0003C712,  // 00111100011100010010 
+	0x00044814,  // 01000100100000010100
+	0x00044818,  // 01000100100000011000
+	0x0003CF94,  // 00111100111110010100
+	0x00004892,  // 00000100100010010010
+	0x00004891,  // 00000100100010010001
+	0x00038710,  // 00111000011100010000
+	0x00000010,  // 00000000000000010000
+	0x00000010,  // 00000000000000010000
+};
+
+//----------------------------------------------------------------------
+// Генератор случайных чисел xoshiro256**
+// Вместо rand(): у rand() общее скрытое состояние под блокировкой, из-за чего параллельные
+// Считатели ждут друг друга, а результат зависит от порядка обсчета точек.
+// Состояние свое у каждого потока и перед обсчетом точки задается от ее координат, поэтому
+// картинка одинакова при любом количестве потоков и совпадает с исходным вариантом.
+struct random_t {
+	uint64_t s[4];
+
+	static uint64_t rotl(uint64_t x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+
+	// Заполнение состояния через splitmix64
+	void seed(uint64_t x) {
+		for (int i = 0; i < 4; i++) {
+			uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			s[i] = z ^ (z >> 31);
+		}
+	}
+
+	uint64_t next() {
+		uint64_t ret = rotl(s[1] * 5, 7) * 9;
+		uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+		return ret;
+	}
+};
+
+thread_local random_t rnd;
+
+// Начало последовательности для точки (x, y)
+void random_seed(int x, int y) {
+	rnd.seed(((uint64_t)(uint32_t)y << 32) | (uint32_t)x);
+}
+
+// Случайное число [0, 1)
+double Random() {
+	return (double)(rnd.next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+//----------------------------------------------------------------------
+// Поиск пересечения луча со сферами
+// Центры сфер из G[] заранее раскладываются по массивам координат (structure-of-arrays),
+// что позволяет проверять за одну инструкцию 2 (SSE2) или 4 (AVX) сферы.
+// Вариант выбирается при запуске по возможностям процессора, по умолчанию скалярный.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RT_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define RT_TARGET_SSE2
+#define RT_TARGET_AVX
+#else
+#define RT_TARGET_SSE2 __attribute__((target("sse2")))
+#define RT_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+#define SPHERE_MAX (9 * 19 + 4) // Максимум сфер с учетом выравнивания по 4
+
+// Сферы. Центр (x, 0, z), радиус 1
+struct spheres_t {
+	alignas(32) double x[SPHERE_MAX];
+	alignas(32) double z[SPHERE_MAX];
+	alignas(32) double r2[SPHERE_MAX]; // Квадрат радиуса, у пустых выравнивающих -1e300 (пересечения нет)
+	int count; // Количество, кратно 4
+} spheres;
+
+// Заполнение списка сфер в порядке обхода исходного tracer()
+void spheres_init() {
+	int n = 0;
+	for (int k = 19; k--;)
+		for (int j = 9; j--;)
+			if (G[j] & 1 << k) {
+				spheres.x[n] = k;
+				spheres.z[n] = j + 4;
+				spheres.r2[n] = 1;
+				n++;
+			}
+	while (n % 4 != 0) { // Выравнивание пустыми сферами
+		spheres.x[n] = 0;
+		spheres.z[n] = 0;
+		spheres.r2[n] = -1e300;
+		n++;
+	}
+	spheres.count = n;
+}
+
+// Поиск ближайшей сферы с пересечением на расстоянии (.01, t). Возвращает номер сферы или -1, t - расстояние
+int hit_scalar(const Vector& o, const Vector& d, double& t) {
+	int m = -1;
+	for (int i = 0; i < spheres.count; i++) {
+		double px = o.x - spheres.x[i];
+		double pz = o.z - spheres.z[i];
+		double b = px * d.x + o.y * d.y + pz * d.z;
+		double c = px * px + o.y * o.y + pz * pz - spheres.r2[i];
+		double q = b * b - c;
+		if (q > 0) {
+			double s = -b - sqrt(q);
+			if (s < t && s > .01) {
+				t = s;
+				m = i;
+			}
+		}
+	}
+	return m;
+}
+
+#ifdef RT_X86
+// Выбор ближайшего из результатов по дорожкам. При равенстве - с меньшим номером, как в скалярном
+static int hit_reduce(const double* lane_t, const double* lane_i, int lanes, double& t) {
+	int m = -1;
+	for (int l = 0; l < lanes; l++) {
+		if (lane_i[l] < 0) continue;
+		if (m < 0 || lane_t[l] < t || (lane_t[l] == t && (int)lane_i[l] < m)) {
+			t = lane_t[l];
+			m = (int)lane_i[l];
+		}
+	}
+	return m;
+}
+
+// 2 сферы за инструкцию
+RT_TARGET_SSE2 int hit_sse2(const Vector& o, const Vector& d, double& t) {
+	__m128d ox = _mm_set1_pd(o.x), oy = _mm_set1_pd(o.y), oz = _mm_set1_pd(o.z);
+	__m128d dx = _mm_set1_pd(d.x), dy = _mm_set1_pd(d.y), dz = _mm_set1_pd(d.z);
+	__m128d yy = _mm_mul_pd(oy, oy), yd = _mm_mul_pd(oy, dy);
+	__m128d eps = _mm_set1_pd(.01), zero = _mm_setzero_pd();
+	__m128d best_t = _mm_set1_pd(t), best_i = _mm_set1_pd(-1);
+	__m128d idx = _mm_set_pd(1, 0), step = _mm_set1_pd(2);
+	for (int i = 0; i < spheres.count; i += 2) {
+		__m128d px = _mm_sub_pd(ox, _mm_load_pd(spheres.x + i));
+		__m128d pz = _mm_sub_pd(oz, _mm_load_pd(spheres.z + i));
+		__m128d b = _mm_add_pd(_mm_add_pd(_mm_mul_pd(px, dx), yd), _mm_mul_pd(pz, dz));
+		__m128d c = _mm_sub_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(px, px), yy), _mm_mul_pd(pz, pz)), _mm_load_pd(spheres.r2 + i));
+		__m128d q = _mm_sub_pd(_mm_mul_pd(b, b), c);
+		__m128d s = _mm_sub_pd(_mm_sub_pd(zero, b), _mm_sqrt_pd(_mm_max_pd(q, zero)));
+		__m128d hit = _mm_and_pd(_mm_and_pd(_mm_cmpgt_pd(q, zero), _mm_cmplt_pd(s, best_t)), _mm_cmpgt_pd(s, eps));
+		best_t = _mm_or_pd(_mm_and_pd(hit, s), _mm_andnot_pd(hit, best_t));
+		best_i = _mm_or_pd(_mm_and_pd(hit, idx), _mm_andnot_pd(hit, best_i));
+		idx = _mm_add_pd(idx, step);
+	}
+	alignas(16) double lane_t[2], lane_i[2];
+	_mm_store_pd(lane_t, best_t);
+	_mm_store_pd(lane_i, best_i);
+	return hit_reduce(lane_t, lane_i, 2, t);
+}
+
+// 4 сферы за инструкцию
+RT_TARGET_AVX int hit_avx(const Vector& o, const Vector& d, double& t) {
+	__m256d ox = _mm256_set1_pd(o.x), oy = _mm256_set1_pd(o.y), oz = _mm256_set1_pd(o.z);
+	__m256d dx = _mm256_set1_pd(d.x), dy = _mm256_set1_pd(d.y), dz = _mm256_set1_pd(d.z);
+	__m256d yy = _mm256_mul_pd(oy, oy), yd = _mm256_mul_pd(oy, dy);
+	__m256d eps = _mm256_set1_pd(.01), zero = _mm256_setzero_pd();
+	__m256d best_t = _mm256_set1_pd(t), best_i = _mm256_set1_pd(-1);
+	__m256d idx = _mm256_set_pd(3, 2, 1, 0), step = _mm256_set1_pd(4);
+	for (int i = 0; i < spheres.count; i += 4) {
+		__m256d px = _mm256_sub_pd(ox, _mm256_load_pd(spheres.x + i));
+		__m256d pz = _mm256_sub_pd(oz, _mm256_load_pd(spheres.z + i));
+		__m256d b = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(px, dx), yd), _mm256_mul_pd(pz, dz));
+		__m256d c = _mm256_sub_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(px, px), yy), _mm256_mul_pd(pz, pz)), _mm256_load_pd(spheres.r2 + i));
+		__m256d q = _mm256_sub_pd(_mm256_mul_pd(b, b), c);
+		__m256d s = _mm256_sub_pd(_mm256_sub_pd(zero, b), _mm256_sqrt_pd(_mm256_max_pd(q, zero)));
+		__m256d hit = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(q, zero, _CMP_GT_OQ), _mm256_cmp_pd(s, best_t, _CMP_LT_OQ)), _mm256_cmp_pd(s, eps, _CMP_GT_OQ));
+		best_t = _mm256_blendv_pd(best_t, s, hit);
+		best_i = _mm256_blendv_pd(best_i, idx, hit);
+		idx = _mm256_add_pd(idx, step);
+	}
+	alignas(32) double lane_t[4], lane_i[4];
+	_mm256_store_pd(lane_t, best_t);
+	_mm256_store_pd(lane_i, best_i);
+	return hit_reduce(lane_t, lane_i, 4, t);
+}
+
+#ifdef _MSC_VER
+static bool cpu_sse2() {
+	int r[4];
+	__cpuid(r, 1);
+	return (r[3] & (1 << 26)) != 0;
+}
+
+static bool cpu_avx() {
+	int r[4];
+	__cpuid(r, 1);
+	if ((r[2] & (1 << 27)) == 0 || (r[2] & (1 << 28)) == 0) return false; // OSXSAVE, AVX
+	return (_xgetbv(0) & 6) == 6; // Сохранение регистров AVX включено в ОС
+}
+#else
+static bool cpu_sse2() {
+	return __builtin_cpu_supports("sse2") != 0;
+}
+
+static bool cpu_avx() {
+	return __builtin_cpu_supports("avx") != 0;
+}
+#endif
+#endif // RT_X86
+
+typedef int (*hit_func_t)(const Vector& o, const Vector& d, double& t);
+hit_func_t hit_spheres = hit_scalar; // Используемый вариант поиска
+
+// Выбор варианта поиска: name == NULL - лучший из доступных, иначе "scalar", "sse2", "avx"
+const char* hit_select(const char* name) {
+	spheres_init();
+	hit_spheres = hit_scalar;
+	const char* ret = "scalar";
+#ifdef RT_X86
+	bool any = (name == NULL);
+	if ((any || strcmp(name, "sse2") == 0) && cpu_sse2()) {
+		hit_spheres = hit_sse2;
+		ret = "sse2";
+	}
+	if ((any || strcmp(name, "avx") == 0) && cpu_avx()) {
+		hit_spheres = hit_avx;
+		ret = "avx";
+	}
+#endif
+	return ret;
+}
+
+int tracer(Vector o, Vector d, double &t, Vector& n) {
+	t = 1e9;
+	int m = 0;
+	double p = -o.z / d.z;
+	if (.01 < p) {
+		t = p;
+		n = Vector(0, 0, 1);
+		m = 1;
+	}
+	int i = hit_spheres(o, d, t);
+	if (i >= 0) {
+		n = !(Vector(o.x - spheres.x[i], o.y, o.z - spheres.z[i]) + d * t);
+		m = 2;
+	}
+	return m;
+}
+
+Vector sampler(Vector o, Vector d) {
+	double t;
+	Vector n;
+	int m = tracer(o, d, t, n);
+	if (!m) {
+		return Vector(.7, .6, 1) * pow(1 - d.z, 4);
+	}
+	Vector h = o + d * t;
+	Vector l = !(Vector(9 + Random(), 9 + Random(), 16) + h * -1);
+	Vector r = d + n * (n % d * -2);
+	double b = l % n;
+	if (b < 0 || tracer(h, l, t, n)) {
+		b = 0;
+	}
+	double p = pow(l % r * (b > 0), 99);
+	if (m & 1) {
+		h = h * .2;
+		return ((int)(ceil(h.x) + ceil(h.y)) & 1 ? Vector(3, 1, 1) : Vector(3, 3, 3)) * (b * .2 + .1);
+	}
+	return Vector(p, p, p) + sampler(h, r) * .5;
+}
+
+//----------------------------------------------------------------------
+// Исходный вариант без акторов
+void original() {
+	FILE *out = fopen(FILE_NAME, "w");
+	assert(out != NULL);
+	fprintf(out, "P6 %d %d 255 ", WIDTH, HEIGHT);
+	Vector g = !Vector(-6, -16, 0);
+	Vector a = !(Vector(0, 0, 1) ^ g) * .002;
+	Vector b = !(g ^ a) * .002;
+	Vector c = (a + b) * -256 + g;
+	for (int y = HEIGHT; y--;) {
+		for (int x = WIDTH; x--;) {
+			random_seed(x, y);
+			Vector p(13, 13, 13);
+			for (int r = 64; r--;) {
+				Vector t = a * (Random() - .5) * 99 + b * (Random() - .5) * 99;
+				p = sampler(Vector(17, 16, 8) + t, !(t * -1 + (a * (Random() + x) + b * (y + Random()) + c) * 16)) * 3.5 + p;
+			}
+			p.print(out);
+		}
+	}
+	fclose(out);
+}
+
+//----------------------------------------------------------------------
+//Вариант с акторами
+struct msg_t : public lite_msg_t {
+	size_t idx;
+	int x;
+	int y;
+	Vector result;
+};
+
+// Писатель (однопоточный)
+class writer_t : public lite_actor_t {
+	FILE *out;
+public:
+	writer_t() {
+		type_add(lite_msg_type<msg_t>()); // Разрешение принимать сообщение типа msg_t
+		out = fopen(FILE_NAME, "w");
+		assert(out != NULL);
+		fprintf(out, "P6 %d %d 255 ", WIDTH, HEIGHT);
+	}
+
+	~writer_t() {
+		fclose(out);
+	}
+
+	// Обработка сообщения
+	void recv(lite_msg_t* msg) override {
+		msg_t* m = static_cast<msg_t*>(msg);
+		assert(m != NULL);
+		m->result.print(out);
+	}
+};
+
+
+// Считатель (потокобезопасный)
+class worker_t : public lite_actor_t {
+	Vector g = !Vector(-6, -16, 0);
+	Vector a = !(Vector(0, 0, 1) ^ g) * .002;
+	Vector b = !(g ^ a) * .002;
+	Vector c = (a + b) * -256 + g;
+	lite_actor_t* order; // Упорядочиватель
+
+public:
+	worker_t() {
+		order = lite_actor_get("order"); // Получение упорядочивателя по имени
+		assert(order != NULL);
+		type_add(lite_msg_type<msg_t>()); // Разрешение принимать сообщение типа msg_t
+	}
+
+	// Расчет одного пикселя
+	void calc(int x, int y, Vector& p) {
+		random_seed(x, y);
+		p.init(13, 13, 13);
+		for (int r = 64; r--;) {
+			Vector t = a * (Random() - .5) * 99 + b * (Random() - .5) * 99;
+			p = sampler(Vector(17, 16, 8) + t, !(t * -1 + (a * (Random() + x) + b * (y + Random()) + c) * 16)) * 3.5 + p;
+		}
+	}
+
+	// Прием сообщения
+	void recv(lite_msg_t* msg) override {
+		msg_t* m = static_cast<msg_t*>(msg); // Указатель на содержимое
+		assert(m != NULL);
+		calc(m->x, m->y, m->result); // Расчет
+		order->run(msg); // Отправка
+	}
+
+};
+
+// Запуск расчета
+void actor_start(int threads, bool verbose) {
+	// Создание акторов
+	// Писатель
+	writer_t* writer = new writer_t;
+	writer->name_set("writer");
+
+	// Упорядочиватель (из lite_thread_util.h)
+	lite_order_t<msg_t>* order = new lite_order_t<msg_t>("writer");
+	order->name_set("order");
+
+	// Считатель 
+	worker_t* worker = new worker_t;
+	worker->name_set("worker");
+	worker->parallel_set(threads);
+
+	// Ограничение количества потоков
+	lite_thread_max(threads);
+
+	// Создание сообщений
+	size_t idx = 0; // номер сообщения
+	for (int y = HEIGHT; y--;) {
+		for (int x = WIDTH; x--;) {
+			// Создание сообщения
+			msg_t* msg = new msg_t;
+			// Заполнение
+			msg->idx = idx++;
+			msg->x = x;
+			msg->y = y;
+			// Отправка
+			worker->run(msg);
+		}
+	}
+
+	if (verbose) printf("Init end: %lld msec\n", lite_time_now());
+
+	lite_thread_end(); // Ожидание окончания расчета
+}
+
+int main(int argc, char **argv) {
+	if (argc > 1 && strcmp(argv[1], "--sweep") == 0) { // Замер масштабируемости, вывод CSV
+		int max = (argc > 2 ? atoi(argv[2]) : lite_processor_count());
+		int reps = (argc > 3 ? atoi(argv[3]) : 3);
+		hit_select(argc > 4 ? argv[4] : NULL);
+		lite_sweep(max, reps, [](int threads) {
+			actor_start(threads, false);
+			return WIDTH * HEIGHT; // Сообщение на каждый пиксель
+		});
+		return 0;
+	}
+
+	int threads = 0;
+	if (argc > 1) {
+		// Количество потоков
+		for (char* p = argv[1]; *p != 0 && *p >= '0' && *p <= '9'; p++) threads = threads * 10 + *p - '0';
+	} else {
+		threads = 4;
+	}
+	printf("compile %s %s\n", __DATE__, __TIME__);
+	printf("tracer: %s\n", hit_select(argc > 2 ? argv[2] : NULL)); // Вариант поиска пересечений
+	lite_time_now(); // Начало отсчета времени
+	if(threads == 0) { // Запуск оригинального кода
+		printf("original code ...\n");
+		original();
+	} else { // запуск кода на lite_thread
+		printf("lite_thread %d threads ...\n", threads);
+		actor_start(threads, true);
+	}
+	printf("Time: %lld msec\n", lite_time_now());
+	return 0;
 }
\ No newline at end of file
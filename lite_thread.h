@@ -1,1863 +1,6005 @@
-﻿#pragma once
-/* lite_thread.h
-
-Кросплатформенная библиотека на С++11 для легкого распараллеливания кода, в т.ч. потокоНЕбезопасного.
-
-Библиотека построена по Модели Акторов, т.е. общий алгоритм разбивается на акторы (код, атомарные
-части бизнес-логики) и акторы общаются между собой пересылкой сообщений друг-другу.
-
-Библиотека сама создает нужное количество потоков и запускает в них акторы.
-
-Библиотека гарантирует что актор не будет запущен одновременно в нескольких потоках, т.е. код актора
-не требует потокобезопасности. Но если актор потокобезопасный, то есть установка ограничения на
-количество одновременно работающих копий данного актора. Также есть ограничение доступа группы акторов
-к конкретному ресурсу (например для ограничения количества используемых потоков)
-
-
-ПРИМЕР ПРОСТЕЙШЕГО ИСПОЛЬЗОВАНИЯ -------------------------------------------------------------
-
-// Сообщение
-struct msg_t : public lite_msg_t {
-	uint32_t x;
-};
-
-// Актор (обработчик сообщения)
-class actor_t : public lite_actor_t {
-	void recv(lite_msg_t* m) override {
-		msg_t* msg = dynamic_cast<msg_t*>(m);
-		if(msg == NULL) ... // Сообщение имеет другой тип, обработка ошибки
-		работа с msg
-	}
-};
-
-void main() {
-	actor_t* actor = new actor_t();
-	msg_t* msg = new msg_t; // Создание сообщения
-	msg->x = 100500;
-	actor->run(msg); // Постановка в очередь на выполнение
-
-	lite_thread_end(); // Ожидание завершения работы
-}
-
-
-СООБЩЕНИЯ ------------------------------------------------------------------------------------
-
-Класс сообщения должен быть унаследован от lite_msg_t
-struct msg_t : public lite_msg_t {
-};
-
---- Создание сообщения.
-msg_t* msg = new msg_t;
-Сообщения удаляются библиотекой автоматически после обработки
-
---- Передача сообщения на обработку.
-actor->run(msg)
-
---- Копирование сообщения.
-T* lite_msg_copy(T* msg)
-При копировании сообщения полученного извне не использовать и не отправлять исходное, т.к. оно
-не копируется, а просто снимается с контроля автоудаления. 
-При копировании копии или явно созданного создается полноценная копия, т.е. можно использовать оба.
-В классе сообщения необходимо прописывать конструктор копирования.
-
---- Удаление сообщения.
-delete msg
-Полученные извне и отправленные сообщения удалять нельзя, т.к. сообщения удаляются автоматически после 
-обработки.
-Удалять необходимо только скопированные или созданные и не отправленные сообщения.
-
-
-ВАЖНО -----------------------------------------------------------------------------------------
-
-Сообщения НЕ иммутабельны, поэтому:
-- нельзя отправлять одно сообщение дважды;
-- нельзя читать/писать сообщение после отправки, т.к. оно может быть уже в обработке или удалено.
-
-Сообщение можно изменять и отправлять дальше.
-
-Гарантируется что одно сообщение в любой момент времени обрабатывается только в одном потоке.
-
-Гарантируется что каждый обработчик получит сообщения в том порядке, в котором они отправлены.
-
-
-АКТОР (обработчик сообщений) ------------------------------------------------------------------
-
-Объекты акторов хранятся библиотекой и удаляются по окончании работы. 
-Для поиска существующего актора ему можно присвоить имя.
-
-Все классы акторов должны наследоваться от класса lite_actor_t.
-В дочернем классе необходимо прописать только метод recv()
-
-class actor_t : public lite_actor_t {
-	void recv(lite_msg_t* msg) override {
-	}
-}
-
---- Создание объекта
-actor_t* actor = new actor_t;
-
---- Присвоение имени
-actor->name_set(const std::string& name);
-
---- Получение объекта по имени
-lite_actor_t* lite_actor_get(const std::string& name)
-
---- Удаление объекта
-lite_actor_destroy(lite_actor_t* la);
-
-Если перед удалением необходимо выполнить какие-то операции связанные с отправкой сообщений, то прописать 
-это в методе before_destroy()
-
-class actor_t : public lite_actor_t {
-	void before_destroy() override {
-	}
-}
-
-
-Доступные методы базового класса:
-
---- Регистрация типа обрабатываемого сообщения
-type_add(lite_msg_type<T>())
-Если зарегистрирован хоть один тип сообщения, то в метод recv() будут передаваться только зарегистрированные, 
-остальные будут игнорироваться с сообщением об ошибке.
-Если ни один тип не зарегистрирован, то на обработку проходят все входящие сообщения.
-
-
-РАСПАРЕЛЛЕЛИВАНИЕ АКТОРА --------------------------------------------------------------------
-
-Для акторов с потокобезопасным кодом (например актор без окружения, все необходимое для его
-работы содержится в сообщении) можно установить глубину распараллеливания, т.е. в скольки
-потоках актор может одновременно обрабатывать сообщения.
-
---- Установка глубины распараллеливания
-actor->parallel_set(int max_threads)
-
-
-ЗАПУСК ПО ТАЙМЕРУ ----------------------------------------------------------------------------
-
-actor->timer_set(int time_ms)
-
-Устанавливает период запуска с интервалом time_ms. Отсчет начинается с момента установки.
-При time_ms <= 0 отключение таймера.
-
-В дочернем классе необходимо прописать метод timer()
-class actor_t : public lite_actor_t {
-	void timer() override {
-	}
-}
-
-Вызов по таймеру имеет приоритет ниже чем обработка сообщений, поэтому происходит только при пустой 
-очереди сообщений актора. Если по каким-либо причинам был пропушен момент запуска и наступил следующий, 
-то запуск будет один раз.
-
-
-РЕСУРСЫ --------------------------------------------------------------------------------------
-
-Ресурс ограничивает сколько может быть запущено одновременно акторов привязанных к ресурсу.
-При старте создается ресурс по умолчанию и вновь создаваемые акторы привязываются к нему.
-Рекомендуется использовать ресурс по умолчанию для акторов нагружающих процессор. Соответственно 
-максимум этого ресурса - количество потоков, которое можно использовать.
-Для акторов не нагружающих процессор (например запрос к вэб-сервису и ожидание ответа) лучше 
-создать отдельный ресурс и привязать туда эти акторы.
-
---- Установка ресурса по умолчанию
-lite_thread_max(int max)
-
---- Создание ресурса
-lite_resource_t* lite_resource_create(const std::string& name, int max)
-
---- Привязка актора к ресурсу
-actor->resource_set(lite_resource_t* res)
-
-
-ВЕДЕНИЕ ЛОГА --------------------------------------------------------------------------------
-
---- Запись в лог
-lite_log(int error, const char* data, ...)
-К введенным данным добавляется дата-время и отправляется сообщением на актор с именем "log", где
-по умолчанию выводится в консоль.
-
-В случае если error != 0 в текст дописывается "Error" и номер ошибки. 
-Номера менее LITE_ERROR_USER используются библиотекой.
-
-При необходимости можно создать свой актор "log". Он должен быть зарегистрирован до первого 
-вызова lite_log(). Актор получает сообщения типа 
-struct lite_msg_log_t : public lite_msg_t {
-	std::string data;
-	int err_num;
-};
-
-
-ЗАВЕРШЕНИЕ РАБОТЫ --------------------------------------------------------------------------
-
---- Ожидание завершения работы всех акторов
-lite_thread_end()
-Ожидает когда будет полностью завершена работа, удаляет все потоки, акторы и т.д. Возвращает
-библиотеку в нулевое состояние. Можно вызывать многократно.
-
-
-ОСОБЕННОСТИ РАБОТЫ -------------------------------------------------------------------------
-
-Каждый актор имеет очередь входящих сообщений. Отправка сообщения актору это постановка его
-в очередь актора и пробуждение простаивающего потока для его обработки.
-
-Поток захвативший актор выполняет его в цикле до тех пор пока очередь сообщений актора не опустеет.
-
-При запуске актора происходит захват ресурса, к которому привязан актор, по окончании работы актора,
-ищется ожидающий выполнения актор привязанный к этому же ресурсу.
-
-При обработке последнего сообщения в очереди актора происходит перехват исходящего сообщения актору 
-с тем же ресурсом, чтобы по завершению работы с текущим актором в том же потоке запустить получателя.
-Другие потоки при этом не оповещаются, поэтому отправку сообщения лучше всего выносить в конец актора
-или после отправки принудительно разбудить свободный поток lite_thread_wake_up(). 
-
-Потоки создаются по мере необходимости. Когда все имеющиеся потоки заняты обрабокой акторов, то создается
-новый. Потоки нумеруются при создании, при простаивании приоритет пробуждения отдается потоку с меньшим 
-номером. Если поток с максимальным номером простаивает 1 секунду - он завершается.
-
-
-ОТЛАДКА -----------------------------------------------------------------------------------
-
---- Вывод lite_log() сразу в консоль
-#define LT_DEBUG_LOG
-Используется встроенный вывод в лог и отключается отложенный вывод, т.к. если происходит прерывание
-работы при отложенном выводе (например обращение к несуществующей памяти), то не все последние записи
-успевают записаться в лог.
-
---- Включение счетчиков статистики
-#define LT_STAT
-Выводятся по окончании lite_thread_end(). Назначение описано ниже в lite_thread_stat_t
-
---- Вывод в лог информации о состоянии потоков
-#define LT_DEBUG
-Рекомендуется использовать вместе с LT_DEBUG_LOG, т.к. используется lite_log(), иначе вывод вызывает
-дополнительное изменение состояния потоков.
-
---- Компиляция в DLL под WinXP (там проблемы с thread_local и static при явной загрузке)
-#define LT_XP_DLL
-
-*/
-
-#if defined(_WIN32) || defined(_WIN64)
-#define LT_WIN
-#include <windows.h>
-#else
-#include <unistd.h>
-#endif
-
-#define LT_VERSION "0.9.2" // Версия библиотеки
-
-#ifndef LT_RESOURCE_DEFAULT
-#define LT_RESOURCE_DEFAULT 32 // Предел ресурса по умолчанию
-#endif
-
-#define LITE_ERROR_NOT_IMPLEMENTED	1  // Не прописан обработчик актора
-#define LITE_ERROR_RESOURCE			2  // Актор использует другой ресурс
-#define LITE_ERROR_ACTOR_DOUBLE		3  // Попытка присвоить имя уже существующего актора
-#define LITE_ERROR_ACTOR_NAME		4  // Попытка смены имени актора
-#define LITE_ERROR_MSG_TYPE			5  // Сообщение необрабатываемого типа
-#define LITE_ERROR_USER				16 // Пользовательские коды ошибок начиная с LITE_ERROR_USER
-#ifdef LT_DEBUG
-#ifdef NDEBUG
-#undef NDEBUG
-#endif
-#endif
-
-#include <atomic>
-#include <vector>
-#include <queue>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <unordered_map>
-#include <map>
-#include <string>
-#include <assert.h>
-#include <time.h>
-#include <string.h>
-#include <stdarg.h>
-
-//----------------------------------------------------------------------------------
-//-------- ВЫРАВНИВАНИЕ В ПАМЯТИ ---------------------------------------------------
-//----------------------------------------------------------------------------------
-// Выделение памяти с выравниванием под кэшлинию (кратно 0x40)
-class lite_align64_t {
-public:
-	lite_align64_t() {}
-	lite_align64_t(int) {}
-
-	void *operator new(size_t size) {
-		void* p;
-#ifdef LT_WIN
-		p = _aligned_malloc(size, 0x40);
-#else
-		if (posix_memalign(&p, 0x40, size)) p = NULL;
-#endif
-		if (p == NULL) {
-			assert(p != NULL);
-			throw std::bad_alloc();
-		}
-		return p;
-	}
-
-	void operator delete(void *p) {
-#ifdef LT_WIN
-		_aligned_free(p);
-#else
-		free(p);
-#endif
-	}
-};
-
-//----------------------------------------------------------------------------------
-//------ ПЕРЕМЕННЫЕ ПОТОКА (для DLL под XP) ----------------------------------------
-//----------------------------------------------------------------------------------
-#ifdef LT_XP_DLL
-template <typename T>
-class lite_thread_info_t : public lite_align64_t {
-	static uint32_t tls_idx() noexcept {
-		static uint32_t x = TLS_OUT_OF_INDEXES;
-		if (x == TLS_OUT_OF_INDEXES) {
-			x = TlsAlloc();
-			assert(x != TLS_OUT_OF_INDEXES);
-		}
-		return x;
-	}
-public:
-	static T& tls_get() noexcept {
-		T* x = (T*)TlsGetValue(tls_idx());
-		if (x == NULL) {
-			x = new T();
-			memset(x, 0, sizeof(T));
-			TlsSetValue(tls_idx(), x);
-		}
-		return *x;
-	}
-
-	static void tls_free() noexcept {
-		T* x = (T*)TlsGetValue(tls_idx());
-		if (x != NULL) {
-			delete x;
-			TlsSetValue(tls_idx(), NULL);
-		}
-	}
-};
-
-template <typename T>
-class lite_static_info_t : public lite_align64_t {
-public:
-	static T& si() noexcept {
-		static T* x;
-		if(x == NULL) {
-			x = new T();
-		}
-		return *x;
-	}
-};
-#else
-template <typename T>
-class lite_thread_info_t {
-
-public:
-	static T& tls_get() noexcept {
-		thread_local T x;
-		return x;
-	}
-
-	static void tls_free() noexcept {
-	}
-};
-
-template <typename T>
-class lite_static_info_t {
-public:
-	static T& si() noexcept {
-		static T x;
-		return x;
-	}
-};
-#endif
-
-#ifdef LT_STAT
-//----------------------------------------------------------------------------------
-//------ СЧЕТЧИКИ СТАТИСТИКИ -------------------------------------------------------
-//----------------------------------------------------------------------------------
-static int64_t lite_time_now();
-
-class lite_thread_stat_t : public lite_thread_info_t<lite_thread_stat_t>, public lite_static_info_t<lite_thread_stat_t> {
-
-public:
-	size_t stat_thread_max;			// Максимальное количество потоков запущенных одновременно
-	size_t stat_parallel_run;		// Максимальное количество потоков работавших одновременно
-	size_t stat_thread_create;		// Создано потоков
-	size_t stat_thread_wake_up;		// Сколько раз будились потоки
-	size_t stat_try_wake_up;		// Попыток разбудить поток
-	size_t stat_msg_create;			// Создано сообщений
-	size_t stat_msg_erase;			// Удалено сообщений
-	size_t stat_actor_create;		// Создано акторов
-	size_t stat_actor_erase;		// Удалено акторов
-	size_t stat_actor_get;			// Запросов lite_actor_t* по (func, env)
-	size_t stat_actor_find;			// Поиск очередного актора готового к работе
-	size_t stat_actor_not_run;		// Промахи обработки сообщения, уже обрабатывается другим потоком
-	size_t stat_cache_found;		// Найдено в глобальном кэше
-	size_t stat_cache_bad;			// Извлечение из кэша неготового актора
-	size_t stat_cache_full;			// Попытка записи в полный кэш
-	size_t stat_res_lock;			// Количество блокировок ресурсов
-	size_t stat_queue_max;			// Максимальная глубина очереди
-	size_t stat_msg_send;			// Обработано сообщений
-
-	//---------------------------------------------------------------------
-	// Счетчики потока
-	static lite_thread_stat_t& ti() noexcept {
-		return tls_get();
-	}
-
-	// Сигнал о зачершении потока
-	static void thread_end() noexcept {
-		tls_free();
-	}
-
-	//---------------------------------------------------------------------
-	lite_thread_stat_t() {
-		init();
-		lite_time_now(); // Запуск отсчета времени
-	}
-
-	~lite_thread_stat_t() {
-		store();
-	}
-
-	// Сброс в 0
-	void init() {
-		memset(this, 0, sizeof(lite_thread_stat_t));
-	}
-
-	// Сохранение счетчиков потока в глобальные
-	void store() {
-		static std::mutex mtx;
-		std::unique_lock<std::mutex> lck(mtx); // Блокировка
-		if(si().stat_thread_max < stat_thread_max) si().stat_thread_max = stat_thread_max;
-		if(si().stat_parallel_run < stat_parallel_run) si().stat_parallel_run = stat_parallel_run;
-		si().stat_thread_create += stat_thread_create;
-		si().stat_thread_wake_up += stat_thread_wake_up;
-		si().stat_try_wake_up += stat_try_wake_up;
-		si().stat_msg_create += stat_msg_create;
-		si().stat_msg_erase += stat_msg_erase;
-		si().stat_actor_create += stat_actor_create;
-		si().stat_actor_erase += stat_actor_erase;
-		si().stat_actor_get += stat_actor_get;
-		si().stat_actor_find += stat_actor_find;
-		si().stat_cache_found += stat_cache_found;
-		si().stat_cache_bad += stat_cache_bad;
-		si().stat_cache_full += stat_cache_full;
-		si().stat_res_lock += stat_res_lock;
-		si().stat_actor_not_run += stat_actor_not_run;
-		if(si().stat_queue_max < stat_queue_max) si().stat_queue_max = stat_queue_max;
-		si().stat_msg_send += stat_msg_send;
-		init();
-	}
-
-	void print_stat() {
-		store();
-		printf("\n------- STAT -------\n");
-		printf("thread_max     %llu\n", (uint64_t)si().stat_thread_max);
-		printf("parallel_run   %llu\n", (uint64_t)si().stat_parallel_run);
-		printf("thread_create  %llu\n", (uint64_t)si().stat_thread_create);
-		printf("thread_wake_up %llu\n", (uint64_t)si().stat_thread_wake_up);
-		printf("try_wake_up    %llu\n", (uint64_t)si().stat_try_wake_up);
-		printf("msg_create     %llu\n", (uint64_t)si().stat_msg_create);
-		printf("actor_create   %llu\n", (uint64_t)si().stat_actor_create);
-		printf("actor_get      %llu\n", (uint64_t)si().stat_actor_get);
-		printf("actor_find     %llu\n", (uint64_t)si().stat_actor_find);
-		printf("actor_not_run  %llu\n", (uint64_t)si().stat_actor_not_run);
-		printf("cache_found    %llu\n", (uint64_t)si().stat_cache_found);
-		printf("cache_bad      %llu\n", (uint64_t)si().stat_cache_bad);
-		printf("cache_full     %llu\n", (uint64_t)si().stat_cache_full);
-		printf("resource_lock  %llu\n", (uint64_t)si().stat_res_lock);
-		#ifdef LT_STAT_QUEUE
-		printf("queue_max      %llu\n", (uint64_t)si().stat_queue_max);
-		#endif
-		printf("msg_send       %llu\n", (uint64_t)si().stat_msg_send);
-		int64_t time_ms = lite_time_now();
-		printf("msg_send/sec   %llu\n", (uint64_t)si().stat_msg_send * 1000 / (time_ms > 0 ? time_ms : 1)); // Сообщений в секунду
-		printf("\n");
-		if (si().stat_msg_create != si().stat_msg_erase) printf("!!! ERROR: lost %lld messages (erase %lld)\n\n", (int64_t)si().stat_msg_create - si().stat_msg_erase, (int64_t)si().stat_msg_erase); // Утечка памяти
-		if (si().stat_actor_create != si().stat_actor_erase) printf("!!! ERROR: lost %lld actors (erase %lld)\n\n", (int64_t)si().stat_actor_create - si().stat_actor_erase, (int64_t)si().stat_actor_erase); // Утечка памяти
-	}
-};
-
-#endif
-
-//----------------------------------------------------------------------------------
-//------ БЛОКИРОВКИ ----------------------------------------------------------------
-//----------------------------------------------------------------------------------
-#define LOCK_TYPE_LT "spinlock + Sleep(0)"
-
-class lite_mutex_t {
-	std::atomic_flag af = ATOMIC_FLAG_INIT;
-
-public:
-	void lock() noexcept {
-		while (af.test_and_set(std::memory_order_acquire)) {
-#if defined LT_WIN
-			Sleep(0);
-#else
-			usleep(20);
-#endif
-		}
-
-	}
-
-	void unlock() noexcept {
-		af.clear(std::memory_order_release);
-	}
-}; 
-
-
-class lite_lock_t {
-	lite_mutex_t* mtx;
-public:
-	lite_lock_t(lite_mutex_t& mtx) noexcept {
-		this->mtx = &mtx;
-		this->mtx->lock();
-	}
-
-	~lite_lock_t() noexcept {
-		this->mtx->unlock();
-	}
-};
-
-// Время с момента запуска, мсек
-static int64_t lite_time_now() {
-	static std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
-	std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
-	std::chrono::duration<double> time_span = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t);
-	return (int64_t)(time_span.count() * 1000);
-}
-
-//----------------------------------------------------------------------------------
-//----------------------------------------------------------------------------------
-//----------------------------------------------------------------------------------
-class lite_actor_t;
-class lite_thread_t;
-class lite_msg_queue_t;
-class lite_timer_t;
-
-static void lite_log(int err, const char* data, ...) noexcept;
-static size_t lite_thread_num() noexcept;
-static void lite_thread_wake_up() noexcept;
-static void lite_timer_run(lite_actor_t* actor, int time_ms) noexcept;
-
-//----------------------------------------------------------------------------------
-//-------- СООБЩЕНИE ---------------------------------------------------------------
-//----------------------------------------------------------------------------------
-struct lite_msg_t : public lite_align64_t {
-public:
-	size_t type = {0};		// Тип сообщения
-
-	friend lite_msg_queue_t;
-protected:
-	lite_msg_t* next = {0};	// Указатель на следующее сообщение в очереди
-
-public:
-
-	lite_msg_t() {}
-
-	lite_msg_t(const lite_msg_t& m) {
-		type = m.type;
-	}
-
-	virtual ~lite_msg_t(){};
-
-	void *operator new(size_t size) {
-		#ifdef LT_STAT
-		lite_thread_stat_t::ti().stat_msg_create++;
-		#endif
-		return lite_align64_t::operator new(size);
-	}
-
-	void operator delete(void *p) {
-		#ifdef LT_STAT
-		lite_thread_stat_t::ti().stat_msg_erase++;
-		#endif
-		lite_align64_t::operator delete(p);
-	}
-
-	// Установка типа сообщения по классу
-	template <typename T>
-	static void type_set(T* msg) {
-		if(msg->type == 0) msg->type = typeid(T).hash_code();
-	}
-
-private:
-	// static переменные глобальные ----------------------------------------------------
-	typedef std::unordered_map<size_t, std::string> type_name_idx_t;
-
-	struct static_info_t : public lite_static_info_t<static_info_t> {
-		type_name_idx_t tn_idx; // Список типов
-		lite_mutex_t mtx;		// Блокировка для доступа к tn_idx
-	};
-
-	static static_info_t& si() noexcept {
-		return static_info_t::si();
-	}
-
-public:
-	// Вывод типа сообщения
-	template <typename T>
-	static size_t type_get() noexcept {
-		size_t hash = typeid(T).hash_code();
-		lite_lock_t lck(si().mtx); // Блокировка
-		// Сохранение названия типа
-		if (si().tn_idx.find(hash) == si().tn_idx.end()) {
-			si().tn_idx[hash] = typeid(T).name();
-		}
-		return hash;
-	}
-
-	// Тип сообщения строкой
-	const std::string type_descr() {
-		lite_lock_t lck(si().mtx); // Блокировка
-		type_name_idx_t::iterator it = si().tn_idx.find(type);
-		if (it == si().tn_idx.end()) {
-			std::string t = "type#";
-			t += std::to_string(type);
-			return t;
-		} else {
-			return it->second;
-		}
-	}
-};
-
-//----------------------------------------------------------------------------------
-//-------- ОЧЕРЕДЬ СООБЩЕНИЙ -------------------------------------------------------
-//----------------------------------------------------------------------------------
-
-class lite_msg_queue_t {
-	lite_msg_t* msg_first;			// Указатель на первое в очереди
-	lite_msg_t* msg_first2;			// Указатель на первое в очереди, меняется только под блокировкой
-	lite_msg_t* msg_last;			// Указатель на последнее в очереди
-	lite_mutex_t mtx;				// Синхронизация доступа
-	#ifdef LT_STAT_QUEUE
-	std::atomic<size_t> size;		// Размер очереди
-	#endif
-
-public:
-	lite_msg_queue_t() : msg_first(NULL), msg_first2(NULL), msg_last(NULL) {
-		#ifdef LT_STAT_QUEUE
-		size = 0;
-		#endif
-	}
-
-	// Добавление сообщения в очередь
-	void push(lite_msg_t* msg) noexcept {
-		msg->next = NULL;
-		lite_lock_t lck(mtx); // Блокировка
-		if(msg_last == NULL) {
-			msg_first2 = msg;
-			msg_last = msg;
-		} else {
-			msg_last->next = msg;
-			msg_last = msg;
-		}
-		#ifdef LT_STAT_QUEUE
-		size++;
-		if (lite_thread_stat_t::ti().stat_queue_max < size) lite_thread_stat_t::ti().stat_queue_max = size;
-		#endif
-	}
-
-	// Чтение сообщения из очереди. lock = false без блокировки использовать msg_first
-	lite_msg_t* pop(bool lock = true) noexcept {
-		if (lock) {
-			mtx.lock(); // Блокировка
-		}
-		if (msg_first == NULL) {
-			if (!lock) {
-				mtx.lock(); // Блокировка для доступа к msg_first2
-				lock = true;
-			}
-			msg_first = msg_first2;
-			msg_first2 = NULL;
-		}
-		lite_msg_t* msg = msg_first;
-
-		if(msg != NULL) {
-			msg_first = msg->next; // Чтение без блокировки
-			if (msg_first == NULL) {
-				if(!lock) {
-					mtx.lock(); // Блокировка для доступа к msg_last
-					lock = true;
-				}
-				msg_first = msg->next; // Повторное чтение под блокировкой на случай если был push
-				if(msg_first == NULL) msg_last = NULL;
-			}
-		}
-		if (lock) mtx.unlock(); // Снятие блокировки
-
-		#ifdef LT_DEBUG
-		if(msg != NULL) msg->next = NULL;
-		#endif
-		#ifdef LT_STAT_QUEUE
-		if (msg != NULL) size--;
-		#endif
-		return msg;
-	}
-
-	int empty() noexcept {
-		return msg_last == NULL;
-	}
-};
-
-//----------------------------------------------------------------------------------
-//------ КЭШ АКТОРОВ ГОТОВЫХ К ВЫПОЛНЕНИЮ ------------------------------------------
-//----------------------------------------------------------------------------------
-class lite_actor_cache_t {
-	std::atomic<lite_actor_t*> next = {0};
-
-public:
-	// Запись в кэш
-	void push(lite_actor_t* la) noexcept {
-		if(next == (lite_actor_t*)NULL) {
-			lite_actor_t* nul = NULL;
-			if (next.compare_exchange_weak(nul, la)) return;
-		}
-		#ifdef LT_STAT
-		lite_thread_stat_t::ti().stat_cache_full++;
-		#endif	
-	}
-
-	// Извлечение из кэша
-	lite_actor_t* pop() noexcept {
-		if(next == (lite_actor_t*)NULL) return NULL;
-		return next.exchange(NULL);
-	}
-};
-
-//----------------------------------------------------------------------------------
-//------ РЕСУРС --------------------------------------------------------------------
-//----------------------------------------------------------------------------------
-class lite_resource_manage_t;
-
-class lite_resource_t : public lite_align64_t {
-	std::atomic<int> res_free;	// Свободное количество
-	int res_max;				// Максимум
-
-friend lite_resource_manage_t;
-private:
-	std::string name;			// Название ресурса
-
-public:
-	lite_actor_cache_t la_cache;
-
-	lite_resource_t() {
-		res_free = LT_RESOURCE_DEFAULT;
-		res_max = LT_RESOURCE_DEFAULT;
-	}
-
-	lite_resource_t(int max) : res_free(max), res_max(max) {
-	}
-	
-	~lite_resource_t() noexcept {
-		assert(res_free == res_max);
-	}
-
-	// Захват ресурса, возвращает true при успехе
-	bool lock() noexcept {
-		#ifdef LT_STAT
-		lite_thread_stat_t::ti().stat_res_lock++;
-		#endif
-		if(res_free-- <= 0) {
-			res_free++;
-			return false;
-		} else {
-			return true;
-		}
-	}
-
-	// Освобождение ресурса
-	void unlock() noexcept {
-		res_free++;
-	}
-
-	// Количество свободных ресурсов
-	bool is_free() noexcept {
-		return res_free > 0;
-	}
-
-	// Установка максимума одновременно выполняющихся акторов
-	void max_set(int max) noexcept {
-		if (max <= 0) max = 1;
-		if (max == res_max) return;
-
-		res_free += max - res_max;
-		res_max = max;
-	}
-
-	// Получение имени
-	const std::string name_get() {
-		return name;
-	}
-};
-
-// Управление ресурсами
-class lite_resource_manage_t {
-	// static методы глобальные ----------------------------------------------------
-	typedef std::unordered_map<std::string, lite_resource_t*> lite_resource_list_t;
-
-	struct static_info_t : public lite_static_info_t<static_info_t> {
-		lite_resource_list_t lr_idx; // Индекс списка ресурсов
-		lite_mutex_t mtx;			// Блокировка для доступа к lr_idx
-	};
-
-	static static_info_t& si() noexcept {
-		return static_info_t::si();
-	}
-
-public:
-	// Создание нового ресурса. max емкость ресурса, при получении указателя на имеющийся можно не указывать
-	static lite_resource_t* get(const std::string& name, int max = 0) {
-		lite_lock_t lck(si().mtx);
-		lite_resource_list_t::iterator it = si().lr_idx.find(name); // Поиск по индексу
-		lite_resource_t* lr = NULL;
-		if (it != si().lr_idx.end()) {
-			lr = it->second;
-			if (max != 0) assert(lr->res_max == max);
-		} else {
-			assert(max != 0);
-			lr = new lite_resource_t(max);
-			lr->name = name;
-			si().lr_idx[name] = lr;
-		}
-		return lr;
-	}
-
-	// Очистка памяти
-	static void clear() noexcept {
-		lite_lock_t lck(si().mtx);
-		for (auto& it : si().lr_idx) {
-			delete it.second;
-		}
-		si().lr_idx.clear();
-	}
-};
-
-//----------------------------------------------------------------------------------
-//------ ОБРАБОТЧИК (АКТОР) --------------------------------------------------------
-//----------------------------------------------------------------------------------
-// Актор (обработчик + очередь сообщений)
-class lite_actor_t : public lite_align64_t {
-
-	lite_resource_t* resource;			// Ресурс, используемый актором
-	lite_msg_queue_t msg_queue;			// Очередь сообщений
-	std::atomic<int> actor_free;		// Количество свободных акторов, т.е. сколько можно запускать
-	std::atomic<int> thread_max;		// Количество потоков, в скольки можно одновременно выполнять
-	bool in_cache;						// Помещен в кэш планирования запуска
-	bool timer_run;						// Требуется запуск обработки сигнала таймера
-	std::string name;					// Наименование актора
-
-	std::vector<size_t> type_list;		// Список обрабатываемых типов
-
-	friend lite_thread_t;
-protected:
-	//---------------------------------
-	// Конструктор
-	lite_actor_t() : actor_free(1), thread_max(1), in_cache(false), timer_run(false) {
-		if(si().res_default == NULL) {
-			si().res_default = lite_resource_manage_t::get("CPU", LT_RESOURCE_DEFAULT);
-		}
-		resource = si().res_default;
-		list_add(this);
-	}
-
-	// Проверка готовности к запуску
-	bool is_ready() noexcept {
-		return ((!msg_queue.empty() || timer_run) && actor_free > 0 && (resource == NULL || resource == ti().lr_now_used || resource->is_free()));
-	}
-
-	// Постановка сообщения в очередь
-	void push(lite_msg_t* msg) noexcept {
-
-		msg_queue.push(msg);
-
-		if (msg == ti().msg_del) {
-			// Помеченное на удаление сообщение поместили в очередь другого актора. Снятие пометки
-			ti().msg_del = NULL;
-		}
-
-		cache_push(this);
-	}
-
-	// Запуск обработки всех сообщений очереди
-	void run_all() noexcept {
-		int free_now = --actor_free;
-		if (free_now < 0) {
-			// Уже выполняется разрешенное количество акторов
-			#ifdef LT_STAT
-			lite_thread_stat_t::ti().stat_actor_not_run++;
-			#endif
-		} else if (resource_lock(resource)) { // Занимаем ресурс
-			thread_info_t& t = ti();
-			t.la_next_run = NULL;
-			t.la_now_run = this;
-			bool need_lock = (thread_max != 1); // Блокировка нужна только многопоточным акторам
-			while (true) {
-				// Извлечение сообщения из очереди
-				lite_msg_t* msg = msg_queue.pop(need_lock);
-				if (msg == NULL) break;
-				// Запуск функции
-				t.msg_del = msg; // Пометка на удаление
-				recv(msg); // Обработка
-				if (msg == t.msg_del) delete msg;
-				#ifdef LT_STAT
-				lite_thread_stat_t::ti().stat_msg_send++;
-				#endif
-			}
-			if(timer_run) {
-				timer_run = false;
-				timer();
-			}
-			in_cache = false;
-		}
-		actor_free++;
-		return;
-	}
-
-public:
-	// Установка имени актора
-	void name_set(const std::string& name_) {
-		name_set(this, name_);
-	}
-
-	// Получение имени актора
-	const std::string name_get() {
-		if(!name.empty()) {
-			return name;
-		} else {
-			std::string n = "actor#";
-			n += std::to_string((size_t)this);
-			return n;
-		}
-	}
-
-
-	// Привязка к ресурсу
-	void resource_set(lite_resource_t* res) noexcept {
-		assert(res != NULL);
-		if (resource != si().res_default) {
-			lite_log(LITE_ERROR_RESOURCE, "Actor %s already used resource '%s'", name_get().c_str(), res->name_get().c_str());
-		}
-		else {
-			resource = res;
-		}
-	}
-
-	// Установка глубины распараллеливания
-	void parallel_set(int count) noexcept {
-		if (count <= 0) count = 1;
-		if (count == thread_max) return;
-
-		actor_free += count - thread_max.exchange(count);
-	}
-
-	// Проверка типа сообщения
-	bool check_type(lite_msg_t* msg) noexcept {
-		if (!type_list.empty()) {
-			// Проверка что тип сообщения в обрабатываемых
-			bool found = false;
-			for (auto& t : type_list) {
-				if (msg->type == t) {
-					found = true;
-					break;
-				}
-			}
-			if (!found) {
-				lite_log(LITE_ERROR_MSG_TYPE, "'%s' recv '%s'", name_get().c_str(), msg->type_descr().c_str());
-				return false;
-			}
-		}
-		return true;
-	}
-
-	// Помещение в очередь для последующего запуска
-	template <typename T>
-	void run(T* msg) noexcept {
-		lite_msg_t::type_set(msg);
-		if(check_type(msg)) {
-			push(msg);
-		} else if (msg != ti().msg_del) {
-			delete msg;
-		}
-	}
-
-	// Добавление обрабатываемого типа
-	void type_add(size_t type) noexcept {
-		bool found = false;
-		for (auto& t : type_list) {
-			if (type == t) {
-				found = true;
-				break;
-			}
-		}
-		if (!found) type_list.push_back(type);
-	}
-
-	// Установка периода вызова timer()
-	void timer_set(int time_ms) noexcept {
-		lite_timer_run(this, time_ms);
-	}
-
-	// Вызов timer()
-	void timer_alert() noexcept {
-		if (!timer_run) {
-			timer_run = true;
-			cache_push(this);
-		}
-	}
-
-	#ifdef LT_STAT
-	void *operator new(size_t size) {
-		lite_thread_stat_t::ti().stat_actor_create++;
-		return lite_align64_t::operator new(size);
-	}
-
-	void operator delete(void *p) {
-		lite_thread_stat_t::ti().stat_actor_erase++;
-		lite_align64_t::operator delete(p);
-	}
-	#endif
-
-	//-----------------------------------------------------------------------------------
-	// Обработчик сообщения, прописывать в дочернем классе
-	virtual void recv(lite_msg_t*) = 0;
-
-	virtual void before_destroy() {
-	}
-
-	virtual void timer() {
-		lite_log(LITE_ERROR_NOT_IMPLEMENTED, "%s method timer() is not implemented.", name_get().c_str());
-	}
-
-	virtual ~lite_actor_t() {}
-
-private:
-	// static переменные уровня потока -------------------------------------------------
-	struct thread_info_t : public lite_thread_info_t<thread_info_t> {
-		lite_msg_t* msg_del;		// Обрабатываемое сообщение, будет удалено после обработки
-		lite_actor_t* la_next_run;	// Следующий на выполнение актор
-		lite_actor_t* la_now_run;	// Текущий актор
-		lite_resource_t* lr_now_used;// Текущий захваченный ресурс
-	};
-
-	static thread_info_t& ti() noexcept {
-		return thread_info_t::tls_get();
-	}
-
-	// static переменные глобальные ----------------------------------------------------
-	typedef std::unordered_map<std::string, lite_actor_t*> lite_name_idx_t;
-	typedef std::vector<lite_actor_t*> lite_actor_list_t;
-
-	struct static_info_t : public lite_static_info_t<static_info_t> {
-		lite_name_idx_t la_name_idx;// Индекс для поиска lite_actor_t* по имени
-		lite_mutex_t mtx_idx;		// Блокировка для доступа к la_idx. В случае одновременной блокировки сначала mtx_idx затем mtx_list
-		lite_actor_list_t la_list;	// Список акторов
-		lite_mutex_t mtx_list;		// Блокировка для доступа к la_list
-		lite_resource_t* res_default;// Ресурс по умолчанию
-		std::atomic<bool> is_destroy;// Идет удаление всех акторов
-	};
-
-	static static_info_t& si() noexcept {
-		return static_info_t::si();
-	}
-
-	// static методы глобальные ----------------------------------------------------
-	// Сохранение в кэш указателя на актор ожидающий исполнения
-	static void cache_push(lite_actor_t* la) noexcept {
-		assert(la != NULL);
-		if (!la->is_ready() || la->in_cache) return;
-
-		thread_info_t& t = ti();
-		if (t.la_now_run != NULL && t.la_now_run->msg_queue.empty() && t.la_next_run == NULL && t.lr_now_used == la->resource) {
-			// Выпоняется последнее задание текущего актора, запоминаем в локальный кэш потока для обработки его следующим
-			t.la_next_run = la;
-			return;
-		}
-
-		// Запись в кэш ресурса
-		la->resource->la_cache.push(la);
-
-		if(la->resource->is_free()) {
-			lite_thread_wake_up();
-		}
-	}
-
-	// Получение из кэша указателя на актор ожидающий исполнения
-	static lite_actor_t* cache_pop() noexcept {
-		thread_info_t& t = ti();
-		// Проверка локального кэша
-		lite_actor_t* la = t.la_next_run;
-		if (la != NULL) {
-			t.la_next_run = NULL;
-			if (la->is_ready()) {
-				return la;
-			} else {
-				#ifdef LT_STAT
-				lite_thread_stat_t::ti().stat_cache_bad++;
-				#endif			
-				la = NULL;
-			}
-		}
-
-		if(t.lr_now_used != NULL) {
-			// Проверка кэша используемого ресурса
-			while ((la = t.lr_now_used->la_cache.pop()) != NULL) {
-				if (la->is_ready()) {
-					return la;
-				}
-			}
-		}
-
-		return NULL;
-	}
-
-	// Поиск ожидающего выполнение
-	static lite_actor_t* find_ready() noexcept {
-		// Извлечение из кэша
-		lite_actor_t* ret = cache_pop();
-		if (ret != NULL) {
-			#ifdef LT_STAT
-			lite_thread_stat_t::ti().stat_cache_found++;
-			#endif
-			return ret;
-		}
-
-		// Поиск перебором списка акторов
-		#ifdef LT_STAT
-		lite_thread_stat_t::ti().stat_actor_find++;
-		#endif
-
-		lite_lock_t lck(si().mtx_list); // Блокировка
-		lite_actor_list_t& la_list = si().la_list;
-		for (lite_actor_list_t::iterator it = la_list.begin(); it != la_list.end(); ++it) {
-			if ((*it)->is_ready()) {
-				ret = (*it);
-				ret->in_cache = true;
-				if(it != si().la_list.begin()) {
-					// Сдвиг активных ближе к началу
-					lite_actor_list_t::iterator it2 = it;
-					--it2;
-					(*it) = (*it2);
-					(*it2) = ret;
-				}
-				break;
-			} 
-		}
-		return ret;
-	}
-
-	// Количество готовых к выполнению
-	static size_t count_ready() noexcept {
-		lite_lock_t lck(si().mtx_list); // Блокировка
-		size_t cnt = 0;
-		for (lite_actor_list_t::iterator it = si().la_list.begin(); it != si().la_list.end(); ++it) {
-			if ((*it)->is_ready()) {
-				cnt += (*it)->actor_free;
-			}
-		}
-		return cnt;
-	}
-
-	// Захват и освобождение ресурса
-	static bool resource_lock(lite_resource_t* res) {
-		// Проверка что уже захвачен
-		if (res == ti().lr_now_used) return true;
-		// Освобождение ранее захваченного
-		if (ti().lr_now_used != NULL) ti().lr_now_used->unlock();
-		ti().lr_now_used = NULL;
-		// Захват нового
-		if(res == NULL || res->lock()) {
-			ti().lr_now_used = res;
-			return true;
-		} else {
-			return false;
-		}
-	}
-
-	// Добавление в список акторов
-	static void list_add(lite_actor_t* la) noexcept {
-		lite_lock_t lck2(si().mtx_list); // Блокировка
-		si().la_list.push_back(la);
-	}
-
-	// Установка имени актора
-	static void name_set(lite_actor_t* la, const std::string& name) {
-		lite_lock_t lck(si().mtx_idx); // Блокировка
-		lite_name_idx_t::iterator it = si().la_name_idx.find(name); // Поиск по индексу
-		if (it != si().la_name_idx.end()) {
-			if(it->second != la) lite_log(LITE_ERROR_ACTOR_DOUBLE, "Actor '%s' already exists", name.c_str());
-		} else if(!la->name.empty()) {
-			lite_log(LITE_ERROR_ACTOR_NAME, "Try set name '%s' to actor '%s'", name.c_str(), la->name.c_str());
-		} else {
-			si().la_name_idx[name] = la;
-			la->name = name;
-		}
-	}
-
-	// Очистка всего
-	static void clear() noexcept {
-		si().is_destroy = true;
-		while (!si().la_list.empty()) {
-			lite_actor_t* la_del = NULL;
-			{
-				lite_lock_t lck(si().mtx_list); // Блокировка
-				if (si().la_list.back()->name == "log") { // "log" удаляется последним, т.к. могли быть записи в деструкторах
-					la_del = si().la_list[0];
-					si().la_list[0] = si().la_list.back();
-				}
-				else {
-					la_del = si().la_list.back();
-				}
-				si().la_list.pop_back();
-			}
-			if (la_del->name == "log") {
-				la_del->run_all();
-				resource_lock(NULL);
-			} else {
-				la_del->before_destroy();
-			}
-			if (!la_del->name.empty()) { // Удаление из индекса
-				lite_lock_t lck(si().mtx_idx); // Блокировка
-				lite_name_idx_t::iterator it = si().la_name_idx.find(la_del->name);
-				if (it != si().la_name_idx.end()) si().la_name_idx.erase(it);
-			}
-			delete la_del;
-		}
-
-		assert(si().la_name_idx.empty());
-
-		si().res_default = NULL;
-		si().is_destroy = false;
-	}
-
-public: //-------------------------------------------------------------
-
-	// Удаление одного актора
-	static void destroy(lite_actor_t *la_del) noexcept {
-		if (si().is_destroy) return; // Идет удаление всех
-
-		bool is_del = false;
-		// Удаление из списка
-		{
-			lite_lock_t lck(si().mtx_list); // Блокировка
-			for (auto & l : si().la_list) {
-				if (l == la_del) {
-					if (l != si().la_list.back()) { // Если не последний, то перенос в конец
-						l = si().la_list.back();
-					}
-					si().la_list.pop_back();
-					is_del = true;
-					break;
-				}
-			}
-		}
-		if (is_del && !la_del->name.empty()) { // Удаление из индекса
-			lite_lock_t lck(si().mtx_idx); // Блокировка
-			lite_name_idx_t::iterator it = si().la_name_idx.find(la_del->name);
-			if (it != si().la_name_idx.end()) si().la_name_idx.erase(it);
-		}
-		// Дообработка оставщихся сообщений
-		if (is_del) {
-			la_del->timer_set(0);
-			la_del->before_destroy();
-			while (!la_del->msg_queue.empty()) {
-				la_del->run_all();
-				if (!la_del->msg_queue.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(20)); 
-			}
-			assert(la_del->msg_queue.empty());
-			delete la_del;
-		}
-	}
-
-	// Получание актора по имени
-	static lite_actor_t* name_find(const std::string& name) {
-		lite_lock_t lck(si().mtx_idx); // Блокировка
-		lite_name_idx_t::iterator it = si().la_name_idx.find(name); // Поиск по индексу
-		lite_actor_t* la = NULL;
-		if (it != si().la_name_idx.end()) {
-			la = it->second;
-		}
-		return la;
-	}
-
-	// Копирование сообщения
-	template <typename T>
-	static T* msg_copy(T* msg) noexcept {
-		if (ti().msg_del == msg) {
-			ti().msg_del = NULL; // Снятие пометки на удаление
-			return msg;
-		} else {
-			T* msg2 = new T(*msg);
-			return msg2;
-		}
-	}
-
-	// Установка максимума ресурсу по умолчанию
-	static void resource_max(int max) noexcept {
-		si().res_default->max_set(max);
-	}
-
-	// Извещение о завершении потока
-	static void thread_end() {
-		thread_info_t::tls_free();
-	}
-};
-
-//-------------------------------------------------------------------------
-//---------------------- ТАЙМЕР -------------------------------------------
-//-------------------------------------------------------------------------
-// Вызов акторов по таймеру.
-
-class lite_timer_t {
-
-	struct task_t { // Задание
-		lite_actor_t* la;	// Актор
-		int step;			// Периодичность оповещения, мс
-	};
-	typedef std::multimap<int64_t, task_t> task_list_t; // Список заданий с сортировкой по времени срабатывания
-
-	task_list_t task_list;
-
-
-	std::thread thread;			// Поток ожидания
-
-	std::mutex mtx;				// Для засыпания
-	std::condition_variable cv;	// Для засыпания
-
-	// Функция потока
-	static void thread_func(lite_timer_t* const tmr) noexcept {
-		#ifdef LT_DEBUG
-		lite_log(0, "timer thread start");
-		#endif
-		std::unique_lock<std::mutex> lck(tmr->mtx);
-		while(!tmr->task_list.empty()) {
-			int64_t now = lite_time_now(), sleep_ms = 0;
-
-			while(true) { // Запуск тех, у кого время наступило
-				task_list_t::iterator it = tmr->task_list.begin();
-				if (it->first > now) {
-					now = lite_time_now();
-					if(it->first > now) {
-						sleep_ms = it->first - now + 1;
-						break;
-					}
-				}
-				it->second.la->timer_alert();
-				int64_t next = it->first + it->second.step;
-				while(next <= now) next += it->second.step;
-				tmr->task_list.insert(std::pair<int64_t, task_t>(next, it->second));
-				tmr->task_list.erase(it);
-			}
-
-			assert(sleep_ms > 0);
-			tmr->cv.wait_for(lck, std::chrono::milliseconds(sleep_ms)); // Ожидание времени следущей сработки
-		}
-		#ifdef LT_DEBUG
-		lite_log(0, "timer thread stop");
-		#endif	
-	}
-
-	// Поиск настроек актора
-	task_list_t::iterator find(lite_actor_t* la) noexcept {
-		task_list_t::iterator it = task_list.begin();
-		for(; it != task_list.end(); it++) {
-			if (it->second.la == la) break;
-		}
-		return it;
-	}
-
-public:
-	// Добавление таймера 
-	void set(lite_actor_t* la, int time_ms) noexcept {
-		std::unique_lock<std::mutex> lck(mtx); // Блокировка
-		bool start_thread = task_list.empty();
-		#ifdef LT_DEBUG
-		lite_log(0, "timer %d ms for %s start_thread = %d", time_ms, la->name_get().c_str(), start_thread);
-		#endif
-		// Удаление предыдущих настроек для la
-		task_list_t::iterator it = find(la);
-		if (it != task_list.end()) task_list.erase(it);
-
-		if (time_ms <= 0) {
-			cv.notify_all();
-			return; // Остановка таймера
-		}
-
-
-		task_t t;
-		t.la = la;
-		t.step = time_ms;
-		task_list.insert(std::pair<int64_t, task_t>(lite_time_now() + time_ms, t));
-
-		lck.unlock();
-		if(start_thread) { // Первое задание. Запуск потока.
-			if(thread.joinable()) {
-				cv.notify_all();
-				thread.join();
-			}
-			thread = std::thread(thread_func, this);
-		} else {
-			cv.notify_all();
-		}
-	}
-
-	// Остановка всех таймеров
-	void stop_all() {
-		std::unique_lock<std::mutex> lck(mtx); // Блокировка
-		task_list.clear();
-	}
-
-	// Завершение работы
-	~lite_timer_t() {
-		stop_all();
-		if (thread.joinable()) {
-			cv.notify_all();
-			thread.join();
-		}
-	}
-};
-
-//----------------------------------------------------------------------------------
-//----- ПОТОКИ ---------------------------------------------------------------------
-//----------------------------------------------------------------------------------
-
-class lite_thread_t : lite_align64_t {
-	size_t num;					// Номер потока
-	std::mutex mtx_sleep;		// Для засыпания
-	std::condition_variable cv;	// Для засыпания
-	bool is_free;				// Поток свободен
-	bool is_end;				// Поток завершен
-
-	// Конструктор
-	lite_thread_t(size_t num) : num(num), is_free(true), is_end(false) { }
-
-	// Общие данные всех потоков
-	struct static_info_t : public lite_static_info_t<static_info_t> {
-		std::atomic<lite_thread_t*> worker_free = {0}; // Указатель на свободный поток
-		std::vector<lite_thread_t*> worker_list;	// Массив описателей потоков
-		std::atomic<size_t> thread_count;			// Количество запущеных потоков
-		lite_mutex_t mtx;							// Блокировка доступа к массиву потоков
-		std::atomic<bool> stop = {0};				// Флаг остановки всех потоков
-		std::mutex mtx_end;							// Для ожидания завершения потоков
-		std::condition_variable cv_end;				// Для ожидания завершения потоков
-		lite_timer_t* timer = { 0 };				// Таймер вызова акторов по времени
-	};
-
-	static static_info_t& si() {
-		return static_info_t::si();
-	}
-
-	// Создание потока
-	static void create_thread() noexcept {
-		if (si().stop) return;
-		lite_thread_t* lt;
-		{
-			lite_lock_t lck(si().mtx); // Блокировка
-			size_t num = si().thread_count;
-			if (si().worker_list.size() == num) {
-				si().worker_list.push_back(NULL);
-			} else {
-				assert(num < si().worker_list.size());
-				assert(si().worker_list[num] != NULL);
-				assert(si().worker_list[num]->is_end);
-				delete si().worker_list[num];
-			}
-			lt = new lite_thread_t(num);
-			si().worker_list[num] = lt;
-			si().thread_count++;
-		}
-		std::thread th(thread_func, lt);
-		th.detach();
-
-		#ifdef LT_STAT
-		lite_thread_stat_t::ti().stat_thread_create++;
-		size_t cnt = si().thread_count;
-		if (lite_thread_stat_t::ti().stat_thread_max < cnt) lite_thread_stat_t::ti().stat_thread_max = cnt;
-		#endif
-	}
-
-	// Поиск свободного потока
-	static lite_thread_t* find_free() noexcept {
-		lite_thread_t* wf = si().worker_free;
-		if(wf != NULL && wf->is_free) return wf;
-
-		if (si().thread_count == 0) return NULL;
-		wf = NULL;
-		lite_lock_t lck(si().mtx); // Блокировка
-		size_t max = si().thread_count;
-		assert(max <= si().worker_list.size());
-
-		for (size_t i = 0; i < max; i++) {
-			lite_thread_t* w = si().worker_list[i];
-			assert(w != NULL);
-			if (w->is_free) {
-				wf = w;
-				break;
-			}
-		}
-
-		si().worker_free = wf;
-		return wf;
-	}
-
-	// Подсчет работающих потоков
-	static size_t thread_work() noexcept {
-		lite_lock_t lck(si().mtx); // Блокировка
-		size_t max = si().thread_count;
-		assert(max <= si().worker_list.size());
-
-		size_t ret = 0;
-		for (size_t i = 0; i < max; i++) {
-			if (!si().worker_list[i]->is_free) ret++;
-		}
-		#ifdef LT_STAT
-		if (lite_thread_stat_t::ti().stat_parallel_run < ret) lite_thread_stat_t::ti().stat_parallel_run = ret;
-		#endif		
-		return ret;
-	}
-
-	// Обработка сообщений
-	static void work_msg(lite_actor_t* la = NULL) noexcept {
-		if (la == NULL) la = lite_actor_t::find_ready();
-		while (la != NULL) {
-			la->run_all();
-			la = lite_actor_t::find_ready();
-		}
-		lite_actor_t::resource_lock(NULL);
-	}
-
-	// Функция потока
-	static void thread_func(lite_thread_t* const lt) noexcept {
-		#ifdef LT_DEBUG
-		lite_log(0, "thread#%d start", (int)lt->num);
-		#endif
-		this_num(lt->num);
-		// Пробуждение другого потока если ожидающих акторов больше одного
-		if(lite_actor_t::count_ready() > 1) {
-			lt->is_free = false;
-			wake_up();
-		}
-		// Цикл обработки сообщений
-		while(true) {
-			// Проверка необходимости и создание новых потоков
-			lite_actor_t* la = lite_actor_t::find_ready();
-			if(la != NULL) { // Есть что обрабатывать
-				lt->is_free = false;
-				// Обработка сообщений
-				work_msg(la);
-				lt->is_free = true;
-			}
-			if (si().stop) break;
-			// Уход в ожидание
-			bool stop = false;
-			{
-				#ifdef LT_DEBUG
-				lite_log(0, "thread#%d sleep at %lld ms", (int)lt->num, lite_time_now());
-				#endif
-				if(thread_work() == 0) si().cv_end.notify_one(); // Если никто не работает, то разбудить ожидание завершения
-				lite_thread_t* wf = si().worker_free;
-				while(wf == NULL || wf->num > lt->num) { // Следующим будить поток с меньшим номером
-					si().worker_free.compare_exchange_weak(wf, lt);
-				}
-				std::unique_lock<std::mutex> lck(lt->mtx_sleep);
-				lt->is_free = true;
-				if(lt->cv.wait_for(lck, std::chrono::seconds(1)) == std::cv_status::timeout) {	// Проснулся по таймауту
-					stop = (lt->num == si().thread_count - 1);	// Остановка потока с наибольшим номером
-					#ifdef LT_DEBUG
-					lite_log(0, "thread#%d wake up (total: %d, work: %d)", (int)lt->num, (int)si().thread_count, (int)thread_work());
-					#endif
-				} else {
-					#ifdef LT_DEBUG
-					lite_log(0, "thread#%d wake up", (int)lt->num);
-					#endif
-					#ifdef LT_STAT
-					lite_thread_stat_t::ti().stat_thread_wake_up++;
-					#endif
-				}
-				if (si().worker_free == lt) {
-					wf = lt;
-					si().worker_free.compare_exchange_weak(wf, NULL);
-				}
-			}
-			if (stop) {
-				lt->is_free = false;
-				break;
-			}
-		}
-		#ifdef LT_STAT
-		lite_thread_stat_t::ti().store(); // Сохранение счетчиков потока
-		#endif
-		lite_lock_t lck(si().mtx); // Блокировка
-		lt->is_end = true;
-		lt->is_free = false;
-		si().thread_count--;
-		si().cv_end.notify_one(); // пробуждение end()
-		#ifdef LT_DEBUG
-		lite_log(0, "thread#%d stop", (int)lt->num);
-		#endif
-		lite_actor_t::thread_end();
-		#ifdef LT_STAT
-		lite_thread_stat_t::thread_end();
-		#endif
-	}
-
-public: //-------------------------------------
-	// Пробуждение свободного потока
-	static void wake_up() noexcept {
-		lite_thread_t* wf = find_free();
-		if (wf != NULL) {
-			wf->cv.notify_one();
-			#ifdef LT_STAT
-			lite_thread_stat_t::ti().stat_try_wake_up++;
-			#endif
-		} else {
-			create_thread();
-		}
-	}
-
-	// Установка таймера для la
-	static void timer_set(lite_actor_t* la, int time_ms) noexcept {
-		if(si().timer == NULL) {
-			if (time_ms <= 0) return;
-			si().timer = new lite_timer_t;
-		}
-		si().timer->set(la, time_ms);
-	}
-
-	// Завершение, ожидание всех потоков
-	static void end() noexcept {
-		// Рассчет еще не начался
-		if(si().thread_count == 1 && thread_work() == 0) {
-			#ifdef LT_DEBUG
-			lite_log(0, "--- wait start ---");
-			#endif	
-			std::this_thread::sleep_for(std::chrono::milliseconds(100)); // для запуска потоков
-		}
-		#ifdef LT_DEBUG
-		lite_log(0, "--- wait all ---");
-		#endif	
-		// Ожидание завершения расчетов. 
-		while(thread_work() > 0) {
-			std::unique_lock<std::mutex> lck(si().mtx_end);
-			si().cv_end.wait_for(lck, std::chrono::milliseconds(300));
-		}
-		#ifdef LT_DEBUG
-		lite_log(0, "--- stop all ---");
-		#endif	
-		// Остановка таймеров
-		if (si().timer != NULL) {
-			delete si().timer;
-			si().timer = NULL;
-		}
-		// Остановка потоков
-		si().stop = true;
-		while(true) { // Ожидание остановки всех потоков
-			bool is_end = true;
-			{
-				lite_lock_t lck(si().mtx); // Блокировка
-				for (auto& w : si().worker_list) {
-					if(!w->is_end) { // Поток не завершился
-						w->cv.notify_one(); // Пробуждение потока
-						is_end = false;
-					}
-				}
-			}
-			if (is_end) {
-				break;
-			} else { // Ожидание пока какой-нибудь завершившийся поток не разбудит
-				std::unique_lock<std::mutex> lck(si().mtx_end);
-				si().cv_end.wait_for(lck, std::chrono::milliseconds(100));
-			}
-		}
-		// Завершены все потоки
-		assert(si().thread_count == 0);
-
-		// Очистка данных потоков
-		lite_lock_t lck(si().mtx); // Блокировка
-		for (auto& w : si().worker_list) {
-			assert(w != NULL);
-			delete w;
-			w = NULL;
-		}
-		si().worker_list.clear();
-		si().worker_free = NULL;
-		// Дообработка необработанных сообщений. 
-		work_msg();
-		// Удаление акторов
-		lite_actor_t::clear();
-		// Очистка памяти под ресурсы
-		lite_resource_manage_t::clear();
-		#ifdef LT_STAT
-		lite_thread_stat_t::ti().print_stat();
-		#endif		
-		lite_actor_t::thread_end();
-		#ifdef LT_STAT
-		lite_thread_stat_t::thread_end();
-		#endif		
-		#ifdef LT_DEBUG
-		printf("         !!! end !!!\n");
-		#endif
-		si().stop = false;
-
-	}
-
-	// Номер текущего потока
-	static size_t this_num(size_t num = 999) noexcept {
-		#ifdef LT_XP_DLL
-		num = GetCurrentThreadId();
-		return num;
-		#else
-		thread_local size_t n = 999;
-		if (num != 999) {
-			n = num;
-		}
-		return n;
-		#endif
-	}
-};
-
-//----------------------------------------------------------------------------------
-//----- ВЫВОД В ЛОГ ----------------------------------------------------------------
-//----------------------------------------------------------------------------------
-#ifndef LITE_LOG_BUF_SIZE
-#define LITE_LOG_BUF_SIZE 4096
-#endif
-
-// Сообщение
-struct lite_msg_log_t : public lite_msg_t {
-	lite_msg_log_t(int err, const char* str) : data(str), err_num(err) { }
-
-	std::string data;
-	int err_num;
-};
-
-// Вывод по умолчанию в консоль. При необходимости зарегистрировать свой актор "log"
-class lite_actor_log_t : public lite_actor_t {
-public:
-	void recv(lite_msg_t* msg) override { // Обработчик сообщения
-		lite_msg_log_t* m = dynamic_cast<lite_msg_log_t*>(msg);
-		assert(m != NULL);
-		printf("%s\n", m->data.c_str() + 9);
-	}
-};
-
-// Запись в лог
-static void lite_log(int err, const char* data, ...) noexcept {
-	va_list ap;
-	va_start(ap, data);
-	char buf[LITE_LOG_BUF_SIZE];
-
-	time_t rawtime;
-	time(&rawtime);
-
-	size_t size = 0;
-	char* p = buf;
-
-#ifdef WIN32
-	struct tm timeinfo;
-	localtime_s(&timeinfo, &rawtime);
-	if(err > 0) {
-		size += sprintf_s(p, LITE_LOG_BUF_SIZE - size, "%02d.%02d.%02d %02d:%02d:%02d !!! ERROR %d: ", timeinfo.tm_mday, timeinfo.tm_mon, timeinfo.tm_year % 100, timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec, err);
-	} else {
-		size += sprintf_s(p, LITE_LOG_BUF_SIZE - size, "%02d.%02d.%02d %02d:%02d:%02d ", timeinfo.tm_mday, timeinfo.tm_mon, timeinfo.tm_year % 100, timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-	}
-	p += size;
-	size += vsprintf_s(p, LITE_LOG_BUF_SIZE - size, data, ap);
-	p += size;
-#else
-	struct tm * timeinfo;
-	timeinfo = localtime(&rawtime);
-	if (err > 0) {
-		size += snprintf(p, LITE_LOG_BUF_SIZE - size, "%02d.%02d.%02d %02d:%02d:%02d !!! ERROR %d: ", timeinfo->tm_mday, timeinfo->tm_mon, timeinfo->tm_year % 100, timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, err);
-	} else {
-		size += snprintf(p, LITE_LOG_BUF_SIZE - size, "%02d.%02d.%02d %02d:%02d:%02d ", timeinfo->tm_mday, timeinfo->tm_mon, timeinfo->tm_year % 100, timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
-	}
-	p += size;
-	size += vsnprintf(p, LITE_LOG_BUF_SIZE - size, data, ap);
-	p += size;
-#endif
-	va_end(ap);
-	assert(size < LITE_LOG_BUF_SIZE);
-	*p = 0;
-	lite_msg_log_t* msg = new lite_msg_log_t(err, buf);
-	// Отправка на вывод
-	lite_actor_t* log = lite_actor_t::name_find("log");
-	if(log == NULL) { // Нет актора "log"
-		// Регистрация lite_actor_log_t()
-		log = new lite_actor_log_t();
-		log->name_set("log");
-	}
-	#ifdef LT_DEBUG_LOG
-	log->recv(msg);
-	delete msg;
-	#else
-	log->run(msg);
-	#endif
-}
-
-//----------------------------------------------------------------------------------
-//----- ОБЕРТКИ --------------------------------------------------------------------
-//----------------------------------------------------------------------------------
-#pragma warning( push )
-#pragma warning( disable : 4505 ) // unreferenced local function has been removed
-
-// Получение типа сообщения
-template <typename T>
-static size_t lite_msg_type() {
-	return lite_msg_t::type_get<T>();
-}
-
-// Получения указателя на актор по имени
-static lite_actor_t* lite_actor_get(const std::string& name) noexcept {
-	return lite_actor_t::name_find(name);
-}
-
-// Удаление актора
-static void lite_actor_destroy(lite_actor_t* la) noexcept {
-	return lite_actor_t::destroy(la);
-}
-
-// Завершение с ожиданием всех
-static void lite_thread_end() noexcept {
-	lite_thread_t::end();
-}
-
-// Номер текущего потока
-static size_t lite_thread_num() noexcept {
-	return lite_thread_t::this_num();
-}
-
-// Установка максимума ресурсу по умолчанию
-static void lite_thread_max(int max) noexcept {
-	return lite_actor_t::resource_max(max);
-}
-
-// Создание ресурса
-static lite_resource_t* lite_resource_create(const std::string& name, int max) noexcept {
-	return lite_resource_manage_t::get(name, max);
-}
-
-// Копирование сообщения
-template <typename T>
-static T* lite_msg_copy(T* msg) noexcept {
-	return lite_actor_t::msg_copy(msg);
-}
-
-// Пробуждение потока
-static void lite_thread_wake_up() noexcept {
-	lite_thread_t::wake_up();
-}
-
-// Запуск с повторами по таймеру
-static void lite_timer_run(lite_actor_t* actor, int time_ms) noexcept {
-	lite_thread_t::timer_set(actor, time_ms);
-}
-#pragma warning( pop )
+﻿#pragma once
+/* lite_thread.h
+
+Кросплатформенная библиотека на С++11 для легкого распараллеливания кода, в т.ч. потокоНЕбезопасного.
+
+Библиотека построена по Модели Акторов, т.е. общий алгоритм разбивается на акторы (код, атомарные
+части бизнес-логики) и акторы общаются между собой пересылкой сообщений друг-другу.
+
+Библиотека сама создает нужное количество потоков и запускает в них акторы.
+
+Библиотека гарантирует что актор не будет запущен одновременно в нескольких потоках, т.е. код актора
+не требует потокобезопасности. Но если актор потокобезопасный, то есть установка ограничения на
+количество одновременно работающих копий данного актора. Также есть ограничение доступа группы акторов
+к конкретному ресурсу (например для ограничения количества используемых потоков)
+
+
+ПРИМЕР ПРОСТЕЙШЕГО ИСПОЛЬЗОВАНИЯ -------------------------------------------------------------
+
+// Сообщение
+struct msg_t : public lite_msg_t {
+	uint32_t x;
+};
+
+// Актор (обработчик сообщения)
+class actor_t : public lite_actor_t {
+	void recv(lite_msg_t* m) override {
+		msg_t* msg = dynamic_cast<msg_t*>(m);
+		if(msg == NULL) ... // Сообщение имеет другой тип, обработка ошибки
+		работа с msg
+	}
+};
+
+void main() {
+	actor_t* actor = new actor_t();
+	msg_t* msg = new msg_t; // Создание сообщения
+	msg->x = 100500;
+	actor->run(msg); // Постановка в очередь на выполнение
+
+	lite_thread_end(); // Ожидание завершения работы
+}
+
+
+СООБЩЕНИЯ ------------------------------------------------------------------------------------
+
+Класс сообщения должен быть унаследован от lite_msg_t
+struct msg_t : public lite_msg_t {
+};
+
+--- Создание сообщения.
+msg_t* msg = new msg_t;
+Сообщения удаляются библиотекой автоматически после обработки
+
+--- Передача сообщения на обработку.
+actor->run(msg)
+
+--- Срок актуальности сообщения.
+msg->ttl_set(int ms)  или  msg->deadline = lite_clock_ns() + нсек.
+actor->queue_age_set(int ms)
+Сообщение с истекшим сроком, либо ждавшее в очереди актора дольше queue_age_set(), не передается в 
+recv(): при извлечении из очереди вызывается on_expired(msg) (по умолчанию ничего не делает), затем
+сообщение удаляется. Ресурс и токены ограничения скорости на него не тратятся. Количество таких
+сообщений - actor->expired_get(), счетчик LT_STAT msg_expired. Сброс устаревшей работы при перегрузке.
+
+--- Срочное сообщение.
+msg->priority = LT_PRIORITY_HIGH
+Очередь актора делится на полосы: сообщения LT_PRIORITY_HIGH (отмена, сброс, конец данных) 
+обрабатываются раньше накопленных обычных, LT_PRIORITY_LOW - только когда других нет. Внутри полосы 
+порядок сохраняется. Пока все сообщения обычные, очередь работает как прежде, без блокировки при чтении.
+
+--- Копирование сообщения.
+T* lite_msg_copy(T* msg)
+При копировании сообщения полученного извне не использовать и не отправлять исходное, т.к. оно
+не копируется, а просто снимается с контроля автоудаления. 
+При копировании копии или явно созданного создается полноценная копия, т.е. можно использовать оба.
+В классе сообщения необходимо прописывать конструктор копирования.
+
+--- Удаление сообщения.
+delete msg
+Полученные извне и отправленные сообщения удалять нельзя, т.к. сообщения удаляются автоматически после 
+обработки.
+Удалять необходимо только скопированные или созданные и не отправленные сообщения.
+
+
+ВАЖНО -----------------------------------------------------------------------------------------
+
+Сообщения НЕ иммутабельны, поэтому:
+- нельзя отправлять одно сообщение дважды;
+- нельзя читать/писать сообщение после отправки, т.к. оно может быть уже в обработке или удалено.
+
+Сообщение можно изменять и отправлять дальше.
+
+Гарантируется что одно сообщение в любой момент времени обрабатывается только в одном потоке.
+
+Гарантируется что каждый обработчик получит сообщения в том порядке, в котором они отправлены.
+
+
+АКТОР (обработчик сообщений) ------------------------------------------------------------------
+
+Объекты акторов хранятся библиотекой и удаляются по окончании работы. 
+Для поиска существующего актора ему можно присвоить имя.
+
+Все классы акторов должны наследоваться от класса lite_actor_t.
+В дочернем классе необходимо прописать только метод recv()
+
+class actor_t : public lite_actor_t {
+	void recv(lite_msg_t* msg) override {
+	}
+}
+
+--- Создание объекта
+actor_t* actor = new actor_t;
+
+--- Присвоение имени
+actor->name_set(const std::string& name);
+
+--- Получение объекта по имени
+lite_actor_t* lite_actor_get(const std::string& name)
+
+--- Удаление объекта
+lite_actor_destroy(lite_actor_t* la);
+
+Если перед удалением необходимо выполнить какие-то операции связанные с отправкой сообщений, то прописать 
+это в методе before_destroy()
+
+class actor_t : public lite_actor_t {
+	void before_destroy() override {
+	}
+}
+
+
+Доступные методы базового класса:
+
+--- Регистрация типа обрабатываемого сообщения
+type_add(lite_msg_type<T>())
+Если зарегистрирован хоть один тип сообщения, то в метод recv() будут передаваться только зарегистрированные, 
+остальные будут игнорироваться с сообщением об ошибке.
+Если ни один тип не зарегистрирован, то на обработку проходят все входящие сообщения.
+
+
+РАСПАРЕЛЛЕЛИВАНИЕ АКТОРА --------------------------------------------------------------------
+
+Для акторов с потокобезопасным кодом (например актор без окружения, все необходимое для его
+работы содержится в сообщении) можно установить глубину распараллеливания, т.е. в скольки
+потоках актор может одновременно обрабатывать сообщения.
+
+--- Установка глубины распараллеливания
+actor->parallel_set(int max_threads)
+
+
+ЗАПУСК ПО ТАЙМЕРУ ----------------------------------------------------------------------------
+
+actor->timer_set(int time_ms)
+
+Устанавливает период запуска с интервалом time_ms. Отсчет начинается с момента установки.
+При time_ms <= 0 отключение таймера.
+
+В дочернем классе необходимо прописать метод timer()
+class actor_t : public lite_actor_t {
+	void timer() override {
+	}
+}
+
+Вызов по таймеру имеет приоритет ниже чем обработка сообщений, поэтому происходит только при пустой 
+очереди сообщений актора. Если по каким-либо причинам был пропушен момент запуска и наступил следующий, 
+то запуск будет один раз.
+
+
+РЕСУРСЫ --------------------------------------------------------------------------------------
+
+Ресурс ограничивает сколько может быть запущено одновременно акторов привязанных к ресурсу.
+При старте создается ресурс по умолчанию и вновь создаваемые акторы привязываются к нему.
+Рекомендуется использовать ресурс по умолчанию для акторов нагружающих процессор. Соответственно 
+максимум этого ресурса - количество потоков, которое можно использовать.
+Для акторов не нагружающих процессор (например запрос к вэб-сервису и ожидание ответа) лучше 
+создать отдельный ресурс и привязать туда эти акторы.
+
+--- Установка ресурса по умолчанию
+lite_thread_max(int max)
+Изначально максимум ресурса по умолчанию равен количеству процессоров доступных процессу с учетом
+квоты контейнера (см. ниже lite_cpu_limit()), либо задается при компиляции #define LT_RESOURCE_DEFAULT
+
+--- Создание ресурса
+lite_resource_t* lite_resource_create(const std::string& name, int max)
+
+--- Привязка актора к ресурсу
+actor->resource_set(lite_resource_t* res)
+Может вызываться и во время работы, в т.ч. из recv() самого актора: переход выполняется при следующем
+запуске, когда актор не выполняется другими потоками, порядок сообщений сохраняется. Если новый ресурс
+выполняют другие потоки (узел NUMA, выделенный пул), актор передается им через кэш нового ресурса.
+Счетчик LT_STAT resource_move.
+
+--- Приоритет актора
+actor->priority_set(int level)
+Уровни LT_PRIORITY_HIGH, LT_PRIORITY_NORMAL (по умолчанию), LT_PRIORITY_LOW. Готовый актор HIGH 
+выбирается раньше остальных, минуя кэши, перебором в потоках, которым доступен его свободный ресурс;
+актор LOW запускается только перебором, когда нет готовых выше. Выбор между уровнями строгий, либо
+после lite_thread_priority_weighted(true) взвешенный: доли уровней LT_PRIORITY_WEIGHTS (4, 2, 1).
+Перебор списка выполняется не реже раза в LT_PRIORITY_SCAN (16) выборов из кэша; готовый актор,
+обойденный LT_PRIORITY_AGING (8) переборов, выбирается как HIGH - низкие уровни не голодают. Пока приоритеты не заданы, выбор как прежде.
+
+--- Выбор старейшего сообщения
+lite_thread_oldest_first(true)
+При добавлении в очередь сообщению ставится метка msg->time (lite_clock_ns(), нсек.), поток выбирает
+готовый актор, первое сообщение которого ждет дольше всех (с точностью LT_OLDEST_BUCKET_US, 1000 мксек.),
+и обрабатывает его сообщения этого интервала. Кэши и слот LIFO не используются, выбор - перебором списка
+акторов, поэтому режим для перегрузки, когда важнее хвост задержек, чем пропускная способность.
+При заданных приоритетах акторов выбор по приоритету.
+
+--- Вес актора и сообщения
+actor->weight_set(int w)
+msg->weight = w
+По умолчанию запуск актора занимает 1 единицу ресурса. Актору можно задать вес - сколько единиц он
+занимает (например, чтение большими блоками), отдельному сообщению - больший вес на время его обработки
+(0 - вес актора). Вес ограничивается максимумом ресурса. Если свободных единиц не хватает, ресурс
+резервируется: более легкие захваты не занимают освобождающиеся единицы, пока тяжелый не запустится,
+а потоки, уже держащие единицы, отпускают их после текущего сообщения. Резерв принадлежит ожидающему 
+актору и снимается, когда он запустился, перешел на другой ресурс (resource_set) или удален.
+
+--- Вложенные ресурсы
+res->parent_set(lite_resource_t* parent)
+Захват ресурса занимает столько же единиц всех родительских, все или ничего: если не хватает хотя бы
+одного, ничего не занимается. Например "HDD" и "SSD" внутри "IO" - ограничение каждого диска и общее.
+
+--- Ограничение скорости
+res->rate_set(double per_sec, double burst = 0)
+msg->tokens = n
+Ведро токенов: пополняется per_sec токенов в секунду, вмещает burst (по умолчанию per_sec). Обработка
+сообщения актором ресурса стоит msg->tokens токенов (0 - 1 токен, для байт/сек - размер данных). Если
+токенов не хватает, сообщение остается первым в очереди, а актор не запускается до пополнения: его будит
+однократный таймер точно ко времени, без опроса. actor->throttled_us() - суммарное время ожидания 
+токенов, мксек., счетчик LT_STAT throttle. lite_thread_end() дожидается ожидающих токены.
+
+--- Блокирующие вызовы
+Если актор ресурса по умолчанию все же блокируется (чтение файла, ожидание ответа), то поток занимает
+единицу ресурса не нагружая процессор. Регулятор (см. ОСОБЕННОСТИ РАБОТЫ) считает поток заблокированным,
+если он выполнял актор все окно LT_MONITOR_MS, использовал процессор меньше LT_BLOCK_CPU (20%) окна
+и при этом не ждал процессор: ожидание в очереди планировщика (/proc/self/task/<tid>/schedstat) тоже
+меньше LT_BLOCK_CPU окна, а без schedstat - если потоки не заняли все процессоры (только Linux). Тогда
+выдается взаймы дополнительная единица ресурса с пробуждением или созданием потока. Если максимум
+задан через lite_thread_max(), то потоков сверх него не создается, единица достается свободному. 
+Единица возвращается, как только recv() заблокированного потока завершится. Заранее известный
+блокирующий участок можно отметить, тогда единица выдается сразу:
+	{
+		lite_blocking_scope bs;
+		fwrite(...);
+	}
+Выдача взаймы разрешена только ресурсу по умолчанию, для других включается res->lend_set(true). 
+Одновременно выдается не больше LT_BLOCK_LEND_MAX (64) единиц. Счетчики LT_STAT block_lend, block_scope.
+
+
+ТОПОЛОГИЯ ПРОЦЕССОРА -------------------------------------------------------------------------
+
+const lite_cpu_info_t& lite_cpu_info()
+Описание процессоров, на которых разрешено выполнение процесса (sched_getaffinity и /sys/devices/system/cpu
+в Linux, GetProcessAffinityMask и GetLogicalProcessorInformation в Windows):
+cpu_count	- логических процессоров
+core_count	- физических ядер
+smt			- логических процессоров на ядро
+l3_count	- групп ядер с общим кэшем L3
+numa_count	- узлов NUMA
+cpu[]		- для каждого процессора номер в системе, ядро, группа L3 и узел NUMA
+Определяется один раз при первом обращении.
+
+lite_cpu_limit_t lite_cpu_limit(bool reload = false, const char* root = NULL)
+Ограничение процессоров в контейнере: квота cgroup v2 cpu.max или v1 cpu.cfs_quota_us/cpu.cfs_period_us
+(quota, в процессорах) и количество процессоров в cpuset (cpuset). limit - итоговое количество процессоров,
+которое можно использовать. Ресурс по умолчанию и предел количества потоков рассчитываются от limit.
+reload = true перечитать ограничения, root - путь к каталогу cgroup вместо LT_CGROUP_ROOT (например к
+тестовому каталогу с файлами cpu.max или cpu.cfs_quota_us). Если максимум ресурса по умолчанию не задан
+через lite_thread_max(), то при изменении ограничения он пересчитывается.
+#define LT_CGROUP_RELOAD_MS 5000 - перечитывать ограничения раз в 5 сек. (по умолчанию только при запуске)
+
+Потоков одновременно создается не больше суммы максимумов всех ресурсов, т.к. больше одновременно
+работать не может.
+
+
+ПРИВЯЗКА К ПРОЦЕССОРАМ И NUMA ----------------------------------------------------------------
+
+--- Ресурс на узле NUMA
+lite_resource_t* lite_resource_create(const std::string& name, int max, int numa)
+Акторы ресурса выполняются только потоками узла numa (номер узла из lite_cpu_info().cpu[].numa), 
+которые привязаны к процессорам этого узла. При max <= 0 максимум равен количеству процессоров узла.
+Потоки узла не выполняют акторы других ресурсов, потоки узлов создаются не больше суммы максимумов 
+ресурсов узла.
+
+--- Создание актора сразу привязанным к ресурсу, память актора на узле ресурса
+actor_t* a = new(res) actor_t(...);
+
+--- Сообщение в памяти узла получателя
+msg_t* m = new(actor) msg_t;	// узел ресурса актора-получателя
+msg_t* m = new(res) msg_t;		// узел ресурса
+Память на узле выделяется для блоков от страницы памяти (4 Кб) в Linux: целые страницы в отдельной
+области адресов (резервируется при первом выделении, #define LT_NUMA_ARENA), привязанные к узлу (mbind).
+operator delete отличает такие блоки по адресу, обычное освобождение не блокируется. Меньшие блоки
+размещаются как обычно.
+
+--- Привязка актора к потоку
+lite_thread_affinity(int steal_delay_us)
+Запоминается поток, последним выполнявший актор. Когда актор готов к запуску, будится этот поток,
+а другие потоки не берут актор steal_delay_us мксек. (пока прошлый поток занят), сохраняя данные актора
+в кэше своего процессора. Полезно для акторов с большим рабочим набором данных. По умолчанию 0 - 
+выключено, задается также #define LT_STEAL_DELAY_US. Счетчики LT_STAT affinity_hit/affinity_miss - 
+запуски в том же/другом потоке.
+
+--- Привязка общих потоков к процессорам
+lite_thread_pin(bool on)
+Поток с номером n привязывается к процессору lite_cpu_info().cpu[n % cpu_count]. По умолчанию 
+выключено, потоки перемещаются системой свободно. Вызывать до запуска потоков.
+
+--- Выделенный пул потоков ресурса
+lite_pool_t* lite_resource_pool(lite_resource_t* res, int min, int max = 0, lite_sched_t policy = LT_SCHED_NORMAL, 
+	int prio = 0, const std::string& name = "")
+Акторы ресурса выполняются только своими потоками, общие потоки их не берут, поэтому поток вычислительных
+акторов не задерживает, например, акторы "HDD". Сразу запускается min потоков, они не завершаются, 
+всего не больше max (по умолчанию максимум ресурса). Потоки получают имя name#номер (по умолчанию имя 
+ресурса) и политику планирования:
+	LT_SCHED_NORMAL - обычная, prio - nice (-20..19)
+	LT_SCHED_BATCH - пакетная нагрузка (Linux SCHED_BATCH), prio - nice
+	LT_SCHED_IDLE - только при простое процессора (Linux SCHED_IDLE)
+	LT_SCHED_FIFO - реального времени (Linux SCHED_FIFO), prio - приоритет 1..99
+Если политика не разрешена (SCHED_FIFO без CAP_SYS_NICE), поток остается с LT_SCHED_NORMAL, примененная 
+политика в pool->policy_set. Отрицательный nice без прав не устанавливается. В Windows политики 
+отображаются на приоритеты потока. Ресурс, привязанный к узлу NUMA, выполняется пулом на процессорах узла.
+Вызывать до отправки сообщений акторам ресурса.
+
+
+РЕЖИМ "ПОТОК НА ЯДРО" -----------------------------------------------------------------------
+
+--- Включение
+lite_thread_shard(int count = 0)
+Запускается count потоков (по умолчанию и не больше - количество доступных процессоров), поток n 
+привязан к процессору lite_cpu_info().cpu[n]. Вызывать до создания акторов. lite_thread_end() 
+выключает режим.
+
+Каждый созданный после включения актор получает свой поток (по кругу) и выполняется только в нем.
+run() у такого актора помещает сообщение в очередь его потока: из того же потока - в локальную 
+очередь без блокировок, из другого потока режима - в кольцевой буфер этой пары потоков (LT_SHARD_RING
+элементов), из остальных потоков - в общую очередь потока под блокировкой. Ресурсы и parallel_set() 
+для таких акторов не действуют, одновременно актор выполняется не больше чем в одном потоке.
+
+--- Привязка актора к потоку
+actor->home_set(int n)
+n - номер потока режима, -1 выполнять общими потоками как обычно. Задавать до отправки сообщений.
+int actor->home_get()
+
+
+ВЕДЕНИЕ ЛОГА --------------------------------------------------------------------------------
+
+--- Запись в лог
+lite_log(int error, const char* data, ...)
+К введенным данным добавляется дата-время и отправляется сообщением на актор с именем "log", где
+по умолчанию выводится в консоль.
+
+В случае если error != 0 в текст дописывается "Error" и номер ошибки. 
+Номера менее LITE_ERROR_USER используются библиотекой.
+
+При необходимости можно создать свой актор "log". Он должен быть зарегистрирован до первого 
+вызова lite_log(). Актор получает сообщения типа 
+struct lite_msg_log_t : public lite_msg_t {
+	std::string data;
+	int err_num;
+};
+
+
+ЗАВЕРШЕНИЕ РАБОТЫ --------------------------------------------------------------------------
+
+--- Ожидание завершения работы всех акторов
+lite_thread_end()
+Ожидает когда будет полностью завершена работа, удаляет все потоки, акторы и т.д. Возвращает
+библиотеку в нулевое состояние. Можно вызывать многократно.
+
+
+ОСОБЕННОСТИ РАБОТЫ -------------------------------------------------------------------------
+
+Каждый актор имеет очередь входящих сообщений. Отправка сообщения актору это постановка его
+в очередь актора и пробуждение простаивающего потока для его обработки.
+
+Поток захвативший актор выполняет его в цикле до тех пор пока очередь сообщений актора не опустеет.
+
+При запуске актора происходит захват ресурса, к которому привязан актор, по окончании работы актора,
+ищется ожидающий выполнения актор привязанный к этому же ресурсу.
+
+При обработке последнего сообщения в очереди актора получатель исходящего сообщения записывается в слот
+потока (LIFO), чтобы по завершению работы с текущим актором в том же потоке запустить получателя.
+Если в слоте уже был другой актор, он вытесняется в общий кэш ресурса и будится свободный поток. 
+Другие потоки для актора из слота не оповещаются, поэтому отправку сообщения лучше всего выносить в конец
+актора или после отправки принудительно разбудить свободный поток lite_thread_wake_up(). 
+Чтобы акторы из общего кэша не простаивали, подряд из слота выполняется не больше LT_LIFO_MAX (64) 
+акторов, следующий получатель уходит в общий кэш.
+Свободный поток будится только когда актор становится готовым к запуску (очередь была пустой), 
+повторные сообщения ожидающему актору потоки не будят.
+
+Разбуженный поток считается ищущим работу, пока не найдет готовый актор или не уснет снова. Пока есть
+ищущий поток, другие не будятся: ищущий, найдя работу, сам будит следующий, если готовых акторов больше
+чем он может взять. Счетчики LT_STAT wake_skip - пропущенные пробуждения, create_skip - отложенные
+создания потоков.
+
+Потоки создаются по мере необходимости. Когда все имеющиеся потоки заняты обрабокой акторов, то создается
+новый, но не больше суммы максимумов всех ресурсов и не чаще раза в LT_THREAD_CREATE_US (500) мксек. Потоки нумеруются при создании, при простаивании приоритет пробуждения отдается потоку с меньшим 
+номером.
+
+Количество потоков контролирует регулятор - отдельный поток, раз в LT_MONITOR_MS (100) мсек. оценивающий
+за прошедшее окно загрузку потоков (время выполнения акторов), процессорное время потоков (разница - время 
+блокировки внутри акторов, только Linux) и количество готовых акторов. Если загрузка выше LT_UTIL_HIGH (90%)
+и есть готовые акторы - добавляется поток. Если загрузка ниже уровня LT_UTIL_LOW (50%) от количества потоков 
+без одного и готовых акторов нет LT_SHRINK_TICKS (10) окон подряд - целевое количество уменьшается на 1 и 
+завершается первый освободившийся лишний поток, его номер занимает следующий созданный. Потоки пула не 
+завершаются меньше min и не мешают уменьшению общих. Между порогами количество не меняется, что 
+исключает колебания. Максимумы ресурсов соблюдаются. Состояние регулятора lite_thread_ctl(), счетчики 
+LT_STAT ctl_grow, ctl_shrink.
+
+
+ОТЛАДКА -----------------------------------------------------------------------------------
+
+--- Вывод lite_log() сразу в консоль
+#define LT_DEBUG_LOG
+Используется встроенный вывод в лог и отключается отложенный вывод, т.к. если происходит прерывание
+работы при отложенном выводе (например обращение к несуществующей памяти), то не все последние записи
+успевают записаться в лог.
+
+--- Включение счетчиков статистики
+#define LT_STAT
+Выводятся по окончании lite_thread_end(). Назначение описано ниже в lite_stat_data_t
+
+lite_stat_data_t lite_stat_get(bool reset = false)
+Текущие значения счетчиков, при reset = true счетчики сбрасываются в 0 (например между прогонами
+замера производительности). Счетчики потоков добавляются при их завершении, поэтому полные значения
+доступны после lite_thread_end().
+
+lite_stat_print(bool on)
+Отключение/включение вывода статистики в lite_thread_end()
+
+--- Счетчики акторов во время работы
+lite_stats_enable(bool on)
+std::vector<lite_actor_stats_t> lite_stats_snapshot()
+Не требуют LT_STAT, включаются и выключаются в любой момент. По каждому актору: поставлено в очередь,
+обработано, устарело, длина очереди текущая и максимальная, время выполнения (нсек.), запусков, из них
+из слота LIFO и из кэша ресурса. Счетчики разделены на LT_METRICS_SHARDS частей по номеру потока,
+снимок суммирует части и доступен из любого потока. Длина очереди берется из самой очереди (счетчики
+добавленных и извлеченных ведутся всегда, без атомарного сложения), максимум - с момента включения.
+Выключенные стоят одной проверки флага на сообщение.
+
+--- Гистограммы задержек акторов
+lite_stats_enable(true, true)
+st.wait_ns.percentile(99), st.recv_ns.percentile(99.9)
+Дополнительно к счетчикам по каждому актору: wait_ns - от постановки сообщения в очередь до начала 
+recv(), recv_ns - время выполнения recv(), нсек. Гистограммы логарифмически-линейные (как HDR): 
+2^LT_HIST_SUB_BITS (8) интервалов на каждое удвоение, погрешность процентилей до 12.5%, предел 
+2^LT_HIST_MAX_BITS (40) нсек. Потоки пишут в общую гистограмму актора атомарным сложением без 
+блокировок, lite_hist_t::add() складывает гистограммы акторов или снимков. Замер - lite_clock_ns(): 
+steady_clock (в Linux clock_gettime() через vDSO), с #define LT_CLOCK_TSC - счетчик тактов процессора
+x86-64 (нужен инвариантный TSC), калибровка 10 мсек. при первом вызове. Цена: метка времени при 
+постановке, чтение часов после recv() (начало первого recv() - время запуска актора) и два атомарных
+сложения на сообщение. Замер stress_test --stats на виртуальной машине с чтением часов ~50 нсек.: 
+без счетчиков 30-35 нсек. на пересылку, счетчики +7-23 нсек., гистограммы +155-180 нсек.
+
+--- Сквозная задержка запросов
+lite_e2e_sample(double fraction)
+std::vector<lite_e2e_stats_t> lite_e2e_snapshot()
+msg->trace_begin(), msg->trace_end()
+Отслеживается доля fraction запросов (0 - выключено, по умолчанию). Запрос начинается с сообщения,
+отправленного не из актора, или явно msg->trace_begin() (решение выборки принимается в нем): сообщению
+ставятся номер запроса и время начала (msg->trace_id_get(), msg->origin_get(), хранятся в отдельном
+блоке, выделяемом только отслеживаемым сообщениям). Пересылаемое дальше то же сообщение, его копии 
+lite_msg_copy() и новые сообщения, отправленные из recv() отслеживаемого, продолжают запрос. Если
+recv() ничего не отправил по запросу, путь окончен: задержка от origin записывается в гистограмму 
+конечного актора (lite_hist_t, как у счетчиков акторов). msg->trace_end() оканчивает запрос явно, 
+например перед возвратом сообщения по кругу на начало. Цена без выборки - проверка полей сообщения
+и потока на отправку, для отслеживаемых - чтение часов в начале и в конце пути.
+
+--- Трассировка
+lite_trace_start(const std::string& file = "", int sample = 1)
+lite_trace_stop()
+bool lite_trace_dump(const std::string& file)
+Каждый поток пишет события без блокировок в свой кольцевой буфер на LT_TRACE_RING (16384) событий, 
+старые перезаписываются: запуски акторов (актор, ресурс, обработано сообщений), отправки сообщений со
+связью отправитель - получатель, ожидания и пробуждения потоков, вызовы timer(). Записывается каждый 
+sample-й запуск актора в потоке и отправки из него, запуск с обработкой записанной отправки - всегда 
+(без его отправок), так что цена ограничена выборкой. Выключенная стоит одной проверки флага на сообщение. Выгрузка в 
+формате Chrome trace (JSON, открывается в chrome://tracing и ui.perfetto.dev) по запросу из любого 
+потока или в lite_thread_end(), если при включении задан file. Выгрузка содержит только события, 
+оставшиеся в буферах.
+
+--- Граф обменов акторов
+lite_graph_enable(bool on, const std::string& file = "")
+std::vector<lite_graph_edge_t> lite_graph_snapshot()
+bool lite_graph_dot(const std::string& file)
+bool lite_graph_json(const std::string& file)
+По каждому ребру (отправитель, получатель, тип сообщения) считаются сообщения, байты и средние 
+скорости с момента включения. Отправитель - актор, выполняющийся в потоке при run(), иначе "external".
+Байты - msg->bytes, если задан (данные буферов, строк), иначе sizeof типа, с которым вызван run() 
+(при пересылке через lite_msg_t* - sizeof(lite_msg_t)). Поток пишет в свою таблицу под своей 
+блокировкой, снимок объединяет таблицы. Выгрузка в Graphviz DOT (толщина ребра по количеству 
+сообщений) или JSON в любой момент, либо в lite_thread_end(), если при включении задан file 
+(по расширению .json - JSON, иначе DOT). Частые ребра - кандидаты на пакетную отправку или 
+выполнение в одном потоке (home_set()). Выключенный стоит одной проверки флага на сообщение.
+
+--- Вывод в лог информации о состоянии потоков
+#define LT_DEBUG
+Рекомендуется использовать вместе с LT_DEBUG_LOG, т.к. используется lite_log(), иначе вывод вызывает
+дополнительное изменение состояния потоков.
+
+--- Компиляция в DLL под WinXP (там проблемы с thread_local и static при явной загрузке)
+#define LT_XP_DLL
+
+*/
+
+#if defined(_WIN32) || defined(_WIN64)
+#define LT_WIN
+#include <windows.h>
+#define LT_NOINLINE __declspec(noinline) // Редкие ветви вне горячего цикла
+#else
+#include <unistd.h>
+#include <dirent.h>
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#endif
+#define LT_NOINLINE __attribute__((noinline))
+#endif
+
+#define LT_VERSION "0.9.2" // Версия библиотеки
+
+#ifndef LT_RESOURCE_DEFAULT
+#define LT_RESOURCE_DEFAULT 0 // Предел ресурса по умолчанию, 0 - количество доступных процессу процессоров
+#endif
+
+#define LITE_ERROR_NOT_IMPLEMENTED	1  // Не прописан обработчик актора
+#define LITE_ERROR_RESOURCE			2  // Актор использует другой ресурс
+#define LITE_ERROR_ACTOR_DOUBLE		3  // Попытка присвоить имя уже существующего актора
+#define LITE_ERROR_ACTOR_NAME		4  // Попытка смены имени актора
+#define LITE_ERROR_MSG_TYPE			5  // Сообщение необрабатываемого типа
+#define LITE_ERROR_USER				16 // Пользовательские коды ошибок начиная с LITE_ERROR_USER
+#ifdef LT_DEBUG
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#endif
+
+#include <atomic>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <string>
+#include <assert.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+//-------- ВЫРАВНИВАНИЕ В ПАМЯТИ ---------------------------------------------------
+//----------------------------------------------------------------------------------
+#ifndef LT_NUMA_ARENA
+#define LT_NUMA_ARENA (sizeof(void*) >= 8 ? ((size_t)1 << 36) : ((size_t)1 << 28)) // Область адресов блоков узлов NUMA, байт (только резерв, без памяти)
+#endif
+
+// Выделение памяти с выравниванием под кэшлинию (кратно 0x40)
+class lite_align64_t {
+public:
+	lite_align64_t() {}
+	lite_align64_t(int) {}
+
+	void *operator new(size_t size) {
+		void* p;
+#ifdef LT_WIN
+		p = _aligned_malloc(size, 0x40);
+#else
+		if (posix_memalign(&p, 0x40, size)) p = NULL;
+#endif
+		if (p == NULL) {
+			assert(p != NULL);
+			throw std::bad_alloc();
+		}
+		return p;
+	}
+
+	void operator delete(void *p) {
+#ifdef LT_WIN
+		_aligned_free(p);
+#else
+		#if defined(__linux__) && defined(SYS_mbind)
+		if (numa_free(p)) return;
+		#endif
+		free(p);
+#endif
+	}
+
+	// Выделение памяти на узле NUMA numa (при numa < 0 - как обычно). Освобождается operator delete.
+	// Привязка к узлу только для блоков от страницы памяти (Linux), меньшие размещаются на узле потока,
+	// который первым в них пишет.
+	static void* alloc_numa(size_t size, int numa) {
+#if defined(__linux__) && defined(SYS_mbind)
+		size_t page = page_size();
+		if (numa >= 0 && numa < 64 && size >= page) {
+			// Свои страницы: политика узла не достается куче, страницы не делятся с чужими данными
+			void* p = numa_arena().alloc((size + page - 1) & ~(page - 1), numa);
+			if (p != NULL) return p;
+		}
+#endif
+		(void)numa;
+		return lite_align64_t::operator new(size);
+	}
+
+#if defined(__linux__) && defined(SYS_mbind)
+private:
+	// Область адресов блоков alloc_numa. Резервируется целиком при первом выделении (PROT_NONE, память
+	// не выделяется), блок отображается в ней целыми страницами и привязывается к узлу. Другие блоки 
+	// в область не попадают, поэтому освобождение отличает блоки узлов по адресу
+	struct numa_arena_t {
+		std::mutex mtx;							// Блокировка выделения и освобождения блоков области
+		size_t used = { 0 };					// Отдано от начала области
+		std::unordered_map<char*, size_t> len;	// Выделенные блоки: адрес -> длина
+		std::multimap<size_t, char*> gaps;		// Освобожденные участки по длине
+
+		// Блок n байт (кратно странице) на узле numa. NULL - область не зарезервирована или заполнена
+		void* alloc(size_t n, int numa) noexcept {
+			std::lock_guard<std::mutex> lck(mtx);
+			char* base = numa_base().load(std::memory_order_relaxed);
+			if (base == NULL) {
+				void* r = mmap(NULL, LT_NUMA_ARENA, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+				if (r == MAP_FAILED) return NULL;
+				base = (char*)r;
+				numa_base().store(base, std::memory_order_release);
+			}
+			char* p;
+			std::multimap<size_t, char*>::iterator it = gaps.lower_bound(n);
+			if (it != gaps.end()) { // Наименьший подходящий освобожденный участок, остаток остается свободным
+				p = it->second;
+				if (it->first > n) gaps.insert(std::make_pair(it->first - n, p + n));
+				gaps.erase(it);
+			} else if (LT_NUMA_ARENA - used >= n) {
+				p = base + used;
+				used += n;
+			} else {
+				return NULL;
+			}
+			if (mmap(p, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED) {
+				gaps.insert(std::make_pair(n, p));
+				return NULL;
+			}
+			unsigned long mask = 1UL << numa;
+			// Страницы еще не выделены, перенос (MPOL_MF_MOVE) не нужен
+			syscall(SYS_mbind, p, n, 1 /* MPOL_PREFERRED */, &mask, sizeof(mask) * 8, 0);
+			len[p] = n;
+			return p;
+		}
+
+		// Освобождение блока p: страницы возвращаются системе, адреса остаются за областью
+		void release(char* p) noexcept {
+			std::lock_guard<std::mutex> lck(mtx);
+			std::unordered_map<char*, size_t>::iterator it = len.find(p);
+			assert(it != len.end());
+			if (it == len.end()) return;
+			size_t n = it->second;
+			len.erase(it);
+			mmap(p, n, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+			gaps.insert(std::make_pair(n, p));
+		}
+	};
+
+	// Начало области, NULL - еще не зарезервирована. Без динамической инициализации: проверка в 
+	// operator delete - одно чтение
+	static std::atomic<char*>& numa_base() noexcept {
+		static std::atomic<char*> base(NULL);
+		return base;
+	}
+
+	static numa_arena_t& numa_arena() {
+		static numa_arena_t* a = new numa_arena_t; // Не удаляется: блоки могут освобождаться после выхода из main()
+		return *a;
+	}
+
+	static size_t page_size() {
+		static size_t page = (size_t)sysconf(_SC_PAGESIZE);
+		return page;
+	}
+
+	// Освобождение блока alloc_numa. false - блок выделен обычным образом
+	static bool numa_free(void* p) noexcept {
+		char* base = numa_base().load(std::memory_order_acquire);
+		if (base == NULL || (uintptr_t)p - (uintptr_t)base >= LT_NUMA_ARENA) return false;
+		numa_arena().release((char*)p);
+		return true;
+	}
+#endif
+};
+
+//----------------------------------------------------------------------------------
+//------ ПЕРЕМЕННЫЕ ПОТОКА (для DLL под XP) ----------------------------------------
+//----------------------------------------------------------------------------------
+#ifdef LT_XP_DLL
+template <typename T>
+class lite_thread_info_t : public lite_align64_t {
+	static uint32_t tls_idx() noexcept {
+		static uint32_t x = TLS_OUT_OF_INDEXES;
+		if (x == TLS_OUT_OF_INDEXES) {
+			x = TlsAlloc();
+			assert(x != TLS_OUT_OF_INDEXES);
+		}
+		return x;
+	}
+public:
+	static T& tls_get() noexcept {
+		T* x = (T*)TlsGetValue(tls_idx());
+		if (x == NULL) {
+			x = new T();
+			memset(x, 0, sizeof(T));
+			TlsSetValue(tls_idx(), x);
+		}
+		return *x;
+	}
+
+	static void tls_free() noexcept {
+		T* x = (T*)TlsGetValue(tls_idx());
+		if (x != NULL) {
+			delete x;
+			TlsSetValue(tls_idx(), NULL);
+		}
+	}
+};
+
+template <typename T>
+class lite_static_info_t : public lite_align64_t {
+public:
+	static T& si() noexcept {
+		static T* x;
+		if(x == NULL) {
+			x = new T();
+		}
+		return *x;
+	}
+};
+#else
+template <typename T>
+class lite_thread_info_t {
+
+public:
+	static T& tls_get() noexcept {
+		thread_local T x;
+		return x;
+	}
+
+	static void tls_free() noexcept {
+	}
+};
+
+template <typename T>
+class lite_static_info_t {
+public:
+	static T& si() noexcept {
+		static T x;
+		return x;
+	}
+};
+#endif
+
+#ifdef LT_STAT
+//----------------------------------------------------------------------------------
+//------ СЧЕТЧИКИ СТАТИСТИКИ -------------------------------------------------------
+//----------------------------------------------------------------------------------
+static int64_t lite_time_now();
+
+// Значения счетчиков
+struct lite_stat_data_t {
+	size_t stat_thread_max;			// Максимальное количество потоков запущенных одновременно
+	size_t stat_parallel_run;		// Максимальное количество потоков работавших одновременно
+	size_t stat_thread_create;		// Создано потоков
+	size_t stat_thread_wake_up;		// Сколько раз будились потоки
+	size_t stat_try_wake_up;		// Попыток разбудить поток
+	size_t stat_msg_create;			// Создано сообщений
+	size_t stat_msg_erase;			// Удалено сообщений
+	size_t stat_actor_create;		// Создано акторов
+	size_t stat_actor_erase;		// Удалено акторов
+	size_t stat_actor_get;			// Запросов lite_actor_t* по (func, env)
+	size_t stat_actor_find;			// Поиск очередного актора готового к работе
+	size_t stat_actor_not_run;		// Промахи обработки сообщения, уже обрабатывается другим потоком
+	size_t stat_cache_found;		// Найдено в глобальном кэше
+	size_t stat_cache_bad;			// Извлечение из кэша неготового актора
+	size_t stat_cache_full;			// Попытка записи в полный кэш
+	size_t stat_res_lock;			// Количество блокировок ресурсов
+	size_t stat_queue_max;			// Максимальная глубина очереди
+	size_t stat_msg_send;			// Обработано сообщений
+	size_t stat_affinity_hit;		// Актор запущен в том же потоке, что и в прошлый раз
+	size_t stat_affinity_miss;		// Актор запущен в другом потоке
+	size_t stat_wake_skip;			// Пробуждение не нужно, уже есть ищущий работу поток
+	size_t stat_create_skip;		// Создание потока отложено ограничением частоты
+	size_t stat_ctl_grow;			// Решений регулятора добавить поток
+	size_t stat_ctl_shrink;			// Решений регулятора убрать поток
+	size_t stat_block_lend;			// Выдано ресурсов взаймы потокам, заблокированным в recv()
+	size_t stat_block_scope;		// Выдано ресурсов взаймы в lite_blocking_scope
+	size_t stat_throttle;			// Остановок акторов ограничением скорости ресурса
+	size_t stat_res_move;			// Переходов акторов на другой ресурс во время работы
+	size_t stat_msg_expired;		// Сообщений не обработано из-за истекшего срока или долгого ожидания
+};
+
+class lite_thread_stat_t : public lite_stat_data_t, public lite_thread_info_t<lite_thread_stat_t>, public lite_static_info_t<lite_thread_stat_t> {
+
+public:
+	//---------------------------------------------------------------------
+	// Счетчики потока
+	static lite_thread_stat_t& ti() noexcept {
+		return tls_get();
+	}
+
+	// Сигнал о зачершении потока
+	static void thread_end() noexcept {
+		tls_free();
+	}
+
+	//---------------------------------------------------------------------
+	lite_thread_stat_t() {
+		init();
+		lite_time_now(); // Запуск отсчета времени
+	}
+
+	~lite_thread_stat_t() {
+		store();
+	}
+
+	// Сброс в 0
+	void init() {
+		memset(static_cast<lite_stat_data_t*>(this), 0, sizeof(lite_stat_data_t));
+	}
+
+	// Сохранение счетчиков потока в глобальные
+	void store() {
+		std::unique_lock<std::mutex> lck(mtx()); // Блокировка
+		if(si().stat_thread_max < stat_thread_max) si().stat_thread_max = stat_thread_max;
+		if(si().stat_parallel_run < stat_parallel_run) si().stat_parallel_run = stat_parallel_run;
+		si().stat_thread_create += stat_thread_create;
+		si().stat_thread_wake_up += stat_thread_wake_up;
+		si().stat_try_wake_up += stat_try_wake_up;
+		si().stat_msg_create += stat_msg_create;
+		si().stat_msg_erase += stat_msg_erase;
+		si().stat_actor_create += stat_actor_create;
+		si().stat_actor_erase += stat_actor_erase;
+		si().stat_actor_get += stat_actor_get;
+		si().stat_actor_find += stat_actor_find;
+		si().stat_cache_found += stat_cache_found;
+		si().stat_cache_bad += stat_cache_bad;
+		si().stat_cache_full += stat_cache_full;
+		si().stat_res_lock += stat_res_lock;
+		si().stat_actor_not_run += stat_actor_not_run;
+		if(si().stat_queue_max < stat_queue_max) si().stat_queue_max = stat_queue_max;
+		si().stat_msg_send += stat_msg_send;
+		si().stat_affinity_hit += stat_affinity_hit;
+		si().stat_affinity_miss += stat_affinity_miss;
+		si().stat_wake_skip += stat_wake_skip;
+		si().stat_create_skip += stat_create_skip;
+		si().stat_ctl_grow += stat_ctl_grow;
+		si().stat_ctl_shrink += stat_ctl_shrink;
+		si().stat_block_lend += stat_block_lend;
+		si().stat_block_scope += stat_block_scope;
+		si().stat_throttle += stat_throttle;
+		si().stat_res_move += stat_res_move;
+		si().stat_msg_expired += stat_msg_expired;
+		init();
+	}
+
+	// Накопленные счетчики (с учетом текущего потока), reset = true сброс после чтения
+	static lite_stat_data_t get(bool reset) noexcept {
+		ti().store();
+		std::unique_lock<std::mutex> lck(mtx()); // Блокировка
+		lite_stat_data_t ret = si();
+		if (reset) si().init();
+		return ret;
+	}
+
+	// Блокировка доступа к глобальным счетчикам
+	static std::mutex& mtx() noexcept {
+		static std::mutex m;
+		return m;
+	}
+
+	// Разрешение вывода в lite_thread_end()
+	static bool& print_on() noexcept {
+		static bool on = true;
+		return on;
+	}
+
+	void print_stat() {
+		store();
+		if (!print_on()) return;
+		printf("\n------- STAT -------\n");
+		printf("thread_max     %llu\n", (uint64_t)si().stat_thread_max);
+		printf("parallel_run   %llu\n", (uint64_t)si().stat_parallel_run);
+		printf("thread_create  %llu\n", (uint64_t)si().stat_thread_create);
+		printf("thread_wake_up %llu\n", (uint64_t)si().stat_thread_wake_up);
+		printf("try_wake_up    %llu\n", (uint64_t)si().stat_try_wake_up);
+		printf("msg_create     %llu\n", (uint64_t)si().stat_msg_create);
+		printf("actor_create   %llu\n", (uint64_t)si().stat_actor_create);
+		printf("actor_get      %llu\n", (uint64_t)si().stat_actor_get);
+		printf("actor_find     %llu\n", (uint64_t)si().stat_actor_find);
+		printf("actor_not_run  %llu\n", (uint64_t)si().stat_actor_not_run);
+		printf("cache_found    %llu\n", (uint64_t)si().stat_cache_found);
+		printf("cache_bad      %llu\n", (uint64_t)si().stat_cache_bad);
+		printf("cache_full     %llu\n", (uint64_t)si().stat_cache_full);
+		printf("resource_lock  %llu\n", (uint64_t)si().stat_res_lock);
+		#ifdef LT_STAT_QUEUE
+		printf("queue_max      %llu\n", (uint64_t)si().stat_queue_max);
+		#endif
+		printf("affinity_hit   %llu\n", (unsigned long long)si().stat_affinity_hit);
+		printf("affinity_miss  %llu\n", (unsigned long long)si().stat_affinity_miss);
+		printf("wake_skip      %llu\n", (unsigned long long)si().stat_wake_skip);
+		printf("create_skip    %llu\n", (unsigned long long)si().stat_create_skip);
+		printf("ctl_grow       %llu\n", (unsigned long long)si().stat_ctl_grow);
+		printf("ctl_shrink     %llu\n", (unsigned long long)si().stat_ctl_shrink);
+		printf("block_lend     %llu\n", (unsigned long long)si().stat_block_lend);
+		printf("block_scope    %llu\n", (unsigned long long)si().stat_block_scope);
+		printf("throttle       %llu\n", (unsigned long long)si().stat_throttle);
+		printf("resource_move  %llu\n", (unsigned long long)si().stat_res_move);
+		printf("msg_expired    %llu\n", (unsigned long long)si().stat_msg_expired);
+		printf("msg_send       %llu\n", (uint64_t)si().stat_msg_send);
+		int64_t time_ms = lite_time_now();
+		printf("msg_send/sec   %llu\n", (uint64_t)si().stat_msg_send * 1000 / (time_ms > 0 ? time_ms : 1)); // Сообщений в секунду
+		printf("\n");
+		if (si().stat_msg_create != si().stat_msg_erase) printf("!!! ERROR: lost %lld messages (erase %lld)\n\n", (int64_t)si().stat_msg_create - si().stat_msg_erase, (int64_t)si().stat_msg_erase); // Утечка памяти
+		if (si().stat_actor_create != si().stat_actor_erase) printf("!!! ERROR: lost %lld actors (erase %lld)\n\n", (int64_t)si().stat_actor_create - si().stat_actor_erase, (int64_t)si().stat_actor_erase); // Утечка памяти
+	}
+};
+
+#endif
+
+//----------------------------------------------------------------------------------
+//------ БЛОКИРОВКИ ----------------------------------------------------------------
+//----------------------------------------------------------------------------------
+#define LOCK_TYPE_LT "spinlock + Sleep(0)"
+
+class lite_mutex_t {
+	std::atomic_flag af = ATOMIC_FLAG_INIT;
+
+	// Ожидание освобождения, редкий случай - вне встраиваемого lock()
+	void lock_wait() noexcept {
+		while (af.test_and_set(std::memory_order_acquire)) {
+#if defined LT_WIN
+			Sleep(0);
+#else
+			usleep(20);
+#endif
+		}
+	}
+
+public:
+	void lock() noexcept {
+		if (af.test_and_set(std::memory_order_acquire)) lock_wait();
+	}
+
+	void unlock() noexcept {
+		af.clear(std::memory_order_release);
+	}
+}; 
+
+
+class lite_lock_t {
+	lite_mutex_t* mtx;
+public:
+	lite_lock_t(lite_mutex_t& mtx) noexcept {
+		this->mtx = &mtx;
+		this->mtx->lock();
+	}
+
+	~lite_lock_t() noexcept {
+		this->mtx->unlock();
+	}
+};
+
+// Время с момента запуска, мсек
+static int64_t lite_time_now() {
+	static std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+	std::chrono::duration<double> time_span = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t);
+	return (int64_t)(time_span.count() * 1000);
+}
+
+// Монотонное время, нсек. Для меток времени сообщений и замеров задержек. steady_clock в Linux - 
+// clock_gettime() через vDSO, без системного вызова, в Windows - QueryPerformanceCounter()
+#if defined(LT_CLOCK_TSC) && (defined(__x86_64__) || defined(_M_X64))
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+// Счетчик тактов процессора (нужен инвариантный TSC), пересчет в нсек. по калибровке при первом вызове
+static int64_t lite_clock_ns() noexcept {
+	struct calib_t {
+		int64_t ns0;
+		uint64_t tsc0;
+		double scale; // Нсек. на такт
+		static int64_t steady() noexcept {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+		calib_t() noexcept {
+			ns0 = steady();
+			tsc0 = __rdtsc();
+			while (steady() < ns0 + 10000000); // 10 мсек.
+			scale = (double)(steady() - ns0) / (double)(__rdtsc() - tsc0);
+		}
+	};
+	static calib_t c;
+	return c.ns0 + (int64_t)((double)(__rdtsc() - c.tsc0) * c.scale);
+}
+#else
+static int64_t lite_clock_ns() noexcept {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+//----------------------------------------------------------------------------------
+//------ ТОПОЛОГИЯ ПРОЦЕССОРА ------------------------------------------------------
+//----------------------------------------------------------------------------------
+// Описание процессоров, доступных процессу
+struct lite_cpu_info_t {
+	struct cpu_t {
+		int id;			// Номер логического процессора в системе
+		int core;		// Номер физического ядра (по порядку среди доступных)
+		int l3;			// Номер группы ядер с общим кэшем L3 (по порядку)
+		int numa;		// Узел NUMA
+	};
+
+	int cpu_count;		// Логических процессоров доступно процессу
+	int core_count;		// Физических ядер
+	int smt;			// Максимум логических процессоров на одно ядро (SMT, Hyper-Threading)
+	int l3_count;		// Групп ядер с общим кэшем L3
+	int numa_count;		// Узлов NUMA
+	std::vector<cpu_t> cpu; // Доступные процессоры по возрастанию id
+};
+
+// Ограничение процессоров в контейнере (cgroup)
+struct lite_cpu_limit_t {
+	double quota;		// Квота процессорного времени в процессорах (quota / period), 0 - без ограничения
+	int cpuset;			// Процессоров в cpuset, 0 - без ограничения
+	int limit;			// Итог: сколько процессоров можно использовать
+};
+
+#ifndef LT_CGROUP_ROOT
+#define LT_CGROUP_ROOT "/sys/fs/cgroup" // Точка монтирования cgroup
+#endif
+
+#ifndef LT_CGROUP_RELOAD_MS
+#define LT_CGROUP_RELOAD_MS 0 // Период перечитывания ограничений cgroup, мсек. 0 - только при запуске
+#endif
+
+// Политика планирования потоков выделенного пула ресурса
+enum lite_sched_t {
+	LT_SCHED_NORMAL = 0,	// Обычная, prio - nice
+	LT_SCHED_BATCH,			// Пакетная вычислительная нагрузка (Linux SCHED_BATCH), prio - nice
+	LT_SCHED_IDLE,			// Только при простое процессора (Linux SCHED_IDLE)
+	LT_SCHED_FIFO			// Реального времени (Linux SCHED_FIFO), prio - приоритет 1..99
+};
+
+class lite_cpu_topology_t {
+	// Нумерация по порядку: ключ -> номер
+	static int num_get(std::vector<int64_t>& keys, int64_t key) {
+		for (size_t i = 0; i < keys.size(); i++) {
+			if (keys[i] == key) return (int)i;
+		}
+		keys.push_back(key);
+		return (int)keys.size() - 1;
+	}
+
+	// Подсчет итогов по заполненному списку cpu
+	static void totals(lite_cpu_info_t& ci, std::vector<int64_t>& core_keys, std::vector<int64_t>& l3_keys) {
+		ci.cpu_count = (int)ci.cpu.size();
+		ci.core_count = (int)core_keys.size();
+		ci.l3_count = (int)l3_keys.size();
+		ci.numa_count = 0;
+		ci.smt = 1;
+		std::vector<int> per_core(core_keys.size(), 0);
+		for (auto& c : ci.cpu) {
+			if (++per_core[c.core] > ci.smt) ci.smt = per_core[c.core];
+			if (c.numa + 1 > ci.numa_count) ci.numa_count = c.numa + 1;
+		}
+	}
+
+#ifndef LT_WIN
+	// Чтение числа из файла, при ошибке def
+	static int64_t file_int(const char* path, int64_t def) {
+		FILE* f = fopen(path, "r");
+		if (f == NULL) return def;
+		long long x;
+		if (fscanf(f, "%lld", &x) != 1) x = def;
+		fclose(f);
+		return x;
+	}
+
+	// Чтение первой строки файла
+	static bool file_str(const char* path, char* buf, int size) {
+		FILE* f = fopen(path, "r");
+		if (f == NULL) return false;
+		bool ret = (fgets(buf, size, f) != NULL);
+		fclose(f);
+		return ret;
+	}
+
+	// Разбор списка процессоров вида "0-3,8,10-11"
+	static std::vector<int> list_parse(const char* str) {
+		std::vector<int> ret;
+		const char* p = str;
+		while (*p >= '0' && *p <= '9') {
+			int a = (int)strtol(p, (char**)&p, 10);
+			int b = a;
+			if (*p == '-') b = (int)strtol(p + 1, (char**)&p, 10);
+			for (int i = a; i <= b; i++) ret.push_back(i);
+			if (*p == ',') p++;
+		}
+		return ret;
+	}
+
+	// Идентификатор кэша L3 процессора: минимальный номер процессора из разделяющих кэш
+	static int64_t l3_key(int id) {
+		char path[128], buf[1024];
+		for (int idx = 0; idx < 8; idx++) {
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", id, idx);
+			int64_t level = file_int(path, -1);
+			if (level < 0) break;
+			if (level != 3) continue;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", id, idx);
+			if (!file_str(path, buf, sizeof(buf))) break;
+			std::vector<int> l = list_parse(buf);
+			return l.empty() ? id : l[0];
+		}
+		return 0; // Нет данных, считаем общим
+	}
+
+	// Узел NUMA процессора
+	static int numa_node(int id) {
+		char path[128];
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", id);
+		DIR* d = opendir(path);
+		if (d == NULL) return 0;
+		int node = 0;
+		struct dirent* e;
+		while ((e = readdir(d)) != NULL) {
+			if (strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9') {
+				node = atoi(e->d_name + 4);
+				break;
+			}
+		}
+		closedir(d);
+		return node;
+	}
+
+	// Процессоры, на которых разрешено выполнение процесса
+	static std::vector<int> cpu_allowed() {
+		std::vector<int> ret;
+		#ifdef __linux__
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+			for (int i = 0; i < CPU_SETSIZE; i++) {
+				if (CPU_ISSET(i, &set)) ret.push_back(i);
+			}
+		}
+		#endif
+		if (ret.empty()) {
+			long n = sysconf(_SC_NPROCESSORS_ONLN);
+			for (long i = 0; i < (n > 0 ? n : 1); i++) ret.push_back((int)i);
+		}
+		return ret;
+	}
+
+	static bool file_exists(const std::string& path) {
+		FILE* f = fopen(path.c_str(), "r");
+		if (f == NULL) {
+			DIR* d = opendir(path.c_str());
+			if (d == NULL) return false;
+			closedir(d);
+			return true;
+		}
+		fclose(f);
+		return true;
+	}
+
+	// Первый существующий каталог из списка
+	static std::string dir_first(const std::vector<std::string>& list) {
+		for (auto& d : list) {
+			if (file_exists(d)) return d;
+		}
+		return list.back();
+	}
+
+	// Количество процессоров в файле cpuset, 0 - нет данных
+	static int cpuset_read(const std::string& dir, const char* name) {
+		char buf[1024];
+		if (!file_str((dir + "/" + name).c_str(), buf, sizeof(buf))) return 0;
+		return (int)list_parse(buf).size();
+	}
+
+	// Чтение ограничений cgroup v1/v2. root - точка монтирования cgroup
+	static lite_cpu_limit_t cgroup_read(const std::string& root) {
+		lite_cpu_limit_t cl = { 0, 0, 0 };
+		// Пути группы процесса из /proc/self/cgroup: "0::/path" для v2, "N:cpu,cpuacct:/path" для v1
+		std::string path_v2, path_cpu, path_cpuset;
+		FILE* f = fopen("/proc/self/cgroup", "r");
+		if (f != NULL) {
+			char buf[1024];
+			while (fgets(buf, sizeof(buf), f) != NULL) {
+				char* p1 = strchr(buf, ':');
+				char* p2 = (p1 == NULL ? NULL : strchr(p1 + 1, ':'));
+				if (p2 == NULL) continue;
+				std::string ctrl(p1 + 1, p2);
+				std::string path(p2 + 1);
+				while (!path.empty() && (path.back() == '\n' || path.back() == '\r')) path.pop_back();
+				if (path == "/") path.clear();
+				if (ctrl.empty()) path_v2 = path;
+				ctrl = "," + ctrl + ",";
+				if (ctrl.find(",cpu,") != std::string::npos) path_cpu = path;
+				if (ctrl.find(",cpuset,") != std::string::npos) path_cpuset = path;
+			}
+			fclose(f);
+		}
+
+		if (file_exists(root + "/cgroup.controllers") || file_exists(root + "/cpu.max")) { // cgroup v2
+			std::string dir = root + path_v2;
+			if (!file_exists(dir)) dir = root; // Внутри контейнера группа смонтирована как корень
+			// Квота с учетом всех родительских групп
+			for (std::string d = dir; ; ) {
+				char buf[128], max[32];
+				long long period = 0;
+				if (file_str((d + "/cpu.max").c_str(), buf, sizeof(buf)) && sscanf(buf, "%31s %lld", max, &period) == 2 && strcmp(max, "max") != 0 && period > 0) {
+					double q = atof(max) / period;
+					if (q > 0 && (cl.quota == 0 || q < cl.quota)) cl.quota = q;
+				}
+				if (d.size() <= root.size()) break;
+				d.resize(d.rfind('/'));
+			}
+			cl.cpuset = cpuset_read(dir, "cpuset.cpus.effective");
+			if (cl.cpuset == 0) cl.cpuset = cpuset_read(dir, "cpuset.cpus");
+		} else { // cgroup v1
+			std::string dir = dir_first({ root + "/cpu,cpuacct" + path_cpu, root + "/cpu" + path_cpu, root + "/cpu,cpuacct", root + "/cpu", root });
+			int64_t quota = file_int((dir + "/cpu.cfs_quota_us").c_str(), -1);
+			int64_t period = file_int((dir + "/cpu.cfs_period_us").c_str(), 0);
+			if (quota > 0 && period > 0) cl.quota = (double)quota / period;
+			dir = dir_first({ root + "/cpuset" + path_cpuset, root + "/cpuset", root });
+			cl.cpuset = cpuset_read(dir, "cpuset.effective_cpus");
+			if (cl.cpuset == 0) cl.cpuset = cpuset_read(dir, "cpuset.cpus");
+		}
+		return cl;
+	}
+
+	static void detect(lite_cpu_info_t& ci) {
+		std::vector<int64_t> core_keys, l3_keys;
+		char path[128];
+		for (int id : cpu_allowed()) {
+			lite_cpu_info_t::cpu_t c;
+			c.id = id;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", id);
+			int64_t package = file_int(path, 0);
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", id);
+			int64_t core = file_int(path, id);
+			c.core = num_get(core_keys, (package << 32) | (core & 0xFFFFFFFF));
+			c.l3 = num_get(l3_keys, l3_key(id));
+			c.numa = numa_node(id);
+			ci.cpu.push_back(c);
+		}
+		totals(ci, core_keys, l3_keys);
+	}
+#else
+	static void detect(lite_cpu_info_t& ci) {
+		DWORD_PTR mask_proc = 0, mask_sys = 0;
+		if (!GetProcessAffinityMask(GetCurrentProcess(), &mask_proc, &mask_sys) || mask_proc == 0) {
+			SYSTEM_INFO sysinfo;
+			GetSystemInfo(&sysinfo);
+			mask_proc = (sysinfo.dwNumberOfProcessors >= sizeof(DWORD_PTR) * 8) ? ~(DWORD_PTR)0 : (((DWORD_PTR)1 << sysinfo.dwNumberOfProcessors) - 1);
+		}
+		// Описание процессоров от системы
+		std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info;
+		DWORD len = 0;
+		if (!GetLogicalProcessorInformation(NULL, &len) && GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
+			info.resize(len / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+			if (!GetLogicalProcessorInformation(info.data(), &len)) info.clear();
+		}
+		std::vector<int64_t> core_keys, l3_keys;
+		for (int id = 0; id < (int)sizeof(DWORD_PTR) * 8; id++) {
+			DWORD_PTR bit = (DWORD_PTR)1 << id;
+			if ((mask_proc & bit) == 0) continue;
+			int64_t core = id, l3 = 0;
+			int numa = 0;
+			for (size_t i = 0; i < info.size(); i++) {
+				if ((info[i].ProcessorMask & bit) == 0) continue;
+				if (info[i].Relationship == RelationProcessorCore) {
+					core = (int64_t)i;
+				} else if (info[i].Relationship == RelationCache && info[i].Cache.Level == 3) {
+					l3 = (int64_t)i;
+				} else if (info[i].Relationship == RelationNumaNode) {
+					numa = (int)info[i].NumaNode.NodeNumber;
+				}
+			}
+			lite_cpu_info_t::cpu_t c;
+			c.id = id;
+			c.core = num_get(core_keys, core);
+			c.l3 = num_get(l3_keys, l3);
+			c.numa = numa;
+			ci.cpu.push_back(c);
+		}
+		totals(ci, core_keys, l3_keys);
+	}
+#endif
+
+public:
+	// Описание процессоров, определяется при первом обращении
+	static const lite_cpu_info_t& info() {
+		static lite_cpu_info_t ci;
+		static std::once_flag once;
+		std::call_once(once, []() {
+			detect(ci);
+			if (ci.cpu_count <= 0) { // Нет данных
+				lite_cpu_info_t::cpu_t c = { 0, 0, 0, 0 };
+				ci.cpu.assign(1, c);
+				ci.cpu_count = ci.core_count = ci.smt = ci.l3_count = ci.numa_count = 1;
+			}
+		});
+		return ci;
+	}
+
+	// Ограничение процессоров. reload = true перечитать, root != NULL задать каталог cgroup
+	static lite_cpu_limit_t limit(bool reload = false, const char* root = NULL) {
+		static lite_mutex_t mtx;
+		static lite_cpu_limit_t cl = { 0, 0, 0 };
+		static std::string cg_root = LT_CGROUP_ROOT;
+		lite_lock_t lck(mtx);
+		if (root != NULL) cg_root = root;
+		if (cl.limit == 0 || reload || root != NULL) {
+			#ifndef LT_WIN
+			cl = cgroup_read(cg_root);
+			#endif
+			int n = info().cpu_count;
+			if (cl.quota > 0 && cl.quota < n) n = (int)(cl.quota + 0.999); // Округление вверх
+			if (cl.cpuset > 0 && cl.cpuset < n) n = cl.cpuset;
+			cl.limit = (n > 0 ? n : 1);
+		}
+		return cl;
+	}
+
+	// Периодическое перечитывание ограничений (LT_CGROUP_RELOAD_MS). Возвращает true при изменении
+	static bool limit_update() {
+		if (LT_CGROUP_RELOAD_MS <= 0) return false;
+		static std::atomic<int64_t> next = { 0 };
+		int64_t now = lite_time_now();
+		int64_t t = next;
+		if (now < t || !next.compare_exchange_strong(t, now + LT_CGROUP_RELOAD_MS)) return false;
+		int prev = limit().limit;
+		return limit(true).limit != prev;
+	}
+
+	// Предел ресурса по умолчанию
+	static int resource_default_max() {
+		return LT_RESOURCE_DEFAULT > 0 ? LT_RESOURCE_DEFAULT : limit().limit;
+	}
+
+	// Количество процессоров узла NUMA
+	static int numa_cpu_count(int numa) {
+		int n = 0;
+		for (auto& c : info().cpu) {
+			if (c.numa == numa) n++;
+		}
+		return n;
+	}
+
+	// Привязка текущего потока: numa >= 0 ко всем процессорам узла, иначе к процессору номер n по кругу
+	static bool pin(int numa, size_t n) {
+		const std::vector<lite_cpu_info_t::cpu_t>& cpu = info().cpu;
+		std::vector<int> ids;
+		if (numa >= 0) {
+			for (auto& c : cpu) {
+				if (c.numa == numa) ids.push_back(c.id);
+			}
+		} else {
+			ids.push_back(cpu[n % cpu.size()].id);
+		}
+		if (ids.empty()) return false;
+		#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int id : ids) {
+			if (id < CPU_SETSIZE) CPU_SET(id, &set);
+		}
+		return sched_setaffinity(0, sizeof(set), &set) == 0;
+		#elif defined(LT_WIN)
+		DWORD_PTR mask = 0;
+		for (int id : ids) {
+			if (id < (int)sizeof(mask) * 8) mask |= (DWORD_PTR)1 << id;
+		}
+		return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+		#else
+		return false;
+		#endif
+	}
+
+	// Установка политики планирования текущего потока. Возвращает примененную политику: если политика
+	// не разрешена (SCHED_FIFO без прав), то поток остается с LT_SCHED_NORMAL. Отказ в установке 
+	// отрицательного nice без прав игнорируется
+	static lite_sched_t sched_set(lite_sched_t policy, int prio) noexcept {
+		#if defined(__linux__)
+		struct sched_param sp;
+		sp.sched_priority = 0;
+		int pol = SCHED_OTHER;
+		if (policy == LT_SCHED_BATCH) {
+			pol = SCHED_BATCH;
+		} else if (policy == LT_SCHED_IDLE) {
+			pol = SCHED_IDLE;
+		} else if (policy == LT_SCHED_FIFO) {
+			pol = SCHED_FIFO;
+			sp.sched_priority = (prio < 1 ? 1 : (prio > 99 ? 99 : prio));
+		}
+		if (pol != SCHED_OTHER && pthread_setschedparam(pthread_self(), pol, &sp) != 0) {
+			if (policy == LT_SCHED_FIFO) prio = 0;
+			policy = LT_SCHED_NORMAL;
+		}
+		if ((policy == LT_SCHED_NORMAL || policy == LT_SCHED_BATCH) && prio != 0) {
+			setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), prio); // nice потока
+		}
+		return policy;
+		#elif defined(LT_WIN)
+		int p = THREAD_PRIORITY_NORMAL;
+		if (policy == LT_SCHED_BATCH) {
+			p = THREAD_PRIORITY_BELOW_NORMAL;
+		} else if (policy == LT_SCHED_IDLE) {
+			p = THREAD_PRIORITY_IDLE;
+		} else if (policy == LT_SCHED_FIFO) {
+			p = THREAD_PRIORITY_HIGHEST;
+		} else if (prio > 0) {
+			p = THREAD_PRIORITY_BELOW_NORMAL;
+		} else if (prio < 0) {
+			p = THREAD_PRIORITY_ABOVE_NORMAL;
+		}
+		if (p != THREAD_PRIORITY_NORMAL && SetThreadPriority(GetCurrentThread(), p) == 0) policy = LT_SCHED_NORMAL;
+		return policy;
+		#else
+		return LT_SCHED_NORMAL;
+		#endif
+	}
+
+	// Имя текущего потока (видно в top -H, отладчике). Linux - не больше 15 символов
+	static void thread_name_set(const std::string& name) noexcept {
+		#if defined(__linux__)
+		pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+		#endif
+	}
+};
+
+//----------------------------------------------------------------------------------
+//----------------------------------------------------------------------------------
+//----------------------------------------------------------------------------------
+class lite_actor_t;
+class lite_thread_t;
+class lite_resource_t;
+class lite_msg_queue_t;
+class lite_timer_t;
+class lite_shard_t;
+struct lite_msg_t;
+
+static void lite_log(int err, const char* data, ...) noexcept;
+static size_t lite_thread_num() noexcept;
+static void lite_thread_wake_up() noexcept;
+static void lite_thread_wake_up_numa(int numa) noexcept;
+static void lite_thread_wake_up_prefer(int numa, size_t num) noexcept;
+static void lite_timer_run(lite_actor_t* actor, int time_ms) noexcept;
+static void lite_timer_once(lite_actor_t* actor, int time_ms) noexcept;
+static int lite_shard_home() noexcept;
+static bool lite_shard_push(int home, lite_actor_t* la, lite_msg_t* msg) noexcept;
+static void lite_thread_wake_up_block(int numa) noexcept;
+
+// Состояние блокирующего вызова потока. Заполняется потоком, читается регулятором
+struct lite_block_t {
+	std::atomic<lite_resource_t*> res_used = { NULL };	// Захваченный потоком ресурс
+	std::atomic<lite_resource_t*> res_lent = { NULL };	// Ресурс, единица которого выдана взаймы на время блокировки
+	std::atomic<int> scope = { 0 };						// Вложенность lite_blocking_scope
+};
+
+// Уровни приоритета акторов
+enum lite_priority_t {
+	LT_PRIORITY_HIGH = 0,	// Управляющие акторы (здоровье, настройки)
+	LT_PRIORITY_NORMAL,		// По умолчанию
+	LT_PRIORITY_LOW,		// Фоновые
+	LT_PRIORITY_LEVELS
+};
+
+#ifndef LT_PRIORITY_WEIGHTS
+#define LT_PRIORITY_WEIGHTS 4, 2, 1 // Доли уровней HIGH, NORMAL, LOW при взвешенном выборе
+#endif
+
+#ifndef LT_PRIORITY_AGING
+#define LT_PRIORITY_AGING 8 // Сколько переборов готовый актор может быть обойден, после этого выбирается как HIGH
+#endif
+
+#ifndef LT_PRIORITY_SCAN
+#define LT_PRIORITY_SCAN 16 // Перебор списка акторов через столько выборов из кэша (для старения обойденных)
+#endif
+
+#ifndef LT_OLDEST_BUCKET_US
+#define LT_OLDEST_BUCKET_US 1000 // Точность выбора старейшего сообщения, мксек. Метки в одном интервале равны
+#endif
+
+#ifndef LT_METRICS_SHARDS
+#define LT_METRICS_SHARDS 8 // Частей счетчиков актора (по номеру потока), чтобы потоки не писали в одну строку кэша
+#endif
+
+#ifndef LT_HIST_SUB_BITS
+#define LT_HIST_SUB_BITS 3 // Гистограммы задержек: 2^LT_HIST_SUB_BITS интервалов на каждое удвоение (погрешность до 12.5%)
+#endif
+
+#ifndef LT_HIST_MAX_BITS
+#define LT_HIST_MAX_BITS 40 // Гистограммы задержек: предел 2^LT_HIST_MAX_BITS нсек. (18 мин.), больше - в последний интервал
+#endif
+
+#define LT_HIST_BUCKETS ((LT_HIST_MAX_BITS + 1 - LT_HIST_SUB_BITS) << LT_HIST_SUB_BITS) // Интервалов гистограммы
+
+#ifndef LT_TRACE_RING
+#define LT_TRACE_RING 16384 // Событий в кольцевом буфере трассировки потока (степень двойки), старые перезаписываются
+#endif
+
+#ifndef LT_STEAL_DELAY_US
+#define LT_STEAL_DELAY_US 0 // Сколько мксек. актор ждет свой прошлый поток, прежде чем его возьмет другой. 0 - не ждет
+#endif
+
+#ifndef LT_THREAD_CREATE_US
+#define LT_THREAD_CREATE_US 500 // Новый поток создается не чаще раза в LT_THREAD_CREATE_US мксек.
+#endif
+
+#ifndef LT_MONITOR_MS
+#define LT_MONITOR_MS 100 // Период (окно) регулятора количества потоков, мсек.
+#endif
+
+#ifndef LT_UTIL_HIGH
+#define LT_UTIL_HIGH 90 // Загрузка потоков, %, выше которой при наличии готовых акторов добавляется поток
+#endif
+
+#ifndef LT_UTIL_LOW
+#define LT_UTIL_LOW 50 // Загрузка потоков без одного, %, ниже которой поток лишний
+#endif
+
+#ifndef LT_BLOCK_CPU
+#define LT_BLOCK_CPU 20 // Поток, занятый все окно регулятора и использовавший процессор меньше этого %, считается заблокированным
+#endif
+
+#ifndef LT_BLOCK_LEND_MAX
+#define LT_BLOCK_LEND_MAX 64 // Максимум единиц ресурса, одновременно выданных взаймы
+#endif
+
+#ifndef LT_POOL_CLASS
+#define LT_POOL_CLASS 1024 // Класс потоков первого выделенного пула. Меньшие - узлы NUMA
+#endif
+
+#ifndef LT_SHRINK_TICKS
+#define LT_SHRINK_TICKS 10 // Сколько окон подряд поток должен быть лишним, чтобы его убрать
+#endif
+
+#ifndef LT_LIFO_MAX
+#define LT_LIFO_MAX 64 // Сколько раз подряд поток может выполнить актор из слота LIFO, затем берет из общего кэша
+#endif
+
+#ifndef LT_SHARD_RING
+#define LT_SHARD_RING 1024 // Размер буфера между парой потоков режима "поток на ядро"
+#endif
+
+#ifndef LT_SHARD_SPIN
+#define LT_SHARD_SPIN 2000 // Проверок входящих перед засыпанием потока режима "поток на ядро"
+#endif
+
+#define LT_SHARD_DESTROY ((lite_msg_t*)1) // Команда удаления актора в его потоке
+
+// Включенные возможности, которым нужны проверки на пути сообщения (отправка, выбор и запуск актора).
+// Пока ни одна не включена, путь читает одно слово вместо флага каждой возможности
+class lite_opt_t {
+	static std::atomic<uint32_t>& word() noexcept {
+		static std::atomic<uint32_t> x(LT_STEAL_DELAY_US > 0 ? 128 : 0); // Постоянная инициализация, без проверки при обращении
+		return x;
+	}
+
+public:
+	enum bit_t {
+		LT_OPT_METRICS	= 1,	// Счетчики акторов (lite_stats_enable())
+		LT_OPT_LATENCY	= 2,	// Гистограммы задержек
+		LT_OPT_E2E		= 4,	// Выборка сквозной трассировки
+		LT_OPT_TRACE	= 8,	// Трассировка
+		LT_OPT_GRAPH	= 16,	// Граф обменов
+		LT_OPT_STAMP	= 32,	// Выбор старейшего сообщения
+		LT_OPT_PRIO		= 64,	// Есть акторы с приоритетом не по умолчанию
+		LT_OPT_AFFINITY	= 128	// Ожидание своего потока (lite_thread_affinity())
+	};
+
+	static uint32_t get() noexcept {
+		return word().load(std::memory_order_relaxed);
+	}
+
+	static bool on(uint32_t bit) noexcept {
+		return (get() & bit) != 0;
+	}
+
+	static void set(uint32_t bit, bool on) noexcept {
+		if (on) {
+			word().fetch_or(bit, std::memory_order_relaxed);
+		} else {
+			word().fetch_and(~bit, std::memory_order_relaxed);
+		}
+	}
+};
+
+//----------------------------------------------------------------------------------
+//-------- СООБЩЕНИE ---------------------------------------------------------------
+//----------------------------------------------------------------------------------
+// Запрос сквозной трассировки сообщения. Выделяется только отслеживаемым (по выборке lite_e2e_sample())
+struct lite_msg_e2e_t {
+	uint64_t trace_id;	// Номер запроса
+	int64_t origin;		// Начало запроса, нсек. (lite_clock_ns)
+};
+
+// Поля расположены так, чтобы сообщение без данных занимало 64 байта (одна кэшлиния)
+struct lite_msg_t : public lite_align64_t {
+public:
+	size_t type = {0};		// Тип сообщения
+	int16_t weight = {0};	// Вес обработки сообщения в единицах ресурса актора, 0 - вес актора
+	int8_t priority = {LT_PRIORITY_NORMAL}; // Полоса очереди получателя: HIGH извлекается раньше, LOW позже остальных
+	int tokens = {0};		// Стоимость в токенах ограничения скорости ресурса (операции, байты), 0 - 1 токен
+	uint32_t bytes = {0};	// Объем данных для графа обменов (буферы, строки), 0 - sizeof типа при отправке
+	uint32_t flow = {0};	// Номер связи отправки с обработкой в трассировке, 0 - отправка не записана
+	int64_t time = {0};		// Время постановки в очередь, нсек. (lite_clock_ns), если включен выбор старейшего
+	int64_t deadline = {0};	// Срок актуальности, нсек. (lite_clock_ns). После него не обрабатывается, 0 - без срока
+
+	friend lite_msg_queue_t;
+	friend lite_actor_t;
+protected:
+	lite_msg_t* next = {0};	// Указатель на следующее сообщение в очереди
+	lite_msg_e2e_t* e2e = {0}; // Запрос сквозной трассировки, NULL - не отслеживается
+
+	// Установка запроса сквозной трассировки, trace_id = 0 - не отслеживается
+	void e2e_set(uint64_t trace_id, int64_t origin) noexcept {
+		if (trace_id == 0) {
+			delete e2e;
+			e2e = NULL;
+			return;
+		}
+		if (e2e == NULL) e2e = new lite_msg_e2e_t;
+		e2e->trace_id = trace_id;
+		e2e->origin = origin;
+	}
+
+public:
+
+	lite_msg_t() {}
+
+	lite_msg_t(const lite_msg_t& m) {
+		type = m.type;
+		weight = m.weight;
+		tokens = m.tokens;
+		priority = m.priority;
+		bytes = m.bytes;
+		deadline = m.deadline;
+		if (m.e2e != NULL) e2e_set(m.e2e->trace_id, m.e2e->origin); // Копия продолжает запрос
+	}
+
+	lite_msg_t& operator=(const lite_msg_t& m) {
+		if (this == &m) return *this;
+		type = m.type;
+		weight = m.weight;
+		tokens = m.tokens;
+		priority = m.priority;
+		bytes = m.bytes;
+		deadline = m.deadline;
+		e2e_set(m.trace_id_get(), m.origin_get());
+		return *this;
+	}
+
+	virtual ~lite_msg_t() {
+		delete e2e;
+	}
+
+	// Номер запроса сквозной трассировки, 0 - не отслеживается
+	uint64_t trace_id_get() const noexcept {
+		return e2e != NULL ? e2e->trace_id : 0;
+	}
+
+	// Начало запроса сквозной трассировки, нсек. (lite_clock_ns)
+	int64_t origin_get() const noexcept {
+		return e2e != NULL ? e2e->origin : 0;
+	}
+
+	void *operator new(size_t size) {
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_msg_create++;
+		#endif
+		return lite_align64_t::operator new(size);
+	}
+
+	void operator delete(void *p) {
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_msg_erase++;
+		#endif
+		lite_align64_t::operator delete(p);
+	}
+
+	// Размещение на узле NUMA ресурса или актора-получателя: new(res) msg_t, new(actor) msg_t
+	void *operator new(size_t size, lite_resource_t* res);
+	void *operator new(size_t size, lite_actor_t* la);
+
+	void operator delete(void *p, lite_resource_t*) {
+		operator delete(p);
+	}
+
+	void operator delete(void *p, lite_actor_t*) {
+		operator delete(p);
+	}
+
+	// Срок актуальности через ms мсек. от текущего момента
+	void ttl_set(int ms) noexcept {
+		deadline = lite_clock_ns() + (int64_t)ms * 1000000;
+	}
+
+	// Начало нового запроса сквозной трассировки с этого сообщения (по выборке lite_e2e_sample())
+	void trace_begin() noexcept;
+
+	// Окончание запроса: задержка от начала записывается текущему актору, сообщение больше не отслеживается
+	void trace_end() noexcept;
+
+	// Установка типа сообщения по классу
+	template <typename T>
+	static void type_set(T* msg) {
+		if(msg->type == 0) msg->type = typeid(T).hash_code();
+	}
+
+private:
+	// static переменные глобальные ----------------------------------------------------
+	typedef std::unordered_map<size_t, std::string> type_name_idx_t;
+
+	struct static_info_t : public lite_static_info_t<static_info_t> {
+		type_name_idx_t tn_idx; // Список типов
+		lite_mutex_t mtx;		// Блокировка для доступа к tn_idx
+	};
+
+	static static_info_t& si() noexcept {
+		return static_info_t::si();
+	}
+
+public:
+	// Вывод типа сообщения
+	template <typename T>
+	static size_t type_get() noexcept {
+		size_t hash = typeid(T).hash_code();
+		lite_lock_t lck(si().mtx); // Блокировка
+		// Сохранение названия типа
+		if (si().tn_idx.find(hash) == si().tn_idx.end()) {
+			si().tn_idx[hash] = typeid(T).name();
+		}
+		return hash;
+	}
+
+	// Тип сообщения строкой
+	const std::string type_descr() {
+		return type_name(type);
+	}
+
+	// Название типа по номеру
+	static std::string type_name(size_t type) {
+		lite_lock_t lck(si().mtx); // Блокировка
+		type_name_idx_t::iterator it = si().tn_idx.find(type);
+		if (it == si().tn_idx.end()) {
+			std::string t = "type#";
+			t += std::to_string(type);
+			return t;
+		} else {
+			return it->second;
+		}
+	}
+};
+
+//----------------------------------------------------------------------------------
+//-------- ОЧЕРЕДЬ СООБЩЕНИЙ -------------------------------------------------------
+//----------------------------------------------------------------------------------
+
+// Полоса NORMAL хранится в msg_first/msg_first2/msg_last и читается без блокировки. Полосы HIGH и LOW
+// используются, только пока в них есть сообщения (lane_count != 0), и всегда под блокировкой.
+// Внутри полосы порядок FIFO
+class lite_msg_queue_t {
+	lite_msg_t* msg_first;			// Указатель на первое в очереди
+	lite_msg_t* msg_first2;			// Указатель на первое в очереди, меняется только под блокировкой
+	lite_msg_t* msg_last;			// Указатель на последнее в очереди
+	lite_msg_t* lane_first[2];		// Первое в полосах HIGH и LOW
+	lite_msg_t* lane_last[2];		// Последнее в полосах HIGH и LOW
+	std::atomic<size_t> lane_count;	// Сообщений в полосах HIGH и LOW
+	std::atomic<int64_t> head_time;	// Метка времени старейшего сообщения, 0 - нет меток
+	lite_mutex_t mtx;				// Синхронизация доступа
+	// Длина очереди: pushed - popped. Каждый счетчик меняет один поток за раз (добавление под блокировкой,
+	// извлечение - единственный читатель или под блокировкой), поэтому без атомарного сложения
+	std::atomic<size_t> pushed;		// Добавлено
+	std::atomic<size_t> popped;		// Извлечено
+	std::atomic<size_t> peak;		// Максимум длины, меняется под блокировкой
+
+	// Пересчет head_time по началам полос. Под блокировкой, только из потока, извлекающего сообщения
+	LT_NOINLINE void head_update() noexcept {
+		lite_msg_t* head[3] = { lane_first[0], (msg_first != NULL ? msg_first : msg_first2), lane_first[1] };
+		int64_t t = 0;
+		for (int i = 0; i < 3; i++) {
+			if (head[i] != NULL && head[i]->time != 0 && (t == 0 || head[i]->time < t)) t = head[i]->time;
+		}
+		head_time = t;
+	}
+
+	// Номер дополнительной полосы: 0 - HIGH, 1 - LOW, -1 - основная
+	static int lane(const lite_msg_t* msg) noexcept {
+		if (msg->priority < LT_PRIORITY_NORMAL) return 0;
+		if (msg->priority > LT_PRIORITY_NORMAL) return 1;
+		return -1;
+	}
+
+	// Учет извлечения (n = 1) или возврата (n = -1) сообщения
+	void popped_add(size_t n) noexcept {
+		popped.store(popped.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	// Извлечение из дополнительной полосы. Под блокировкой
+	lite_msg_t* lane_pop(int n) noexcept {
+		lite_msg_t* msg = lane_first[n];
+		if (msg != NULL) {
+			lane_first[n] = msg->next;
+			if (lane_first[n] == NULL) lane_last[n] = NULL;
+			lane_count--;
+		}
+		return msg;
+	}
+
+	// Извлечение при непустых полосах: HIGH раньше основной, LOW после нее. Под блокировкой, снимает ее,
+	// если сообщение взято из полосы. NULL - брать из основной
+	LT_NOINLINE lite_msg_t* lane_pop_any() noexcept {
+		lite_msg_t* msg = lane_pop(0);
+		if (msg == NULL && msg_first == NULL && msg_first2 == NULL) msg = lane_pop(1);
+		if (msg != NULL) {
+			if (head_time != 0) head_update();
+			popped_add(1);
+			mtx.unlock(); // Снятие блокировки
+			#ifdef LT_DEBUG
+			msg->next = NULL;
+			#endif
+		}
+		return msg;
+	}
+
+public:
+	lite_msg_queue_t() : msg_first(NULL), msg_first2(NULL), msg_last(NULL), lane_first(), lane_last(), lane_count(0), head_time(0),
+		pushed(0), popped(0), peak(0) {
+	}
+
+	// Добавление сообщения в очередь. stamp = true метка времени (выбор старейшего, срок в очереди, задержки).
+	// Возвращает true, если очередь была пуста (проверка под блокировкой)
+	bool push(lite_msg_t* msg, bool stamp = false) noexcept {
+		msg->next = NULL;
+		msg->time = (stamp ? lite_clock_ns() : 0);
+		lite_lock_t lck(mtx); // Блокировка
+		bool was_empty = (msg_last == NULL && lane_count == 0);
+		if (msg->time != 0 && head_time == 0) head_time = msg->time; // Остальные сообщения не старше
+		int n = lane(msg);
+		if (n >= 0) {
+			if (lane_last[n] == NULL) {
+				lane_first[n] = msg;
+			} else {
+				lane_last[n]->next = msg;
+			}
+			lane_last[n] = msg;
+			lane_count++;
+		} else if(msg_last == NULL) {
+			msg_first2 = msg;
+			msg_last = msg;
+		} else {
+			msg_last->next = msg;
+			msg_last = msg;
+		}
+		size_t n_push = pushed.load(std::memory_order_relaxed) + 1;
+		pushed.store(n_push, std::memory_order_relaxed);
+		size_t len = n_push - popped.load(std::memory_order_relaxed);
+		if (len <= n_push && len > peak.load(std::memory_order_relaxed)) peak.store(len, std::memory_order_relaxed);
+		#ifdef LT_STAT_QUEUE
+		if (lite_thread_stat_t::ti().stat_queue_max < len) lite_thread_stat_t::ti().stat_queue_max = len;
+		#endif
+		return was_empty;
+	}
+
+	// Чтение сообщения из очереди. lock = false без блокировки использовать msg_first
+	lite_msg_t* pop(bool lock = true) noexcept {
+		if (lock) {
+			mtx.lock(); // Блокировка
+		}
+		if (lane_count != 0) {
+			// Есть сообщения в дополнительных полосах
+			if (!lock) {
+				mtx.lock(); // Блокировка
+				lock = true;
+			}
+			lite_msg_t* msg = lane_pop_any();
+			if (msg != NULL) return msg;
+		}
+		if (msg_first == NULL) {
+			if (!lock) {
+				mtx.lock(); // Блокировка для доступа к msg_first2
+				lock = true;
+			}
+			msg_first = msg_first2;
+			msg_first2 = NULL;
+		}
+		lite_msg_t* msg = msg_first;
+
+		if(msg != NULL) {
+			msg_first = msg->next; // Чтение без блокировки
+			if (msg_first == NULL) {
+				if(!lock) {
+					mtx.lock(); // Блокировка для доступа к msg_last
+					lock = true;
+				}
+				msg_first = msg->next; // Повторное чтение под блокировкой на случай если был push
+				if(msg_first == NULL) msg_last = NULL;
+			}
+			if (head_time != 0) {
+				if (lock) {
+					head_update();
+				} else {
+					head_time = msg_first->time; // Без блокировки: полосы HIGH и LOW не учитываются
+				}
+			}
+		}
+		if (msg != NULL) popped_add(1);
+		if (lock) mtx.unlock(); // Снятие блокировки
+
+		#ifdef LT_DEBUG
+		if(msg != NULL) msg->next = NULL;
+		#endif
+		return msg;
+	}
+
+	// Возврат извлеченного сообщения в начало очереди. Только из потока, извлекшего сообщение
+	void push_front(lite_msg_t* msg) noexcept {
+		lite_lock_t lck(mtx); // Блокировка
+		popped_add((size_t)-1);
+		if (msg->time != 0 && (head_time == 0 || msg->time < head_time)) head_time = msg->time;
+		int n = lane(msg);
+		if (n >= 0) {
+			msg->next = lane_first[n];
+			lane_first[n] = msg;
+			if (lane_last[n] == NULL) lane_last[n] = msg;
+			lane_count++;
+			return;
+		}
+		if (msg_first == NULL) {
+			msg_first = msg_first2;
+			msg_first2 = NULL;
+		}
+		msg->next = msg_first;
+		msg_first = msg;
+		if (msg_last == NULL) msg_last = msg;
+	}
+
+	int empty() noexcept {
+		return msg_last == NULL && lane_count == 0;
+	}
+
+	// Длина очереди. Из другого потока - приблизительно, во время добавления или извлечения
+	size_t size() const noexcept {
+		size_t a = popped.load(std::memory_order_relaxed);
+		size_t b = pushed.load(std::memory_order_relaxed);
+		return (b >= a ? b - a : 0);
+	}
+
+	// Максимум длины с создания или peak_reset()
+	size_t peak_get() const noexcept {
+		return peak.load(std::memory_order_relaxed);
+	}
+
+	void peak_reset() noexcept {
+		lite_lock_t lck(mtx); // Блокировка
+		peak.store(size(), std::memory_order_relaxed);
+	}
+
+	// Метка времени старейшего сообщения, 0 - пусто или без меток
+	int64_t head_get() const noexcept {
+		return head_time;
+	}
+
+	// Включение меток времени при добавлении
+	static void stamp_set(bool on) noexcept {
+		lite_opt_t::set(lite_opt_t::LT_OPT_STAMP, on);
+	}
+
+	static bool stamp_get() noexcept {
+		return lite_opt_t::on(lite_opt_t::LT_OPT_STAMP);
+	}
+};
+
+//----------------------------------------------------------------------------------
+//------ КЭШ АКТОРОВ ГОТОВЫХ К ВЫПОЛНЕНИЮ ------------------------------------------
+//----------------------------------------------------------------------------------
+class lite_actor_cache_t {
+	std::atomic<lite_actor_t*> next = {0};
+
+public:
+	// Запись в кэш
+	void push(lite_actor_t* la) noexcept {
+		if(next == (lite_actor_t*)NULL) {
+			lite_actor_t* nul = NULL;
+			if (next.compare_exchange_weak(nul, la)) return;
+		}
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_cache_full++;
+		#endif	
+	}
+
+	// Извлечение из кэша
+	lite_actor_t* pop() noexcept {
+		if(next == (lite_actor_t*)NULL) return NULL;
+		return next.exchange(NULL);
+	}
+
+	bool empty() const noexcept {
+		return next == (lite_actor_t*)NULL;
+	}
+};
+
+//----------------------------------------------------------------------------------
+//------ РЕСУРС --------------------------------------------------------------------
+//----------------------------------------------------------------------------------
+class lite_resource_manage_t;
+
+// Выделенный пул потоков ресурса
+struct lite_pool_t {
+	int cls;				// Класс потоков пула: LT_POOL_CLASS + номер пула
+	int min;				// Потоков создается сразу и не завершается
+	int max;				// Максимум потоков
+	int numa;				// Узел NUMA ресурса, потоки пула привязываются к его процессорам
+	lite_sched_t policy;	// Политика планирования
+	int prio;				// nice или приоритет SCHED_FIFO
+	std::string name;		// Имя потоков, к нему добавляется номер потока
+	std::atomic<int> policy_set;// Примененная потоками политика, -1 еще не применялась
+};
+
+class lite_resource_t : public lite_align64_t {
+	std::atomic<int> res_free;	// Свободное количество
+	int res_max;				// Максимум
+	int numa = {-1};			// Узел NUMA, на котором выполняются акторы ресурса. -1 любой
+	std::atomic<int> res_lent = { 0 };	// Выдано взаймы заблокированным потокам
+	std::atomic<int> res_reserve = { 0 };	// Вес самого тяжелого ожидающего захвата, которому не хватило свободных. Более легкие его не обгоняют
+	lite_mutex_t mtx_reserve;	// Блокировка reserve_count
+	std::map<int, int> reserve_count;	// Резервов по весу: каждый держит актор, пока ждет захвата
+	lite_resource_t* parent = { NULL };	// Родительский ресурс, захватывается вместе с этим
+	lite_mutex_t mtx_rate;		// Блокировка ведра токенов
+	double rate = { 0 };		// Ограничение скорости: пополнение ведра, токенов в секунду. 0 - нет ограничения
+	double burst = { 0 };		// Емкость ведра
+	double tokens = { 0 };		// Токенов в ведре
+	int64_t rate_time = { 0 };	// Время последнего пополнения, мксек.
+	bool lend_on = { false };	// Разрешена выдача взаймы
+	bool max_user = { false };	// Максимум задан пользователем, выданное взаймы не увеличивает предел потоков
+	lite_pool_t* pool = { NULL };	// Выделенный пул потоков, NULL - акторы выполняют общие потоки
+
+friend lite_resource_manage_t;
+private:
+	std::string name;			// Название ресурса
+
+public:
+	lite_actor_cache_t la_cache;
+	std::atomic<int> prio_ready = { 0 };	// Готовых акторов HIGH ресурса, ждущих выбора перебором
+
+	lite_resource_t() {
+		res_free = lite_cpu_topology_t::resource_default_max();
+		res_max = lite_cpu_topology_t::resource_default_max();
+	}
+
+	lite_resource_t(int max) : res_free(max), res_max(max) {
+	}
+	
+	~lite_resource_t() noexcept {
+		assert(res_free == res_max);
+		delete pool;
+	}
+
+	// Захват weight единиц только этого ресурса
+	bool lock_one(int weight) noexcept {
+		int reserve = res_reserve;
+		int free = res_free.fetch_sub(weight);
+		// Не хватает, либо занимаются единицы, зарезервированные для более тяжелого захвата
+		if (free < weight || (reserve > weight && free - weight < reserve)) {
+			res_free += weight;
+			return false;
+		}
+		return true;
+	}
+
+	// Достаточно ли свободных единиц только этого ресурса
+	bool is_free_one(int weight) noexcept {
+		int reserve = res_reserve;
+		int free = res_free;
+		return free >= weight && (reserve <= weight || free - weight >= reserve);
+	}
+
+	// Захват weight единиц ресурса и всех родительских: все или ничего. Возвращает true при успехе
+	bool lock(int weight = 1) noexcept {
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_res_lock++;
+		#endif
+		for (lite_resource_t* r = this; r != NULL; r = r->parent) {
+			if (!r->lock_one(weight)) {
+				for (lite_resource_t* u = this; u != r; u = u->parent) u->res_free += weight; // Откат захваченных
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Освобождение ресурса и родительских
+	void unlock(int weight = 1) noexcept {
+		for (lite_resource_t* r = this; r != NULL; r = r->parent) r->res_free += weight;
+	}
+
+	// Достаточно ли свободных единиц для захвата с весом weight
+	bool is_free(int weight = 1) noexcept {
+		for (lite_resource_t* r = this; r != NULL; r = r->parent) {
+			if (!r->is_free_one(weight)) return false;
+		}
+		return true;
+	}
+
+	// Ограничение скорости обработки сообщений акторами ресурса: per_sec токенов в секунду, не больше
+	// burst подряд (по умолчанию per_sec за 1 секунду). per_sec <= 0 - выключено
+	void rate_set(double per_sec, double burst_ = 0) noexcept {
+		lite_lock_t lck(mtx_rate);
+		if (burst_ <= 0) burst_ = per_sec;
+		burst = (burst_ < 1 ? 1 : burst_);
+		tokens = burst;
+		rate_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		rate = (per_sec > 0 ? per_sec : 0);
+	}
+
+	bool rate_on() const noexcept {
+		return rate > 0;
+	}
+
+	// Взятие n токенов. 0 - взяты, иначе через сколько мксек. их будет достаточно
+	int64_t rate_take(double n) noexcept {
+		lite_lock_t lck(mtx_rate);
+		if (rate <= 0) return 0;
+		if (n > burst) n = burst; // Больше емкости ведра не накопится
+		int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		tokens += (now - rate_time) * rate / 1000000;
+		if (tokens > burst) tokens = burst;
+		rate_time = now;
+		if (tokens >= n) {
+			tokens -= n;
+			return 0;
+		}
+		int64_t wait = (int64_t)((n - tokens) * 1000000 / rate) + 1;
+		return wait;
+	}
+
+	// Есть резерв для тяжелого захвата на ресурсе или родительских
+	bool is_reserved() const noexcept {
+		return is_reserved(0);
+	}
+
+	// Есть резерв для захвата тяжелее weight: уже захваченные единицы держать нельзя, их ждет тяжелый
+	bool is_reserved(int weight) const noexcept {
+		for (const lite_resource_t* r = this; r != NULL; r = r->parent) {
+			if (r->res_reserve.load(std::memory_order_relaxed) > weight) return true;
+		}
+		return false;
+	}
+
+	// Резервирование для захвата weight, которому не хватает свободных, на этом ресурсе и родительских:
+	// более легкие не занимают освобождающиеся единицы. Каждый вызов снимается своим unreserve()
+	void reserve(int weight) noexcept {
+		if (weight <= 1) return;
+		{
+			lite_lock_t lck(mtx_reserve); // Блокировка
+			reserve_count[weight]++;
+			if (res_reserve < weight) res_reserve = weight;
+		}
+		if (parent != NULL) parent->reserve(weight);
+	}
+
+	// Снятие резерва weight: захват выполнен или больше не ожидается. Действует самый тяжелый из оставшихся
+	void unreserve(int weight) noexcept {
+		if (weight <= 1) return;
+		{
+			lite_lock_t lck(mtx_reserve); // Блокировка
+			std::map<int, int>::iterator it = reserve_count.find(weight);
+			if (it != reserve_count.end() && --it->second == 0) reserve_count.erase(it);
+			res_reserve = (reserve_count.empty() ? 0 : reserve_count.rbegin()->first);
+		}
+		if (parent != NULL) parent->unreserve(weight);
+	}
+
+	// Установка родительского ресурса: захват этого ресурса занимает столько же единиц родителя,
+	// например "HDD" и "SSD" внутри "IO". Вызывать до запуска акторов ресурса
+	void parent_set(lite_resource_t* lr) noexcept {
+		for (lite_resource_t* p = lr; p != NULL; p = p->parent) {
+			if (p == this) return; // Цикл
+		}
+		parent = lr;
+	}
+
+	lite_resource_t* parent_get() const noexcept {
+		return parent;
+	}
+
+	// Максимальный вес захвата с учетом родительских
+	int weight_max() const noexcept {
+		int ret = res_max;
+		for (lite_resource_t* p = parent; p != NULL; p = p->parent) {
+			if (p->res_max < ret) ret = p->res_max;
+		}
+		return ret;
+	}
+
+	// Временное увеличение емкости на время блокировки потока, захватившего ресурс
+	void lend() noexcept {
+		res_lent++;
+		res_free++;
+	}
+
+	// Возврат выданного взаймы. Если единица уже занята, то свободных будет меньше 0 до ее освобождения
+	void reclaim() noexcept {
+		res_free--;
+		res_lent--;
+	}
+
+	// Максимум, заданный пользователем (lite_thread_max()): количество потоков не превышает его и при займах
+	void max_user_set(int max) noexcept {
+		max_set(max);
+		max_user = true;
+	}
+
+	// Разрешение выдачи взаймы. По умолчанию разрешено только ресурсу по умолчанию "CPU", у ресурсов
+	// вида "HDD" емкость ограничивает именно блокирующие операции
+	void lend_set(bool on) noexcept {
+		lend_on = on;
+	}
+
+	bool lend_get() const noexcept {
+		return lend_on;
+	}
+
+	// Выдано взаймы
+	int lent_get() const noexcept {
+		return res_lent;
+	}
+
+	// Установка максимума одновременно выполняющихся акторов
+	void max_set(int max) noexcept {
+		if (max <= 0) max = 1;
+		if (max == res_max) return;
+
+		res_free += max - res_max;
+		res_max = max;
+	}
+
+	// Получение имени
+	const std::string name_get() {
+		return name;
+	}
+
+	// Узел NUMA ресурса, -1 не привязан
+	int numa_get() const noexcept {
+		return numa;
+	}
+
+	// Класс потоков, выполняющих акторы ресурса: -1 общие, 0.. узла NUMA, LT_POOL_CLASS.. выделенного пула
+	int thread_class() const noexcept {
+		return pool != NULL ? pool->cls : numa;
+	}
+
+	// Выделенный пул потоков, NULL нет
+	lite_pool_t* pool_get() const noexcept {
+		return pool;
+	}
+};
+
+// Управление ресурсами
+class lite_resource_manage_t {
+	// static методы глобальные ----------------------------------------------------
+	typedef std::unordered_map<std::string, lite_resource_t*> lite_resource_list_t;
+
+	struct static_info_t : public lite_static_info_t<static_info_t> {
+		lite_resource_list_t lr_idx; // Индекс списка ресурсов
+		lite_mutex_t mtx;			// Блокировка для доступа к lr_idx
+		int pool_count = { 0 };		// Создано выделенных пулов
+	};
+
+	static static_info_t& si() noexcept {
+		return static_info_t::si();
+	}
+
+public:
+	// Создание нового ресурса. max емкость ресурса, при получении указателя на имеющийся можно не указывать
+	// numa >= 0 - акторы ресурса выполняются только на процессорах этого узла NUMA, при max <= 0 максимум
+	// равен количеству процессоров узла
+	static lite_resource_t* get(const std::string& name, int max = 0, int numa = -1) {
+		lite_lock_t lck(si().mtx);
+		lite_resource_list_t::iterator it = si().lr_idx.find(name); // Поиск по индексу
+		lite_resource_t* lr = NULL;
+		if (it != si().lr_idx.end()) {
+			lr = it->second;
+			if (max != 0) assert(lr->res_max == max);
+		} else {
+			if (numa >= 0 && max <= 0) {
+				max = lite_cpu_topology_t::numa_cpu_count(numa);
+				if (max == 0) max = 1;
+			}
+			assert(max != 0);
+			lr = new lite_resource_t(max);
+			lr->name = name;
+			lr->numa = numa;
+			si().lr_idx[name] = lr;
+		}
+		return lr;
+	}
+
+	// Извлечение актора из кэша первого свободного ресурса узла numa (-2 всех, -1 не привязанных к узлу).
+	// Кэши занятых ресурсов проверяет захвативший поток после освобождения. NULL - кэши пусты
+	static lite_actor_t* cache_pop(int numa) noexcept {
+		lite_lock_t lck(si().mtx);
+		for (auto& it : si().lr_idx) {
+			lite_resource_t* lr = it.second;
+			if ((numa == -2 || lr->numa == numa) && !lr->la_cache.empty() && lr->is_free()) {
+				lite_actor_t* la = lr->la_cache.pop();
+				if (la != NULL) return la;
+			}
+		}
+		return NULL;
+	}
+
+	// Есть актор в кэше свободного ресурса узла numa, -2 любого. Без извлечения из кэша
+	static bool cache_any(int numa) noexcept {
+		lite_lock_t lck(si().mtx);
+		for (auto& it : si().lr_idx) {
+			lite_resource_t* lr = it.second;
+			if ((numa == -2 || lr->numa == numa) && !lr->la_cache.empty() && lr->is_free()) return true;
+		}
+		return false;
+	}
+
+	// Есть готовый актор HIGH на свободном ресурсе класса потоков cls (-2 любого): только тогда нужен перебор акторов
+	static bool prio_any(int cls) noexcept {
+		lite_lock_t lck(si().mtx);
+		for (auto& it : si().lr_idx) {
+			lite_resource_t* lr = it.second;
+			if ((cls == -2 || lr->thread_class() == cls) && lr->prio_ready.load(std::memory_order_relaxed) > 0 && lr->is_free()) return true;
+		}
+		return false;
+	}
+
+	// Сумма максимумов ресурсов. Больше потоков одновременно работать не может
+	// numa = -2 всех ресурсов, иначе класса потоков numa (см. lite_resource_t::thread_class())
+	static int max_total(int numa = -2) noexcept {
+		lite_lock_t lck(si().mtx);
+		int ret = 0;
+		for (auto& it : si().lr_idx) {
+			lite_resource_t* lr = it.second;
+			if (numa == -2 || lr->thread_class() == numa) ret += (lr->pool != NULL ? lr->pool->max : lr->res_max) + (lr->max_user ? 0 : lr->res_lent.load());
+		}
+		return ret;
+	}
+
+	// Создание выделенного пула потоков ресурса. Повторный вызов меняет только min и max
+	static lite_pool_t* pool_set(lite_resource_t* lr, int min, int max, lite_sched_t policy, int prio, const std::string& name) {
+		lite_lock_t lck(si().mtx);
+		if (max <= 0) max = lr->res_max;
+		if (min > max) min = max;
+		if (min < 0) min = 0;
+		lite_pool_t* pool = lr->pool;
+		if (pool == NULL) {
+			pool = new lite_pool_t();
+			pool->cls = LT_POOL_CLASS + si().pool_count++;
+			pool->numa = lr->numa;
+			pool->policy = policy;
+			pool->prio = prio;
+			pool->name = (name.empty() ? lr->name : name);
+			pool->policy_set = -1;
+		}
+		pool->min = min;
+		pool->max = max;
+		lr->pool = pool;
+		return pool;
+	}
+
+	// Выделенный пул по классу потоков, NULL не пул
+	static lite_pool_t* pool_find(int cls) noexcept {
+		if (cls < LT_POOL_CLASS) return NULL;
+		lite_lock_t lck(si().mtx);
+		for (auto& it : si().lr_idx) {
+			if (it.second->pool != NULL && it.second->pool->cls == cls) return it.second->pool;
+		}
+		return NULL;
+	}
+
+	// Имена ресурсов по указателям (для трассировки)
+	static void names_get(std::unordered_map<const void*, std::string>& names) {
+		lite_lock_t lck(si().mtx);
+		for (auto& it : si().lr_idx) names[it.second] = it.first;
+	}
+
+	// Очистка памяти
+	static void clear() noexcept {
+		lite_lock_t lck(si().mtx);
+		for (auto& it : si().lr_idx) {
+			delete it.second;
+		}
+		si().lr_idx.clear();
+	}
+};
+
+//----------------------------------------------------------------------------------
+//------ ТРАССИРОВКА ---------------------------------------------------------------
+//----------------------------------------------------------------------------------
+// События потоков пишутся без блокировок в кольцевой буфер потока, выгрузка в формате Chrome trace (JSON)
+class lite_trace_t {
+public:
+	enum type_t {
+		LT_TRACE_RUN,	// Запуск актора: obj актор, res ресурс, flow обработано сообщений
+		LT_TRACE_SEND,	// Отправка сообщения: obj получатель, flow номер связи
+		LT_TRACE_RECV,	// Обработка отправленного: obj актор, flow номер связи
+		LT_TRACE_SLEEP,	// Ожидание потока
+		LT_TRACE_WAKE,	// Пробуждение потока номер flow
+		LT_TRACE_TIMER	// Вызов timer(): obj актор
+	};
+
+	struct event_t {
+		int64_t time;		// Начало, нсек. lite_clock_ns()
+		int64_t dur;		// Длительность, нсек.
+		const void* obj;	// Актор
+		const void* res;	// Ресурс
+		uint64_t flow;		// Значение по типу события
+		int type;			// type_t
+		int tid;			// Номер потока
+	};
+
+private:
+	struct ring_t {
+		event_t buf[LT_TRACE_RING];
+		std::atomic<uint64_t> head;	// Записано событий всего, запись buf[head % LT_TRACE_RING]. Меняет только владелец
+		uint64_t base;				// head при последнем start(), более ранние не выгружаются. Под si().mtx
+		uint64_t seq;				// Счетчик номеров связей
+		int idx;					// Номер буфера
+		bool busy;					// Занят потоком, под si().mtx
+	};
+
+	// static переменные уровня потока
+	struct thread_info_t : public lite_thread_info_t<thread_info_t> {
+		ring_t* ring = { NULL };	// Буфер потока
+		uint32_t tick = { 0 };		// Счетчик выборки
+		int state = { 0 };			// 0 - вне запуска актора, 1 - запуск не записывается, 2 - записывается, 
+									// 3 - записывается из-за обработки записанной отправки, его отправки - нет
+
+		~thread_info_t() {
+			if (ring != NULL) { // Буфер остается с событиями для следующего потока
+				std::lock_guard<std::mutex> lck(si().mtx);
+				ring->busy = false;
+			}
+		}
+	};
+
+	static thread_info_t& ti() noexcept {
+		return thread_info_t::tls_get();
+	}
+
+	// static переменные глобальные
+	struct static_info_t : public lite_static_info_t<static_info_t> {
+		std::atomic<bool> on = { false };	// Идет запись
+		uint32_t sample = { 1 };			// Записывается каждый sample-й запуск актора в потоке
+		int64_t start = { 0 };				// Время включения, нсек.
+		std::string file;					// Выгрузка в lite_thread_end()
+		std::mutex mtx;						// Блокировка списка буферов
+		std::vector<ring_t*> rings;			// Буферы, не удаляются
+	};
+
+	static static_info_t& si() noexcept {
+		return static_info_t::si();
+	}
+
+	// Буфер текущего потока, свободный или новый
+	static ring_t* ring() noexcept {
+		thread_info_t& t = ti();
+		if (t.ring == NULL) {
+			std::lock_guard<std::mutex> lck(si().mtx);
+			for (ring_t* r : si().rings) {
+				if (!r->busy) {
+					t.ring = r;
+					break;
+				}
+			}
+			if (t.ring == NULL) {
+				t.ring = new ring_t;
+				t.ring->head = 0;
+				t.ring->base = 0;
+				t.ring->seq = 0;
+				t.ring->idx = (int)si().rings.size();
+				si().rings.push_back(t.ring);
+			}
+			t.ring->busy = true;
+		}
+		return t.ring;
+	}
+
+	// Запуск записывается: каждый sample-й в потоке
+	static bool sample() noexcept {
+		thread_info_t& t = ti();
+		if (++t.tick < si().sample) return false;
+		t.tick = 0;
+		return true;
+	}
+
+public:
+	// Экранирование строки для JSON
+	static std::string json_str(const std::string& str) {
+		std::string ret;
+		for (char c : str) {
+			if (c == '"' || c == '\\') {
+				ret += '\\';
+				ret += c;
+			} else if ((unsigned char)c < 0x20) {
+				char buf[8];
+				snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+				ret += buf;
+			} else {
+				ret += c;
+			}
+		}
+		return ret;
+	}
+
+	static bool on() noexcept {
+		return lite_opt_t::on(lite_opt_t::LT_OPT_TRACE) && si().on.load(std::memory_order_relaxed);
+	}
+
+	// Запись события в буфер текущего потока
+	static void add(int type, int64_t time, int64_t dur, const void* obj, const void* res, uint64_t flow) noexcept {
+		ring_t* r = ring();
+		uint64_t h = r->head.load(std::memory_order_relaxed);
+		event_t& e = r->buf[h & (LT_TRACE_RING - 1)];
+		e.time = time;
+		e.dur = dur;
+		e.obj = obj;
+		e.res = res;
+		e.flow = flow;
+		e.type = type;
+		size_t num = lite_thread_num();
+		e.tid = (num != 999 ? (int)num : 1000 + r->idx); // Не потоки библиотеки - по номеру буфера
+		r->head.store(h + 1, std::memory_order_release);
+	}
+
+	// Событие без длительности
+	static void instant(int type, const void* obj, uint64_t flow) noexcept {
+		add(type, lite_clock_ns(), 0, obj, NULL, flow);
+	}
+
+	// Начало запуска актора. Возвращает состояние для run_end(), start - время начала, если записывается
+	static int run_begin(int64_t& start) noexcept {
+		thread_info_t& t = ti();
+		int prev = t.state;
+		if (sample()) {
+			t.state = 2;
+			start = lite_clock_ns();
+		} else {
+			t.state = 1;
+			start = 0;
+		}
+		return prev;
+	}
+
+	// Окончание запуска актора la на ресурсе res, обработано n сообщений
+	static void run_end(const void* la, const void* res, int64_t start, uint64_t n, int prev) noexcept {
+		thread_info_t& t = ti();
+		if (t.state >= 2) add(LT_TRACE_RUN, start, lite_clock_ns() - start, la, res, n);
+		t.state = prev;
+	}
+
+	// Отправка сообщения актору la. Записывается из выбранного запуска или по выборке вне акторов, иначе
+	// записанная цепочка сообщений не кончалась бы. Номер связи для msg->flow, 0 - не записана
+	static uint32_t send(const void* la) noexcept {
+		thread_info_t& t = ti();
+		if (t.state == 1 || t.state == 3 || (t.state == 0 && !sample())) return 0;
+		ring_t* r = ring();
+		uint32_t id = ((uint32_t)(r->idx + 1) << 24) | (uint32_t)(++r->seq & 0xFFFFFF); // Повтор номера через 16М отправок потока
+		instant(LT_TRACE_SEND, la, id);
+		return id;
+	}
+
+	// Начало обработки записанного отправленного сообщения. Запуск становится записываемым
+	static void recv(const void* la, uint64_t flow, int64_t& start) noexcept {
+		thread_info_t& t = ti();
+		int64_t now = lite_clock_ns();
+		if (t.state == 1) {
+			t.state = 3;
+			start = now;
+		}
+		add(LT_TRACE_RECV, now, 0, la, NULL, flow);
+	}
+
+	// Включение записи. Буферы очищаются. sample - записывается каждый sample-й запуск актора в потоке
+	// и отправки из него. file - выгрузка в lite_thread_end()
+	static void start(const std::string& file, int sample) noexcept {
+		si().on = false;
+		{
+			std::lock_guard<std::mutex> lck(si().mtx);
+			for (ring_t* r : si().rings) r->base = r->head.load(std::memory_order_acquire); // Владелец может писать: без сброса head
+			si().file = file;
+		}
+		si().sample = (sample > 1 ? (uint32_t)sample : 1);
+		si().start = lite_clock_ns();
+		si().on = true;
+		lite_opt_t::set(lite_opt_t::LT_OPT_TRACE, true);
+	}
+
+	static void stop() noexcept {
+		si().on = false;
+		lite_opt_t::set(lite_opt_t::LT_OPT_TRACE, false);
+	}
+
+	// Выгрузка буферов в формате Chrome trace (JSON). false - ошибка записи файла
+	static bool dump(const std::string& file);
+
+	// Завершение работы: выгрузка в заданный при включении файл, выключение
+	static void end() noexcept {
+		if (!si().file.empty()) dump(si().file);
+		si().file.clear();
+		si().on = false;
+		lite_opt_t::set(lite_opt_t::LT_OPT_TRACE, false);
+	}
+
+	// Сигнал о завершении потока
+	static void thread_end() noexcept {
+		thread_info_t::tls_free();
+	}
+};
+
+//----------------------------------------------------------------------------------
+//------ ГРАФ ОБМЕНОВ --------------------------------------------------------------
+//----------------------------------------------------------------------------------
+// Ребро графа обменов (lite_graph_snapshot())
+struct lite_graph_edge_t {
+	const void* from;		// Отправитель, NULL - не из актора
+	const void* to;			// Получатель
+	std::string from_name;	// Имя отправителя, "external" - не из актора
+	std::string to_name;	// Имя получателя
+	size_t type;			// Тип сообщения
+	std::string type_name;	// Название типа
+	uint64_t count;			// Отправлено сообщений
+	uint64_t bytes;			// Отправлено байт (msg->bytes или sizeof типа)
+	double rate;			// Сообщений в секунду с момента включения
+	double byte_rate;		// Байт в секунду с момента включения
+};
+
+// Счетчики по ребрам (отправитель, получатель, тип). Каждый поток пишет в свою таблицу под своей 
+// блокировкой, чтение объединяет таблицы. Таблица завершившегося потока добавляется к общей
+class lite_graph_t {
+	struct key_t {
+		const void* from;
+		const void* to;
+		size_t type;
+
+		bool operator==(const key_t& k) const noexcept {
+			return from == k.from && to == k.to && type == k.type;
+		}
+	};
+
+	struct key_hash_t {
+		size_t operator()(const key_t& k) const noexcept {
+			size_t h = std::hash<const void*>()(k.from);
+			h = h * 31 + std::hash<const void*>()(k.to);
+			return h * 31 + k.type;
+		}
+	};
+
+	struct counter_t {
+		uint64_t count = { 0 };
+		uint64_t bytes = { 0 };
+		const char* type_name = { NULL }; // typeid().name() при отправке, NULL - искать по типу
+	};
+
+	typedef std::unordered_map<key_t, counter_t, key_hash_t> edge_map_t;
+
+	struct part_t {
+		lite_mutex_t mtx;	// Блокировка: поток и чтение
+		edge_map_t map;
+	};
+
+	// Слияние таблицы src в dst
+	static void merge(edge_map_t& dst, const edge_map_t& src) {
+		for (auto& it : src) {
+			counter_t& c = dst[it.first];
+			c.count += it.second.count;
+			c.bytes += it.second.bytes;
+			if (c.type_name == NULL) c.type_name = it.second.type_name;
+		}
+	}
+
+	// static переменные уровня потока
+	struct thread_info_t : public lite_thread_info_t<thread_info_t> {
+		part_t* part = { NULL };	// Таблица потока
+
+		~thread_info_t() {
+			if (part != NULL) { // Перенос в общую таблицу
+				std::lock_guard<std::mutex> lck(si().mtx);
+				merge(si().retired, part->map);
+				for (auto& p : si().parts) {
+					if (p == part) {
+						p = si().parts.back();
+						si().parts.pop_back();
+						break;
+					}
+				}
+				delete part;
+			}
+		}
+	};
+
+	static thread_info_t& ti() noexcept {
+		return thread_info_t::tls_get();
+	}
+
+	// static переменные глобальные
+	struct static_info_t : public lite_static_info_t<static_info_t> {
+		std::atomic<bool> on = { false };	// Идет запись
+		int64_t start = { 0 };				// Время включения, нсек.
+		std::string file;					// Выгрузка в lite_thread_end()
+		std::mutex mtx;						// Блокировка parts и retired
+		std::vector<part_t*> parts;			// Таблицы потоков
+		edge_map_t retired;					// Таблицы завершившихся потоков
+	};
+
+	static static_info_t& si() noexcept {
+		return static_info_t::si();
+	}
+
+	// Все ребра
+	static edge_map_t collect() {
+		std::lock_guard<std::mutex> lck(si().mtx);
+		edge_map_t ret = si().retired;
+		for (part_t* p : si().parts) {
+			lite_lock_t lck_part(p->mtx);
+			merge(ret, p->map);
+		}
+		return ret;
+	}
+
+public:
+	static bool on() noexcept {
+		return lite_opt_t::on(lite_opt_t::LT_OPT_GRAPH) && si().on.load(std::memory_order_relaxed);
+	}
+
+	// Отправка сообщения типа type от from к to
+	static void add(const void* from, const void* to, size_t type, uint64_t bytes, const char* type_name) noexcept {
+		thread_info_t& t = ti();
+		if (t.part == NULL) {
+			t.part = new part_t;
+			std::lock_guard<std::mutex> lck(si().mtx);
+			si().parts.push_back(t.part);
+		}
+		lite_lock_t lck(t.part->mtx);
+		counter_t& c = t.part->map[key_t{ from, to, type }];
+		c.count++;
+		c.bytes += bytes;
+		if (c.type_name == NULL) c.type_name = type_name;
+	}
+
+	// Включение/выключение записи. При включении счетчики обнуляются. file - выгрузка в lite_thread_end(),
+	// по расширению .json - JSON, иначе DOT
+	static void enable(bool on, const std::string& file) noexcept {
+		if (on) {
+			si().on = false;
+			std::lock_guard<std::mutex> lck(si().mtx);
+			si().retired.clear();
+			for (part_t* p : si().parts) {
+				lite_lock_t lck_part(p->mtx);
+				p->map.clear();
+			}
+			si().start = lite_clock_ns();
+			si().file = file;
+		}
+		si().on = on;
+		lite_opt_t::set(lite_opt_t::LT_OPT_GRAPH, on);
+	}
+
+	// Снимок ребер по убыванию количества сообщений
+	static std::vector<lite_graph_edge_t> snapshot();
+
+	// Выгрузка в формате Graphviz DOT или JSON. false - ошибка записи
+	static bool dump(const std::string& file, bool json);
+
+	// Завершение работы: выгрузка в заданный при включении файл, выключение
+	static void end() noexcept {
+		const std::string& f = si().file;
+		if (!f.empty()) dump(f, f.size() > 5 && f.compare(f.size() - 5, 5, ".json") == 0);
+		si().file.clear();
+		si().on = false;
+		lite_opt_t::set(lite_opt_t::LT_OPT_GRAPH, false);
+	}
+
+	// Сигнал о завершении потока
+	static void thread_end() noexcept {
+		thread_info_t::tls_free();
+	}
+};
+
+//----------------------------------------------------------------------------------
+//------ СЧЕТЧИКИ АКТОРА -----------------------------------------------------------
+//----------------------------------------------------------------------------------
+// Номер старшего единичного бита, v != 0
+static int lite_bit_high(uint64_t v) noexcept {
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long n;
+	_BitScanReverse64(&n, v);
+	return (int)n;
+#elif defined(__GNUC__)
+	return 63 - __builtin_clzll(v);
+#else
+	int n = 0;
+	while (v >>= 1) n++;
+	return n;
+#endif
+}
+
+// Гистограмма задержек, нсек. Логарифмически-линейная (как HDR Histogram): значения меньше 2^LT_HIST_SUB_BITS 
+// точно, каждое следующее удвоение делится на 2^LT_HIST_SUB_BITS равных интервалов
+struct lite_hist_t {
+	uint64_t count[LT_HIST_BUCKETS];	// Замеров в интервале
+	uint64_t total;						// Всего замеров
+
+	lite_hist_t() noexcept {
+		clear();
+	}
+
+	void clear() noexcept {
+		memset(count, 0, sizeof(count));
+		total = 0;
+	}
+
+	// Интервал значения
+	static int index(uint64_t v) noexcept {
+		if (v >= (1ULL << LT_HIST_MAX_BITS)) v = (1ULL << LT_HIST_MAX_BITS) - 1;
+		if (v < (1ULL << LT_HIST_SUB_BITS)) return (int)v;
+		int shift = lite_bit_high(v) - LT_HIST_SUB_BITS;
+		return ((shift + 1) << LT_HIST_SUB_BITS) + (int)(v >> shift) - (1 << LT_HIST_SUB_BITS);
+	}
+
+	// Наибольшее значение интервала
+	static uint64_t value(int i) noexcept {
+		if (i < (1 << LT_HIST_SUB_BITS)) return i;
+		int shift = (i >> LT_HIST_SUB_BITS) - 1;
+		uint64_t low = (uint64_t)((1 << LT_HIST_SUB_BITS) + (i & ((1 << LT_HIST_SUB_BITS) - 1))) << shift;
+		return low + (1ULL << shift) - 1;
+	}
+
+	void record(uint64_t v) noexcept {
+		count[index(v)]++;
+		total++;
+	}
+
+	// Сложение гистограмм (потоков, акторов, снимков)
+	void add(const lite_hist_t& h) noexcept {
+		for (int i = 0; i < LT_HIST_BUCKETS; i++) count[i] += h.count[i];
+		total += h.total;
+	}
+
+	// Значение, которое не превышают p процентов замеров (50, 99, 99.9), с точностью интервала. 0 - замеров нет
+	uint64_t percentile(double p) const noexcept {
+		if (total == 0) return 0;
+		double need = (double)total * p / 100;
+		uint64_t sum = 0;
+		for (int i = 0; i < LT_HIST_BUCKETS; i++) {
+			sum += count[i];
+			if (sum != 0 && (double)sum >= need) return value(i);
+		}
+		return value(LT_HIST_BUCKETS - 1);
+	}
+};
+
+// Гистограмма, заполняемая из нескольких потоков без блокировок
+struct lite_hist_atomic_t {
+	std::atomic<uint64_t> count[LT_HIST_BUCKETS];
+
+	lite_hist_atomic_t() noexcept {
+		for (int i = 0; i < LT_HIST_BUCKETS; i++) count[i].store(0, std::memory_order_relaxed);
+	}
+
+	// Замер, отрицательный (сдвиг часов между ядрами) считается нулем
+	void record(int64_t v) noexcept {
+		count[lite_hist_t::index(v > 0 ? (uint64_t)v : 0)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Добавление в обычную гистограмму
+	void load(lite_hist_t& h) const noexcept {
+		for (int i = 0; i < LT_HIST_BUCKETS; i++) {
+			uint64_t n = count[i].load(std::memory_order_relaxed);
+			h.count[i] += n;
+			h.total += n;
+		}
+	}
+};
+
+// Гистограммы задержек актора, создаются при первом замере после lite_stats_enable(true, true)
+struct lite_actor_latency_t : public lite_align64_t {
+	lite_hist_atomic_t wait;	// От постановки в очередь до начала recv()
+	lite_hist_atomic_t recv;	// Выполнение recv()
+};
+
+// Снимок счетчиков актора (lite_stats_snapshot())
+struct lite_actor_stats_t {
+	lite_actor_t* actor;	// Актор
+	std::string name;		// Имя актора
+	uint64_t enqueued;		// Поставлено в очередь сообщений
+	uint64_t processed;		// Обработано сообщений (recv())
+	uint64_t expired;		// Не обработано устаревших
+	uint64_t depth;			// Сообщений в очереди сейчас
+	uint64_t depth_max;		// Максимум сообщений в очереди
+	uint64_t busy_ns;		// Время выполнения, нсек.
+	uint64_t activations;	// Запусков (извлечений актора на выполнение)
+	uint64_t handoff;		// Запусков из слота LIFO потока
+	uint64_t cache_hit;		// Запусков из кэша ресурса
+	lite_hist_t wait_ns;	// Задержка от постановки в очередь до начала recv(), нсек. (при включенных гистограммах)
+	lite_hist_t recv_ns;	// Время выполнения recv(), нсек. (при включенных гистограммах)
+};
+
+// Сквозная задержка запросов, оканчивающихся на акторе (lite_e2e_snapshot())
+struct lite_e2e_stats_t {
+	lite_actor_t* actor;	// Конечный актор пути
+	std::string name;		// Имя актора
+	lite_hist_t latency_ns;	// От начала запроса (msg->origin_get()) до окончания, нсек.
+};
+
+// Счетчики актора. Часть счетчиков на поток (по номеру потока), сумма по частям при чтении
+struct lite_actor_metrics_t : public lite_align64_t {
+	struct shard_t {
+		std::atomic<uint64_t> enqueued = { 0 };
+		std::atomic<uint64_t> processed = { 0 };
+		std::atomic<uint64_t> busy_ns = { 0 };
+		std::atomic<uint64_t> activations = { 0 };
+		std::atomic<uint64_t> handoff = { 0 };
+		std::atomic<uint64_t> cache_hit = { 0 };
+		char pad[64 - 6 * sizeof(std::atomic<uint64_t>)];
+	};
+	shard_t shard[LT_METRICS_SHARDS];
+	std::atomic<lite_actor_latency_t*> latency = { NULL }; // Гистограммы задержек
+
+	~lite_actor_metrics_t() {
+		delete latency.load();
+	}
+
+	// Гистограммы задержек, создаются при первом обращении
+	lite_actor_latency_t* latency_get() noexcept {
+		lite_actor_latency_t* l = latency;
+		if (l == NULL) {
+			lite_actor_latency_t* l_new = new lite_actor_latency_t();
+			if (latency.compare_exchange_strong(l, l_new)) {
+				l = l_new;
+			} else {
+				delete l_new; // Создан другим потоком
+			}
+		}
+		return l;
+	}
+
+	// Часть счетчиков текущего потока
+	shard_t& my() noexcept {
+		return shard[lite_thread_num() % LT_METRICS_SHARDS];
+	}
+
+	// Добавление в очередь
+	void enqueue() noexcept {
+		my().enqueued.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Сумма по частям
+	void sum(lite_actor_stats_t& st) noexcept {
+		st.enqueued = st.processed = st.busy_ns = st.activations = st.handoff = st.cache_hit = 0;
+		for (int i = 0; i < LT_METRICS_SHARDS; i++) {
+			st.enqueued += shard[i].enqueued.load(std::memory_order_relaxed);
+			st.processed += shard[i].processed.load(std::memory_order_relaxed);
+			st.busy_ns += shard[i].busy_ns.load(std::memory_order_relaxed);
+			st.activations += shard[i].activations.load(std::memory_order_relaxed);
+			st.handoff += shard[i].handoff.load(std::memory_order_relaxed);
+			st.cache_hit += shard[i].cache_hit.load(std::memory_order_relaxed);
+		}
+		lite_actor_latency_t* l = latency;
+		if (l != NULL) {
+			l->wait.load(st.wait_ns);
+			l->recv.load(st.recv_ns);
+		}
+	}
+};
+
+//----------------------------------------------------------------------------------
+//------ ОБРАБОТЧИК (АКТОР) --------------------------------------------------------
+//----------------------------------------------------------------------------------
+// Актор (обработчик + очередь сообщений)
+class lite_actor_t : public lite_align64_t {
+
+	struct thread_info_t;
+
+	// Поля, читаемые при каждой отправке и запуске, - первыми: вместе с началом очереди занимают 3 строки кэша
+	// Меняет только выполняющий актор поток (переход при запуске), читают и ищущие работу: атомарно, без упорядочения
+	std::atomic<lite_resource_t*> resource;// Ресурс, используемый актором
+	std::atomic<lite_resource_t*> resource_next;// Новый ресурс, переход при следующем запуске. NULL нет
+	std::atomic<int> actor_free;		// Количество свободных акторов, т.е. сколько можно запускать
+	std::atomic<int> thread_max;		// Количество потоков, в скольки можно одновременно выполнять
+	bool in_cache;						// Помещен в кэш планирования запуска
+	bool timer_run;						// Требуется запуск обработки сигнала таймера
+	int home;							// Поток режима "поток на ядро", -1 общие потоки
+	// Пишет выполняющий или ставящий в кэш поток, читают ищущие работу: атомарно, без упорядочения
+	std::atomic<size_t> run_thread;		// Номер потока, последним выполнявшего актор. 999 - не выполнялся
+	int weight;							// Захватывается единиц ресурса при запуске
+	int weight_need;					// Вес первого в очереди сообщения, которому не хватило ресурса. 0 нет
+	int priority;						// Уровень приоритета lite_priority_t
+	int age;							// Сколько раз обойден готовым при выборе по приоритету
+	std::atomic<lite_resource_t*> reserved;// Ресурс, на котором актор держит резерв тяжелого захвата. NULL нет
+	std::atomic<int64_t> throttle_until;// Ограничен скоростью ресурса до этого времени, мксек. 0 нет
+	int64_t queue_age_max;				// Сообщение, ждавшее в очереди дольше, устарело, нсек. 0 нет ограничения
+	std::vector<size_t> type_list;		// Список обрабатываемых типов
+	lite_msg_queue_t msg_queue;			// Очередь сообщений
+
+	std::atomic<int64_t> ready_time;	// Время постановки в кэш, мксек. Для задержки перехвата другим потоком
+	int reserved_w;						// Вес резерва, под si().mtx_reserve
+	std::atomic<lite_resource_t*> prio_res;// Ресурс, на котором актор учтен готовым HIGH (prio_ready). NULL нет
+	std::atomic<int64_t> throttle_us;	// Суммарное время ожидания токенов, мксек. Читается из других потоков
+	int64_t throttle_from;				// Начало текущего ожидания токенов, мксек. 0 нет
+	std::atomic<size_t> expired_count;	// Не обработано устаревших сообщений
+	std::atomic<lite_actor_metrics_t*> metrics;// Счетчики актора, создаются при первом обращении после lite_stats_enable()
+	std::atomic<lite_hist_atomic_t*> e2e;// Сквозная задержка запросов, оканчивающихся на акторе, создается при первом обращении
+	std::string name;					// Наименование актора
+
+	friend lite_thread_t;
+	friend lite_shard_t;
+protected:
+	//---------------------------------
+	// Конструктор
+	lite_actor_t() : resource_next(NULL), actor_free(1), thread_max(1), in_cache(false), timer_run(false), home(lite_shard_home()), run_thread(999), weight(1), weight_need(0), priority(LT_PRIORITY_NORMAL), age(0), reserved(NULL), throttle_until(0), queue_age_max(0), ready_time(0), reserved_w(0), prio_res(NULL), throttle_us(0), throttle_from(0), expired_count(0), metrics(NULL), e2e(NULL) {
+		lite_resource_t* res = ti().res_new; // Задан при new(res) actor_t
+		ti().res_new = NULL;
+		resource.store(res != NULL ? res : resource_default(), std::memory_order_relaxed);
+		list_add(this);
+	}
+
+	// Переход на ресурс, заданный resource_set() во время работы. Выполняется при запуске, если актор
+	// не выполняется другими потоками. Очередь сообщений не меняется. false - актор нового ресурса 
+	// текущий поток выполнять не может
+	bool resource_move(int free_now) noexcept {
+		if (free_now != thread_max - 1) return true; // Другие потоки еще выполняют актор со старым ресурсом
+		lite_resource_t* next = resource_next.exchange(NULL);
+		if (next == NULL) return true;
+		reserve_set(0); // Старый ресурс актор больше не ждет
+		prio_clear();
+		weight_need = 0; // Сообщение определит вес на новом ресурсе
+		resource.store(next, std::memory_order_relaxed);
+		int w_max = next->weight_max();
+		if (weight > w_max) weight = w_max;
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_res_move++;
+		#endif
+		return is_here();
+	}
+
+	// Резерв тяжелого захвата weight > 1 на текущем ресурсе, weight <= 1 - снятие. Резерв принадлежит актору:
+	// снимается при захвате, переходе на другой ресурс и удалении актора, не остается после ушедшего
+	void reserve_set(int w) noexcept {
+		lite_resource_t* res = (w > 1 ? resource_get() : NULL);
+		if (res == NULL && reserved.load(std::memory_order_relaxed) == NULL) return;
+		lite_lock_t lck(si().mtx_reserve); // Блокировка
+		lite_resource_t* prev = reserved.load(std::memory_order_relaxed);
+		if (prev == res && (res == NULL || reserved_w == w)) return;
+		if (prev != NULL) prev->unreserve(reserved_w);
+		if (res != NULL) res->reserve(w);
+		reserved_w = (res != NULL ? w : 0);
+		reserved.store(res, std::memory_order_relaxed);
+	}
+
+	// Резерв, если для запуска с весом weight_run() > 1 не хватает свободных единиц ресурса
+	LT_NOINLINE void reserve_heavy() noexcept {
+		int w = weight_run();
+		lite_resource_t* res = resource_get();
+		if (res != NULL && !res->is_free(w)) reserve_set(w);
+	}
+
+	// Учет готового актора HIGH на его ресурсе: поток, которому достанется ресурс, выберет актор перебором
+	LT_NOINLINE void prio_mark() noexcept {
+		lite_resource_t* res = resource_get();
+		lite_resource_t* nul = NULL;
+		if (res == NULL || prio_res.load(std::memory_order_relaxed) != NULL || !prio_res.compare_exchange_strong(nul, res)) return;
+		res->prio_ready++;
+		si().prio_ready++;
+	}
+
+	// Снятие учета: актор запущен, не готов, ушел с ресурса или удаляется
+	void prio_clear() noexcept {
+		if (prio_res.load(std::memory_order_relaxed) == NULL) return;
+		lite_resource_t* res = prio_res.exchange(NULL);
+		if (res == NULL) return;
+		res->prio_ready--;
+		si().prio_ready--;
+	}
+
+	// Вес захвата ресурса при запуске
+	int weight_run() const noexcept {
+		return weight_need > weight ? weight_need : weight;
+	}
+
+	// Есть работа и актор может быть запущен, без учета занятости ресурса
+	bool is_pending() noexcept {
+		if ((msg_queue.empty() && !timer_run) || actor_free <= 0) return false;
+		int64_t until = throttle_until.load(std::memory_order_relaxed);
+		return until == 0 || timer_run || time_us() >= until;
+	}
+
+	// Достаточно ли ресурса для запуска в потоке t: захвачен им или свободен
+	bool is_res_ready(thread_info_t& t) noexcept {
+		lite_resource_t* res = resource_get();
+		if (res == NULL) return true;
+		int w = weight_run();
+		return (res == t.lr_now_used && w <= t.lr_weight && !res->is_reserved(w)) || res->is_free(w);
+	}
+
+	// Проверка готовности к запуску
+	bool is_ready() noexcept {
+		return is_pending() && is_res_ready(ti());
+	}
+
+	// Остановка до пополнения токенов ресурса через wait мксек. Будит таймер
+	void throttle(int64_t wait) noexcept {
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_throttle++;
+		#endif
+		int64_t now = time_us();
+		if (throttle_from == 0) throttle_from = now;
+		if (throttle_until.exchange(now + wait) == 0) si().throttled++;
+		lite_timer_once(this, (int)((wait + 999) / 1000));
+	}
+
+	// Может ли актор выполняться текущим потоком. Акторы ресурса привязанного к узлу NUMA 
+	// выполняются только потоками этого узла, ресурса с выделенным пулом - потоками пула, 
+	// остальные - только общими потоками
+	bool is_here(thread_info_t& t) noexcept {
+		if (t.numa == -1) return true;
+		lite_resource_t* res = resource_get();
+		return (res == NULL ? 0 : res->thread_class() + 1) == t.numa;
+	}
+
+	bool is_here() noexcept {
+		return is_here(ti());
+	}
+
+	// Проверка готовности к запуску в текущем потоке
+	bool is_ready_here() noexcept {
+		thread_info_t& t = ti();
+		if (!is_here(t) || !is_pending() || !is_res_ready(t)) return false;
+		if (!lite_opt_t::on(lite_opt_t::LT_OPT_AFFINITY)) return true;
+		// Актор ждет поток, в котором выполнялся, не дольше steal_delay
+		int delay = si().steal_delay;
+		size_t run = run_thread.load(std::memory_order_relaxed);
+		if (delay > 0 && run != 999 && t.numa != -1 && run != lite_thread_num() && time_us() - ready_time.load(std::memory_order_relaxed) < delay) {
+			t.affinity_skip = true;
+			return false;
+		}
+		return true;
+	}
+
+	// Постановка сообщения в очередь
+	void push(lite_msg_t* msg) noexcept {
+
+		thread_info_t& t = ti();
+		if (msg == t.msg_del) {
+			// Помеченное на удаление сообщение поместили в очередь другого актора. Снятие пометки
+			t.msg_del = NULL;
+		}
+
+		bool stamp = false; // Метка времени постановки в очередь
+		uint32_t opt = lite_opt_t::get();
+		if (opt != 0 || home >= 0 || queue_age_max != 0 || msg->e2e != NULL || t.trace_id != 0) {
+			if ((opt & lite_opt_t::LT_OPT_METRICS) != 0) metrics_get()->enqueue();
+			if ((opt & lite_opt_t::LT_OPT_TRACE) != 0 && lite_trace_t::on()) msg->flow = lite_trace_t::send(this);
+			// Сквозная трассировка: отправка из recv() продолжает запрос обрабатываемого сообщения,
+			// отправка не из актора начинает новый
+			if (msg->e2e != NULL) {
+				if (msg->e2e->trace_id == t.trace_id) t.trace_sent = true; // Пересылка
+			} else if (t.trace_id != 0) {
+				msg->e2e_set(t.trace_id, t.trace_origin);
+				t.trace_sent = true;
+			} else if (t.la_now_run == NULL && (opt & lite_opt_t::LT_OPT_E2E) != 0) {
+				msg->trace_begin();
+			}
+			stamp = (queue_age_max != 0 || (opt & (lite_opt_t::LT_OPT_LATENCY | lite_opt_t::LT_OPT_STAMP)) != 0);
+
+			if (home >= 0) {
+				msg->time = (stamp ? lite_clock_ns() : 0);
+				if (lite_shard_push(home, this, msg)) return; // В очередь потока актора
+			}
+		}
+
+		// Актор становится готовым к запуску, иначе поток для него уже будили. Проверка под блокировкой очереди:
+		// до нее поток актора мог извлечь последнее сообщение и уйти в ожидание
+		bool first = msg_queue.push(msg, stamp);
+		cache_push(this, first);
+	}
+
+	// Выполнение в потоке режима "поток на ядро": сообщение, msg == NULL timer(), LT_SHARD_DESTROY удаление
+	void run_shard(lite_msg_t* msg) noexcept {
+		thread_info_t& t = ti();
+		if (msg == NULL) {
+			timer_run = false;
+			t.la_now_run = this;
+			if (lite_trace_t::on()) lite_trace_t::instant(lite_trace_t::LT_TRACE_TIMER, this, 0);
+			timer();
+		} else if (msg == LT_SHARD_DESTROY) {
+			home = -1;
+			destroy(this);
+		} else {
+			t.la_now_run = this;
+			uint32_t opt = lite_opt_t::get();
+			lite_actor_metrics_t* m = ((opt & lite_opt_t::LT_OPT_METRICS) != 0 ? metrics_get() : NULL);
+			lite_actor_latency_t* lat = (m != NULL && (opt & lite_opt_t::LT_OPT_LATENCY) != 0 ? m->latency_get() : NULL);
+			int64_t start = (m != NULL ? lite_clock_ns() : 0);
+			int64_t end = 0;
+			bool trace = ((opt & lite_opt_t::LT_OPT_TRACE) != 0 && lite_trace_t::on());
+			int64_t trace_start = 0;
+			int trace_prev = (trace ? lite_trace_t::run_begin(trace_start) : 0);
+			if (!expired_drop(msg)) {
+				if (trace && msg->flow != 0) lite_trace_t::recv(this, msg->flow, trace_start);
+				if (lat != NULL && msg->time != 0) lat->wait.record(start - msg->time);
+				t.msg_del = msg; // Пометка на удаление
+				e2e_ctx_t e2e_prev;
+				bool e2e = (msg->e2e != NULL || t.trace_id != 0);
+				if (e2e) e2e_prev = e2e_enter(msg);
+				recv(msg); // Обработка
+				if (e2e) e2e_leave(e2e_prev);
+				if (lat != NULL) {
+					end = lite_clock_ns();
+					lat->recv.record(end - start);
+				}
+				if (msg == t.msg_del) delete msg;
+				#ifdef LT_STAT
+				lite_thread_stat_t::ti().stat_msg_send++;
+				#endif
+				if (m != NULL) m->my().processed.fetch_add(1, std::memory_order_relaxed);
+			}
+			if (m != NULL) {
+				m->my().activations.fetch_add(1, std::memory_order_relaxed);
+				m->my().busy_ns.fetch_add((end != 0 ? end : lite_clock_ns()) - start, std::memory_order_relaxed);
+			}
+			if (trace) lite_trace_t::run_end(this, NULL, trace_start, 1, trace_prev);
+		}
+		t.la_now_run = NULL;
+	}
+
+	// Контекст сквозной трассировки потока
+	struct e2e_ctx_t {
+		uint64_t id;
+		int64_t origin;
+		bool sent;
+	};
+
+	// Обработка сообщения msg становится текущим запросом потока. Возвращает прежний для e2e_leave()
+	LT_NOINLINE static e2e_ctx_t e2e_enter(const lite_msg_t* msg) noexcept {
+		thread_info_t& t = ti();
+		e2e_ctx_t prev = { t.trace_id, t.trace_origin, t.trace_sent };
+		t.trace_id = msg->trace_id_get();
+		t.trace_origin = msg->origin_get();
+		t.trace_sent = false;
+		return prev;
+	}
+
+	// Окончание recv(): запрос не продолжен отправкой - путь окончен на этом акторе
+	LT_NOINLINE void e2e_leave(const e2e_ctx_t& prev) noexcept {
+		thread_info_t& t = ti();
+		if (t.trace_id != 0 && !t.trace_sent) e2e_get()->record(lite_clock_ns() - t.trace_origin);
+		t.trace_id = prev.id;
+		t.trace_origin = prev.origin;
+		t.trace_sent = prev.sent;
+	}
+
+	// Гистограмма сквозной задержки, создается при первом обращении
+	lite_hist_atomic_t* e2e_get() noexcept {
+		lite_hist_atomic_t* h = e2e;
+		if (h == NULL) {
+			lite_hist_atomic_t* h_new = new lite_hist_atomic_t();
+			if (e2e.compare_exchange_strong(h, h_new)) {
+				h = h_new;
+			} else {
+				delete h_new; // Создана другим потоком
+			}
+		}
+		return h;
+	}
+
+	// Счетчики актора, создаются при первом обращении
+	LT_NOINLINE lite_actor_metrics_t* metrics_get() noexcept {
+		lite_actor_metrics_t* m = metrics;
+		if (m == NULL) {
+			lite_actor_metrics_t* m_new = new lite_actor_metrics_t();
+			if (metrics.compare_exchange_strong(m, m_new)) {
+				m = m_new;
+			} else {
+				delete m_new; // Создан другим потоком
+			}
+		}
+		return m;
+	}
+
+	// Проверка срока сообщения перед recv(). Устаревшее передается в on_expired() и удаляется
+	bool expired_drop(lite_msg_t* msg) noexcept {
+		if (msg->deadline == 0 && queue_age_max == 0) return false;
+		int64_t now = lite_clock_ns();
+		if ((msg->deadline == 0 || now <= msg->deadline) && (queue_age_max == 0 || msg->time == 0 || now - msg->time <= queue_age_max)) return false;
+		expired_count++;
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_msg_expired++;
+		#endif
+		thread_info_t& t = ti();
+		t.msg_del = msg; // Пометка на удаление
+		on_expired(msg);
+		if (msg == t.msg_del) delete msg;
+		return true;
+	}
+
+	// Проверки сообщения перед recv(): срок, вес, токены ограничения скорости, трассировка. 0 - обрабатывать,
+	// 1 - устарело и удалено, 2 - возвращено в очередь, запуск завершается (yield - с перезапуском из кэша)
+	LT_NOINLINE int before_recv(lite_msg_t* msg, thread_info_t& t, bool trace, int64_t trace_start, bool& yield) noexcept {
+		if (expired_drop(msg)) return 1; // Ресурс и токены не тратятся
+		lite_resource_t* lr = resource_get();
+		// Сообщению нужно больше единиц ресурса, чем захвачено
+		if (msg->weight > t.lr_weight && lr != NULL) {
+			int w = msg->weight;
+			int w_max = lr->weight_max();
+			if (w > w_max) w = w_max;
+			if (w > t.lr_weight && !resource_upgrade(w)) {
+				msg_queue.push_front(msg); // Будет обработано при запуске с весом w
+				weight_need = w;
+				reserve_set(w); // Легкие не займут освобождающиеся единицы
+				yield = true; // В кэш: найдет поток, освободивший ресурс
+				return 2;
+			}
+		}
+		// Ограничение скорости ресурса: нет токенов - ожидание пополнения
+		if (lr != NULL && lr->rate_on()) {
+			int64_t wait = lr->rate_take(msg->tokens > 0 ? msg->tokens : 1);
+			if (wait > 0) {
+				msg_queue.push_front(msg);
+				throttle(wait);
+				return 2;
+			}
+			if (throttle_from != 0) { // Дождался токенов
+				throttle_us.fetch_add(time_us() - throttle_from, std::memory_order_relaxed);
+				throttle_from = 0;
+			}
+		}
+		if (trace && msg->flow != 0) lite_trace_t::recv(this, msg->flow, trace_start);
+		return 0;
+	}
+
+	// Запуск обработки всех сообщений очереди
+	void run_all() noexcept {
+		int free_now = --actor_free;
+		if (free_now < 0) {
+			// Уже выполняется разрешенное количество акторов
+			#ifdef LT_STAT
+			lite_thread_stat_t::ti().stat_actor_not_run++;
+			#endif
+		} else if (resource_next != NULL && !resource_move(free_now)) {
+			actor_free++;
+			cache_shared(this); // Выполнят потоки нового ресурса
+			return;
+		} else if (resource_lock(resource_get(), weight_run())) { // Занимаем ресурс
+			lite_resource_t* lr = resource_get(); // Переход на другой ресурс уже выполнен выше
+			size_t num = lite_thread_num();
+			#ifdef LT_STAT
+			size_t run = run_thread.load(std::memory_order_relaxed);
+			if (run != 999 && num != 999) {
+				if (run == num) {
+					lite_thread_stat_t::ti().stat_affinity_hit++;
+				} else {
+					lite_thread_stat_t::ti().stat_affinity_miss++;
+				}
+			}
+			#endif
+			run_thread.store(num, std::memory_order_relaxed);
+			if (reserved.load(std::memory_order_relaxed) != NULL) reserve_set(0); // Резерв выполнен
+			thread_info_t& t = ti();
+			if (t.la_next_run != NULL && t.la_next_run != this) cache_shared(t.la_next_run); // Слот LIFO занят (вложенный запуск)
+			t.la_next_run = NULL;
+			lite_actor_t* now_prev = t.la_now_run;
+			t.la_now_run = this;
+			bool need_lock = (thread_max != 1); // Блокировка нужна только многопоточным акторам
+			// Выбор старейшего: обрабатываются сообщения интервала первого, более поздние после перевыбора
+			uint32_t opt = lite_opt_t::get();
+			if ((opt & lite_opt_t::LT_OPT_PRIO) != 0) prio_clear(); // Выбран - больше не ждет
+			int64_t bucket = ((opt & lite_opt_t::LT_OPT_STAMP) != 0 ? oldest_bucket(msg_queue.head_get()) : INT64_MAX);
+			lite_actor_metrics_t* m = ((opt & lite_opt_t::LT_OPT_METRICS) != 0 ? metrics_get() : NULL);
+			lite_actor_latency_t* lat = (m != NULL && (opt & lite_opt_t::LT_OPT_LATENCY) != 0 ? m->latency_get() : NULL);
+			int64_t start = (m != NULL ? lite_clock_ns() : 0);
+			int64_t first = start;	// Начало recv() первого сообщения - время запуска (одно чтение часов меньше)
+			int64_t end = 0;		// Окончание последнего recv(), 0 - не замерялось
+			uint64_t processed = 0;
+			bool yield = false;	// Прервано ради резерва ресурса, остальные сообщения после перезапуска
+			bool trace = ((opt & lite_opt_t::LT_OPT_TRACE) != 0 && lite_trace_t::on());
+			int64_t trace_start = 0;
+			int trace_prev = (trace ? lite_trace_t::run_begin(trace_start) : 0);
+			// Проверки сообщения до recv(), кроме веса и срока самого сообщения: только если что-то включено
+			bool check = (trace || queue_age_max != 0 || (lr != NULL && lr->rate_on()));
+			while (true) {
+				// Извлечение сообщения из очереди
+				lite_msg_t* msg = msg_queue.pop(need_lock);
+				if (msg == NULL) break;
+				if (weight_need != 0) weight_need = 0; // Тяжелое сообщение извлечено: будет обработано или устареет
+				if (check || msg->deadline != 0 || msg->weight > t.lr_weight) {
+					int r = before_recv(msg, t, trace, trace_start, yield);
+					if (r == 1) continue; // Устарело
+					if (r == 2) break; // Возвращено в очередь
+				}
+				// Запуск функции
+				int64_t recv_start = 0;
+				if (lat != NULL) {
+					recv_start = (first != 0 ? first : lite_clock_ns());
+					first = 0;
+					if (msg->time != 0) lat->wait.record(recv_start - msg->time);
+				}
+				t.msg_del = msg; // Пометка на удаление
+				e2e_ctx_t e2e_prev;
+				bool e2e = (msg->e2e != NULL || t.trace_id != 0); // Отслеживается это или внешнее (вложенный запуск)
+				if (e2e) e2e_prev = e2e_enter(msg);
+				recv(msg); // Обработка
+				if (e2e) e2e_leave(e2e_prev);
+				if (lat != NULL) {
+					end = lite_clock_ns();
+					lat->recv.record(end - recv_start);
+				}
+				if (msg == t.msg_del) delete msg;
+				processed++;
+				if (t.blk != NULL && t.blk->res_lent != NULL) block_reclaim(t.blk); // Блокирующий вызов завершен
+				#ifdef LT_STAT
+				lite_thread_stat_t::ti().stat_msg_send++;
+				#endif
+				if (resource_next != NULL) break; // Переход на другой ресурс - остальные сообщения после перезапуска
+				if (bucket != INT64_MAX && oldest_bucket(msg_queue.head_get()) > bucket) break;
+				if (lr != NULL && lr->is_reserved(t.lr_weight)) { // Захваченные единицы ждет тяжелый
+					yield = true;
+					break;
+				}
+			}
+			if(timer_run) {
+				timer_run = false;
+				if (trace) lite_trace_t::instant(lite_trace_t::LT_TRACE_TIMER, this, 0);
+				timer();
+				if (t.blk != NULL && t.blk->res_lent != NULL) block_reclaim(t.blk);
+				end = 0;
+			}
+			if (m != NULL) {
+				lite_actor_metrics_t::shard_t& sh = m->my();
+				sh.processed.fetch_add(processed, std::memory_order_relaxed);
+				sh.activations.fetch_add(1, std::memory_order_relaxed);
+				sh.busy_ns.fetch_add((end != 0 ? end : lite_clock_ns()) - start, std::memory_order_relaxed); // Без удаления последнего сообщения
+			}
+			if (trace) lite_trace_t::run_end(this, lr, trace_start, processed, trace_prev);
+			// Резерв, поставленный отправителем во время работы, не нужен, если актор не ждет большего веса
+			if (weight_need == 0 && reserved.load(std::memory_order_relaxed) != NULL) reserve_set(0);
+			in_cache = false;
+			t.la_now_run = now_prev;
+			if (yield) {
+				actor_free++;
+				cache_shared(this, false); // Запустит поток, которому ресурс достанется после тяжелого
+				return;
+			}
+		} else if (weight_run() > 1) {
+			reserve_set(weight_run()); // Тяжелому не хватило свободных единиц
+		}
+		actor_free++;
+		if (resource_next != NULL && !msg_queue.empty()) cache_shared(this); // Перезапуск с новым ресурсом
+		return;
+	}
+
+public:
+	// Установка имени актора
+	void name_set(const std::string& name_) {
+		name_set(this, name_);
+	}
+
+	// Получение имени актора
+	const std::string name_get() {
+		if(!name.empty()) {
+			return name;
+		} else {
+			std::string n = "actor#";
+			n += std::to_string((size_t)this);
+			return n;
+		}
+	}
+
+
+	// Вес актора: сколько единиц ресурса занимает запуск (по умолчанию 1). Не больше максимума ресурса
+	// и родительских. Отдельному сообщению можно задать больший вес msg->weight
+	void weight_set(int w) noexcept {
+		if (w < 1) w = 1;
+		lite_resource_t* res = resource_get();
+		if (res != NULL && w > res->weight_max()) w = res->weight_max();
+		weight = w;
+	}
+
+	int weight_get() const noexcept {
+		return weight;
+	}
+
+	// Есть акторы, ожидающие токены. Тогда пауза для их дообработки
+	static bool throttled_wait() noexcept {
+		if (si().throttled == 0) return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		return true;
+	}
+
+	// Уровень приоритета (lite_priority_t). При выборе готового актора сначала берутся акторы более
+	// высокого уровня (строго или взвешенно, см. lite_thread_priority_weighted())
+	void priority_set(int level) noexcept {
+		if (level < 0) level = 0;
+		if (level >= LT_PRIORITY_LEVELS) level = LT_PRIORITY_LEVELS - 1;
+		priority = level;
+		if (level != LT_PRIORITY_NORMAL) lite_opt_t::set(lite_opt_t::LT_OPT_PRIO, true); // Выбор с учетом приоритетов
+	}
+
+	int priority_get() const noexcept {
+		return priority;
+	}
+
+	// Взвешенный выбор уровня приоритета (true) или строгий (false, по умолчанию)
+	static void priority_weighted_set(bool on) noexcept {
+		si().prio_weighted.store(on, std::memory_order_relaxed);
+	}
+
+	// Включение счетчиков акторов и гистограмм задержек
+	static void metrics_set(bool on, bool latency) noexcept {
+		if (on && !si().metrics_on) { // Максимум длины очереди с момента включения
+			lite_lock_t lck(si().mtx_list); // Блокировка
+			for (lite_actor_t* la : si().la_list) la->msg_queue.peak_reset();
+		}
+		si().metrics_on = on;
+		lite_opt_t::set(lite_opt_t::LT_OPT_LATENCY, on && latency);
+		lite_opt_t::set(lite_opt_t::LT_OPT_METRICS, on);
+	}
+
+	// Снимок счетчиков всех акторов. Акторы без счетчиков (не запускались после включения) не выводятся
+	static std::vector<lite_actor_stats_t> metrics_snapshot() {
+		std::vector<lite_actor_stats_t> ret;
+		lite_lock_t lck(si().mtx_list); // Блокировка, пока актор в списке - он не удален
+		for (lite_actor_t* la : si().la_list) {
+			lite_actor_metrics_t* m = la->metrics;
+			if (m == NULL) continue;
+			lite_actor_stats_t st;
+			st.actor = la;
+			st.name = la->name;
+			m->sum(st);
+			st.depth = la->msg_queue.size(); // Из состояния очереди, не зависит от момента включения
+			st.depth_max = la->msg_queue.peak_get();
+			st.expired = la->expired_count;
+			ret.push_back(st);
+		}
+		return ret;
+	}
+
+	// Доля запросов сквозной трассировки: 0 - выключена, 1 - все
+	static void e2e_sample_set(double fraction) noexcept {
+		si().e2e_threshold = (fraction <= 0 ? 0 : fraction >= 1 ? UINT32_MAX : (uint32_t)(fraction * 4294967296.0));
+		lite_opt_t::set(lite_opt_t::LT_OPT_E2E, si().e2e_threshold != 0);
+	}
+
+	// Начало нового запроса: по выборке номер, иначе 0
+	static uint64_t e2e_sample() noexcept {
+		uint32_t th = si().e2e_threshold;
+		if (th == 0) return 0;
+		if (th != UINT32_MAX) {
+			thread_info_t& t = ti();
+			uint32_t x = t.trace_rnd;
+			if (x == 0) x = ((uint32_t)(size_t)&t ^ (uint32_t)lite_clock_ns()) | 1; // Затравка на поток
+			x ^= x << 13; // xorshift32
+			x ^= x >> 17;
+			x ^= x << 5;
+			t.trace_rnd = x;
+			if (x >= th) return 0;
+		}
+		return ++si().e2e_seq;
+	}
+
+	// Окончание запроса сообщения msg на текущем акторе
+	static void e2e_end(lite_msg_t* msg) noexcept {
+		if (msg->e2e == NULL) return;
+		thread_info_t& t = ti();
+		if (t.la_now_run != NULL) t.la_now_run->e2e_get()->record(lite_clock_ns() - msg->e2e->origin);
+		if (t.trace_id == msg->e2e->trace_id) t.trace_id = 0; // recv() этого сообщения уже ничего не записывает
+		msg->e2e_set(0, 0);
+	}
+
+	// Снимок сквозных задержек по конечным акторам
+	static std::vector<lite_e2e_stats_t> e2e_snapshot() {
+		std::vector<lite_e2e_stats_t> ret;
+		lite_lock_t lck(si().mtx_list); // Блокировка, пока актор в списке - он не удален
+		for (lite_actor_t* la : si().la_list) {
+			lite_hist_atomic_t* h = la->e2e;
+			if (h == NULL) continue;
+			lite_e2e_stats_t st;
+			st.actor = la;
+			st.name = la->name_get();
+			h->load(st.latency_ns);
+			ret.push_back(st);
+		}
+		return ret;
+	}
+
+	// Имена акторов по указателям (для трассировки)
+	static void names_get(std::unordered_map<const void*, std::string>& names) {
+		lite_lock_t lck(si().mtx_list);
+		for (lite_actor_t* la : si().la_list) names[la] = la->name_get();
+	}
+
+	// Выбор актора со старейшим ожидающим сообщением
+	static void oldest_first_set(bool on) noexcept {
+		lite_msg_queue_t::stamp_set(on);
+	}
+
+	// Суммарное время ожидания токенов ограничения скорости ресурса, мксек.
+	int64_t throttled_us() const noexcept {
+		return throttle_us.load(std::memory_order_relaxed);
+	}
+
+	// Сообщения, ждавшие в очереди дольше ms мсек., не обрабатываются (сброс нагрузки). 0 - без ограничения
+	void queue_age_set(int ms) noexcept {
+		queue_age_max = (int64_t)ms * 1000000;
+	}
+
+	int queue_age_get() const noexcept {
+		return (int)(queue_age_max / 1000000);
+	}
+
+	// Не обработано устаревших сообщений
+	size_t expired_get() const noexcept {
+		return expired_count;
+	}
+
+	// Привязка к ресурсу. До первого запуска - сразу, иначе переход при следующем запуске актора
+	void resource_set(lite_resource_t* res) noexcept {
+		assert(res != NULL);
+		lite_resource_t* now = resource_get();
+		if (run_thread.load(std::memory_order_relaxed) == 999 && now == si().res_default && msg_queue.empty()) {
+			reserve_set(0);
+			prio_clear();
+			weight_need = 0;
+			resource.store(res, std::memory_order_relaxed);
+		} else if (res != now || resource_next != NULL) {
+			resource_next = res;
+			if (!msg_queue.empty()) cache_shared(this); // Готовый актор перейдет при ближайшем запуске
+		}
+	}
+
+	// Текущий ресурс
+	lite_resource_t* resource_get() const noexcept {
+		return resource.load(std::memory_order_relaxed);
+	}
+
+	// Установка глубины распараллеливания
+	void parallel_set(int count) noexcept {
+		if (count <= 0) count = 1;
+		if (count == thread_max) return;
+
+		actor_free += count - thread_max.exchange(count);
+	}
+
+	// Проверка типа сообщения
+	bool check_type(lite_msg_t* msg) noexcept {
+		if (!type_list.empty()) {
+			// Проверка что тип сообщения в обрабатываемых
+			bool found = false;
+			for (auto& t : type_list) {
+				if (msg->type == t) {
+					found = true;
+					break;
+				}
+			}
+			if (!found) {
+				lite_log(LITE_ERROR_MSG_TYPE, "'%s' recv '%s'", name_get().c_str(), msg->type_descr().c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Помещение в очередь для последующего запуска
+	template <typename T>
+	void run(T* msg) noexcept {
+		lite_msg_t::type_set(msg);
+		if(check_type(msg)) {
+			if (lite_graph_t::on()) {
+				lite_graph_t::add(ti().la_now_run, this, msg->type, (msg->bytes != 0 ? msg->bytes : sizeof(T)),
+					(msg->type == typeid(T).hash_code() ? typeid(T).name() : NULL));
+			}
+			push(msg);
+		} else if (msg != ti().msg_del) {
+			delete msg;
+		}
+	}
+
+	// Добавление обрабатываемого типа
+	void type_add(size_t type) noexcept {
+		bool found = false;
+		for (auto& t : type_list) {
+			if (type == t) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) type_list.push_back(type);
+	}
+
+	// Установка периода вызова timer()
+	void timer_set(int time_ms) noexcept {
+		lite_timer_run(this, time_ms);
+	}
+
+	// Токены ресурса пополнились (однократный таймер после throttle())
+	void throttle_alert() noexcept {
+		if (!throttle_cancel()) return;
+		if (!msg_queue.empty()) cache_push(this);
+	}
+
+	// Снятие ожидания токенов без пробуждения. true - ожидал
+	bool throttle_cancel() noexcept {
+		if (throttle_until.exchange(0) == 0) return false;
+		si().throttled--;
+		return true;
+	}
+
+	// Вызов timer()
+	void timer_alert() noexcept {
+		if (!timer_run) {
+			timer_run = true;
+			if (home >= 0 && lite_shard_push(home, this, NULL)) return;
+			cache_push(this);
+		}
+	}
+
+	// Привязка к потоку режима "поток на ядро" (lite_thread_shard()), -1 выполнение общими потоками.
+	// Задавать до отправки сообщений актору
+	void home_set(int n) noexcept {
+		home = (n < 0 ? -1 : n);
+	}
+
+	// Поток режима "поток на ядро", -1 не привязан
+	int home_get() const noexcept {
+		return home;
+	}
+
+	void *operator new(size_t size) {
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_actor_create++;
+		#endif
+		return lite_align64_t::operator new(size);
+	}
+
+	// Создание актора сразу привязанным к ресурсу res: new(res) actor_t. Память выделяется на узле NUMA ресурса
+	void *operator new(size_t size, lite_resource_t* res) {
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_actor_create++;
+		#endif
+		assert(res != NULL);
+		void* p = lite_align64_t::alloc_numa(size, res->numa_get());
+		ti().res_new = res;
+		return p;
+	}
+
+	void operator delete(void *p) {
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_actor_erase++;
+		#endif
+		lite_align64_t::operator delete(p);
+	}
+
+	void operator delete(void *p, lite_resource_t*) {
+		ti().res_new = NULL;
+		operator delete(p);
+	}
+
+	// Узел NUMA, на котором выполняется актор. -1 не привязан
+	int numa_get() const noexcept {
+		lite_resource_t* res = resource_get();
+		return res == NULL ? -1 : res->numa_get();
+	}
+
+	//-----------------------------------------------------------------------------------
+	// Обработчик сообщения, прописывать в дочернем классе
+	virtual void recv(lite_msg_t*) = 0;
+
+	virtual void before_destroy() {
+	}
+
+	virtual void timer() {
+		lite_log(LITE_ERROR_NOT_IMPLEMENTED, "%s method timer() is not implemented.", name_get().c_str());
+	}
+
+	// Сообщение устарело (msg->deadline, queue_age_set()) и вместо recv() передается сюда. По умолчанию удаляется
+	virtual void on_expired(lite_msg_t*) {
+	}
+
+	virtual ~lite_actor_t() {
+		reserve_set(0); // Резерв удаленного актора не ждет никто
+		prio_clear();
+		delete metrics.load();
+		delete e2e.load();
+	}
+
+private:
+	// static переменные уровня потока -------------------------------------------------
+	struct thread_info_t : public lite_thread_info_t<thread_info_t> {
+		lite_msg_t* msg_del;		// Обрабатываемое сообщение, будет удалено после обработки
+		lite_actor_t* la_next_run;	// Следующий на выполнение актор
+		lite_actor_t* la_now_run;	// Текущий актор
+		lite_resource_t* lr_now_used;// Текущий захваченный ресурс
+		int lr_weight;				// Захвачено единиц lr_now_used
+		lite_resource_t* res_new;	// Ресурс для создаваемого через new(res) актора
+		int numa;					// Потоку разрешено выполнять: 0 не привязанные к NUMA, n+1 привязанные к узлу n, -1 все
+		bool affinity_skip;			// Пропущен актор, ожидающий свой поток
+		int lifo_run;				// Запусков из слота LIFO (la_next_run) подряд
+		int prio_skip;				// Выборов из кэша подряд без перебора при заданных приоритетах
+		lite_block_t* blk;			// Состояние блокирующего вызова потока, NULL не поток библиотеки
+		uint64_t trace_id;			// Запрос сквозной трассировки обрабатываемого сообщения, 0 нет
+		int64_t trace_origin;		// Начало запроса trace_id, нсек.
+		bool trace_sent;			// В recv() запрос продолжен отправкой
+		uint32_t trace_rnd;			// Состояние генератора выборки
+	};
+
+	static thread_info_t& ti() noexcept {
+		return thread_info_t::tls_get();
+	}
+
+	// static переменные глобальные ----------------------------------------------------
+	typedef std::unordered_map<std::string, lite_actor_t*> lite_name_idx_t;
+	typedef std::vector<lite_actor_t*> lite_actor_list_t;
+
+	struct static_info_t : public lite_static_info_t<static_info_t> {
+		lite_name_idx_t la_name_idx;// Индекс для поиска lite_actor_t* по имени
+		lite_mutex_t mtx_idx;		// Блокировка для доступа к la_idx. В случае одновременной блокировки сначала mtx_idx затем mtx_list
+		lite_actor_list_t la_list;	// Список акторов
+		lite_mutex_t mtx_list;		// Блокировка для доступа к la_list
+		lite_resource_t* res_default;// Ресурс по умолчанию
+		bool res_default_user;		// Максимум ресурса по умолчанию задан через lite_thread_max()
+		int steal_delay = { LT_STEAL_DELAY_US };// Ожидание своего потока, мксек.
+		std::atomic<int> throttled = { 0 };	// Акторов, ожидающих токены ограничения скорости
+		std::atomic<bool> prio_weighted = { false };	// Взвешенный выбор уровня, иначе строгий
+		std::atomic<int> prio_ready = { 0 };	// Готовых акторов HIGH всех ресурсов (сумма lite_resource_t::prio_ready)
+		std::atomic<size_t> prio_tick = { 0 };	// Счетчик взвешенного выбора
+		std::atomic<bool> is_destroy;// Идет удаление всех акторов
+		lite_mutex_t mtx_reserve;	// Блокировка резервов тяжелых захватов акторов (reserved)
+		std::atomic<bool> metrics_on = { false };	// Ведутся счетчики акторов (lite_stats_enable())
+		std::atomic<uint32_t> e2e_threshold = { 0 };	// Выборка сквозной трассировки: доля * 2^32, 0 - выключена
+		std::atomic<uint64_t> e2e_seq = { 0 };		// Счетчик номеров запросов
+	};
+
+	static static_info_t& si() noexcept {
+		return static_info_t::si();
+	}
+
+	// static методы глобальные ----------------------------------------------------
+	// Сохранение в кэш указателя на актор ожидающий исполнения. wake = false - не будить другие потоки
+	static void cache_push(lite_actor_t* la, bool wake = true) noexcept {
+		assert(la != NULL);
+		if (!la->is_pending()) return;
+		if (la->priority < LT_PRIORITY_NORMAL) la->prio_mark(); // До проверки кэша и ресурса: выбрать его при освобождении
+		// Актор занятого ресурса тоже записывается в кэш: его проверит захвативший ресурс поток
+		if (la->in_cache) return;
+		// Тяжелому не хватает свободных единиц: резерв, чтобы держащие ресурс легкие его освободили
+		if (la->weight_run() > 1) la->reserve_heavy();
+
+		thread_info_t& t = ti();
+		if (t.la_now_run != NULL && t.la_now_run->msg_queue.empty() && t.lifo_run < LT_LIFO_MAX && la->is_here(t) && la->is_res_ready(t)
+			&& !la->prefer_other()) {
+			// Выпоняется последнее задание текущего актора, получатель выполняется следующим в этом потоке (слот LIFO).
+			// Ранее записанный в слот уходит в общий кэш, т.к. этот поток до него не скоро доберется
+			lite_actor_t* prev = t.la_next_run;
+			t.la_next_run = la;
+			if (prev == NULL || prev == la) return; // Лишней работы нет, других потоков не будим
+			la = prev;
+			wake = true;
+		}
+		cache_shared(la, wake);
+	}
+
+	// Ожидает ли актор другой поток (lite_thread_affinity())
+	bool prefer_other() noexcept {
+		if (!lite_opt_t::on(lite_opt_t::LT_OPT_AFFINITY)) return false;
+		size_t run = run_thread.load(std::memory_order_relaxed);
+		return run != 999 && run != lite_thread_num();
+	}
+
+	// Запись в кэш ресурса, доступный всем потокам, с пробуждением свободного потока
+	// wake = false - актор уже был готов к запуску, пробуждение для него уже было
+	LT_NOINLINE static void cache_shared(lite_actor_t* la, bool wake = true) noexcept {
+		bool prefer = la->prefer_other();
+		if (prefer) la->ready_time.store(time_us(), std::memory_order_relaxed);
+
+		// Запись в кэш ресурса
+		lite_resource_t* res = la->resource_get();
+		res->la_cache.push(la);
+		if (!wake) return;
+
+		// Запись очереди и кэша до проверки занятости ресурса: освобождающий его поток перед сном проверяет кэши.
+		// В слоте LIFO актор выполнит текущий поток, там барьер не нужен
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(res->is_free()) {
+			if (prefer) {
+				lite_thread_wake_up_prefer(res->thread_class(), la->run_thread.load(std::memory_order_relaxed)); // Пробуждение прошлого потока актора
+			} else if (res->thread_class() < 0) {
+				lite_thread_wake_up();
+			} else {
+				lite_thread_wake_up_numa(res->thread_class());
+			}
+		}
+	}
+
+	// Получение из кэша указателя на актор ожидающий исполнения
+	static lite_actor_t* cache_pop() noexcept {
+		thread_info_t& t = ti();
+		// Проверка локального кэша
+		lite_actor_t* la = t.la_next_run;
+		if (la != NULL) {
+			t.la_next_run = NULL;
+			if (la->is_ready_here() && la->priority <= LT_PRIORITY_NORMAL) {
+				t.lifo_run++;
+				if (lite_opt_t::on(lite_opt_t::LT_OPT_METRICS)) la->metrics_get()->my().handoff.fetch_add(1, std::memory_order_relaxed);
+				return la;
+			} else {
+				#ifdef LT_STAT
+				lite_thread_stat_t::ti().stat_cache_bad++;
+				#endif			
+				la = NULL;
+			}
+		}
+
+		if(t.lr_now_used != NULL) {
+			// Проверка кэша используемого ресурса
+			while ((la = t.lr_now_used->la_cache.pop()) != NULL) {
+				if (la->is_ready_here() && la->priority <= LT_PRIORITY_NORMAL) { // LOW только перебором
+					t.lifo_run = 0;
+					if (lite_opt_t::on(lite_opt_t::LT_OPT_METRICS)) la->metrics_get()->my().cache_hit.fetch_add(1, std::memory_order_relaxed);
+					return la;
+				}
+			}
+		}
+
+		return NULL;
+	}
+
+	// Поиск ожидающего выполнение
+	static lite_actor_t* find_ready() noexcept {
+		// Извлечение из кэша. Если готов актор HIGH на свободном ресурсе потока - сразу перебор, иначе перебор
+		// раз в LT_PRIORITY_SCAN выборов, чтобы обойденные акторы старели
+		lite_actor_t* ret = NULL;
+		uint32_t opt = lite_opt_t::get();
+		bool prio_on = ((opt & lite_opt_t::LT_OPT_PRIO) != 0);
+		if (!prio_on && (opt & lite_opt_t::LT_OPT_STAMP) == 0) {
+			ret = cache_pop();
+		} else if (!prio_on) {
+			ti().la_next_run = NULL; // Выбор старейшего: кэши не используются
+		} else if (!prio_wait() && ++ti().prio_skip < LT_PRIORITY_SCAN) {
+			ret = cache_pop();
+		} else {
+			ti().prio_skip = 0;
+		}
+		if (ret != NULL) {
+			#ifdef LT_STAT
+			lite_thread_stat_t::ti().stat_cache_found++;
+			#endif
+			return ret;
+		}
+
+		// Поиск перебором списка акторов
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_actor_find++;
+		#endif
+
+		ti().lifo_run = 0;
+		if (prio_on) return find_ready_priority();
+		if ((opt & lite_opt_t::LT_OPT_STAMP) != 0) return find_ready_oldest();
+		lite_lock_t lck(si().mtx_list); // Блокировка
+		lite_actor_list_t& la_list = si().la_list;
+		for (lite_actor_list_t::iterator it = la_list.begin(); it != la_list.end(); ++it) {
+			if ((*it)->is_ready_here()) {
+				ret = (*it);
+				ret->in_cache = true;
+				if(it != si().la_list.begin()) {
+					// Сдвиг активных ближе к началу
+					lite_actor_list_t::iterator it2 = it;
+					--it2;
+					(*it) = (*it2);
+					(*it2) = ret;
+				}
+				break;
+			} 
+		}
+		return ret;
+	}
+
+	// Ждет ли актор HIGH, которого может выполнить текущий поток. Без готовых HIGH - одно чтение счетчика
+	static bool prio_wait() noexcept {
+		if (si().prio_ready.load(std::memory_order_relaxed) == 0) return false;
+		int numa = ti().numa;
+		return lite_resource_manage_t::prio_any(numa == -1 ? -2 : numa - 1);
+	}
+
+	// Поиск перебором с учетом приоритета: первый готовый каждого уровня, выбор уровня строгий или
+	// взвешенный (LT_PRIORITY_WEIGHTS). Обойденные стареют и через LT_PRIORITY_AGING переборов выбираются как HIGH
+	static lite_actor_t* find_ready_priority() noexcept {
+		lite_actor_t* cand[LT_PRIORITY_LEVELS] = {};
+		lite_actor_list_t::iterator pos[LT_PRIORITY_LEVELS];
+		bool weighted = si().prio_weighted.load(std::memory_order_relaxed);
+		lite_lock_t lck(si().mtx_list); // Блокировка
+		lite_actor_list_t& la_list = si().la_list;
+		for (lite_actor_list_t::iterator it = la_list.begin(); it != la_list.end(); ++it) {
+			lite_actor_t* la = *it;
+			if (!la->is_ready_here()) {
+				if (la->prio_res.load(std::memory_order_relaxed) != NULL && !la->is_pending()) la->prio_clear(); // Запускать нечего
+				continue;
+			}
+			int lvl = (la->age >= LT_PRIORITY_AGING ? LT_PRIORITY_HIGH : la->priority);
+			if (cand[lvl] != NULL) continue;
+			cand[lvl] = la;
+			pos[lvl] = it;
+			if (lvl == LT_PRIORITY_HIGH && !weighted) break; // Лучше не найти
+		}
+		// Выбор уровня
+		int lvl = 0;
+		while (lvl < LT_PRIORITY_LEVELS && cand[lvl] == NULL) lvl++;
+		if (lvl == LT_PRIORITY_LEVELS) return NULL;
+		if (weighted) {
+			static const int w[LT_PRIORITY_LEVELS] = { LT_PRIORITY_WEIGHTS };
+			int total = 0;
+			for (int i = 0; i < LT_PRIORITY_LEVELS; i++) total += w[i];
+			int pick = (int)(si().prio_tick++ % total);
+			int i = 0;
+			while (pick >= w[i]) pick -= w[i++];
+			if (cand[i] != NULL) lvl = i;
+		}
+		// Обойденные стареют
+		for (int i = 0; i < LT_PRIORITY_LEVELS; i++) {
+			if (i != lvl && cand[i] != NULL) cand[i]->age++;
+		}
+		lite_actor_t* ret = cand[lvl];
+		ret->age = 0;
+		ret->in_cache = true;
+		lite_actor_list_t::iterator it = pos[lvl];
+		if (it != la_list.begin()) {
+			// Сдвиг активных ближе к началу
+			lite_actor_list_t::iterator it2 = it;
+			--it2;
+			(*it) = (*it2);
+			(*it2) = ret;
+		}
+		return ret;
+	}
+
+	// Номер интервала LT_OLDEST_BUCKET_US метки времени сообщения. Без метки - самый поздний
+	static int64_t oldest_bucket(int64_t time) noexcept {
+		return (time == 0 ? INT64_MAX : time / (LT_OLDEST_BUCKET_US * 1000));
+	}
+
+	// Поиск перебором актора со старейшим первым сообщением (с точностью LT_OLDEST_BUCKET_US),
+	// при равенстве - ближайшего к началу списка
+	static lite_actor_t* find_ready_oldest() noexcept {
+		lite_actor_t* ret = NULL;
+		lite_actor_list_t::iterator pos;
+		int64_t best = 0;
+		lite_lock_t lck(si().mtx_list); // Блокировка
+		lite_actor_list_t& la_list = si().la_list;
+		for (lite_actor_list_t::iterator it = la_list.begin(); it != la_list.end(); ++it) {
+			lite_actor_t* la = *it;
+			if (!la->is_ready_here()) continue;
+			int64_t b = oldest_bucket(la->msg_queue.head_get());
+			if (ret == NULL || b < best) {
+				ret = la;
+				pos = it;
+				best = b;
+			}
+		}
+		if (ret == NULL) return NULL;
+		ret->in_cache = true;
+		if (pos != la_list.begin()) {
+			// Сдвиг активных ближе к началу
+			lite_actor_list_t::iterator it2 = pos;
+			--it2;
+			(*pos) = (*it2);
+			(*it2) = ret;
+		}
+		return ret;
+	}
+
+	// Мог ли стать готовым актор, пропущенный поиском перед засыпанием потока. Отправитель не будит
+	// поток, если ресурс актора захвачен (им мог быть этот поток), или другой поток ищет работу и уже
+	// прошел этот актор. Актор в обоих случаях остается в кэше своего ресурса: проверяются кэши
+	// свободных ресурсов потока, готовый переносится в слот LIFO
+	static bool ready_missed() noexcept {
+		thread_info_t& t = ti();
+		if (t.la_next_run != NULL) return true;
+		lite_actor_t* la;
+		while ((la = lite_resource_manage_t::cache_pop(t.numa - 1 < -1 ? -2 : t.numa - 1)) != NULL) {
+			if (la->is_ready_here()) {
+				t.la_next_run = la;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Количество готовых к выполнению
+	static size_t count_ready() noexcept {
+		lite_lock_t lck(si().mtx_list); // Блокировка
+		size_t cnt = 0;
+		for (lite_actor_list_t::iterator it = si().la_list.begin(); it != si().la_list.end(); ++it) {
+			if ((*it)->is_ready()) {
+				cnt += (*it)->actor_free;
+			}
+		}
+		return cnt;
+	}
+
+	// Время для задержки перехвата, мксек.
+	static int64_t time_us() noexcept {
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Ресурс по умолчанию, создается при первом обращении
+	static lite_resource_t* resource_default() noexcept {
+		if(si().res_default == NULL) {
+			si().res_default = lite_resource_manage_t::get("CPU", lite_cpu_topology_t::resource_default_max());
+			si().res_default->lend_set(true);
+		}
+		return si().res_default;
+	}
+
+	// Захват и освобождение ресурса
+	static bool resource_lock(lite_resource_t* res, int weight = 1) {
+		// Проверка что уже захвачен. При резерве более тяжелого захвата захваченное освобождается
+		if (res == ti().lr_now_used && weight <= ti().lr_weight && (res == NULL || !res->is_reserved(weight))) return true;
+		// Освобождение ранее захваченного
+		if (ti().lr_now_used != NULL) ti().lr_now_used->unlock(ti().lr_weight);
+		ti().lr_now_used = NULL;
+		ti().lr_weight = 0;
+		// Захват нового
+		bool ret = (res == NULL || res->lock(weight));
+		if (ret) {
+			ti().lr_now_used = res;
+			ti().lr_weight = (res == NULL ? 0 : weight);
+		}
+		if (ti().blk != NULL) ti().blk->res_used = (ret && res != NULL && res->lend_get() ? res : NULL);
+		return ret;
+	}
+
+	// Освобождение захваченного ресурса. true - его ждет захват с большим весом, стоит поискать готовых снова
+	static bool resource_release() noexcept {
+		lite_resource_t* res = ti().lr_now_used;
+		if (res == NULL) return false;
+		bool reserved = res->is_reserved();
+		resource_lock(NULL);
+		return reserved;
+	}
+
+	// Довести захват текущего ресурса до weight единиц, не освобождая захваченные
+	static bool resource_upgrade(int weight) noexcept {
+		thread_info_t& t = ti();
+		if (t.lr_now_used == NULL || weight <= t.lr_weight) return true;
+		if (!t.lr_now_used->lock(weight - t.lr_weight)) return false;
+		t.lr_weight = weight;
+		return true;
+	}
+
+	// Выдача взаймы единицы ресурса, захваченного заблокированным потоком b. true - выдано
+	static bool block_lend(lite_block_t* b) noexcept {
+		lite_resource_t* res = b->res_used;
+		lite_resource_t* exp = NULL;
+		if (res == NULL || res->lent_get() >= LT_BLOCK_LEND_MAX || !b->res_lent.compare_exchange_strong(exp, res)) return false;
+		res->lend();
+		lite_thread_wake_up_block(res->thread_class()); // Свободный или новый поток займет выданную единицу
+		return true;
+	}
+
+	// Возврат выданного взаймы
+	LT_NOINLINE static void block_reclaim(lite_block_t* b) noexcept {
+		lite_resource_t* res = b->res_lent.exchange(NULL);
+		if (res != NULL) res->reclaim();
+	}
+
+	// Добавление в список акторов
+	static void list_add(lite_actor_t* la) noexcept {
+		lite_lock_t lck2(si().mtx_list); // Блокировка
+		si().la_list.push_back(la);
+	}
+
+	// Установка имени актора
+	static void name_set(lite_actor_t* la, const std::string& name) {
+		lite_lock_t lck(si().mtx_idx); // Блокировка
+		lite_name_idx_t::iterator it = si().la_name_idx.find(name); // Поиск по индексу
+		if (it != si().la_name_idx.end()) {
+			if(it->second != la) lite_log(LITE_ERROR_ACTOR_DOUBLE, "Actor '%s' already exists", name.c_str());
+		} else if(!la->name.empty()) {
+			lite_log(LITE_ERROR_ACTOR_NAME, "Try set name '%s' to actor '%s'", name.c_str(), la->name.c_str());
+		} else {
+			si().la_name_idx[name] = la;
+			la->name = name;
+		}
+	}
+
+	// Очистка всего
+	static void clear() noexcept {
+		si().is_destroy = true;
+		while (!si().la_list.empty()) {
+			lite_actor_t* la_del = NULL;
+			{
+				lite_lock_t lck(si().mtx_list); // Блокировка
+				if (si().la_list.back()->name == "log") { // "log" удаляется последним, т.к. могли быть записи в деструкторах
+					la_del = si().la_list[0];
+					si().la_list[0] = si().la_list.back();
+				}
+				else {
+					la_del = si().la_list.back();
+				}
+				si().la_list.pop_back();
+			}
+			if (la_del->name == "log") {
+				la_del->run_all();
+				resource_lock(NULL);
+			} else {
+				la_del->before_destroy();
+			}
+			if (!la_del->name.empty()) { // Удаление из индекса
+				lite_lock_t lck(si().mtx_idx); // Блокировка
+				lite_name_idx_t::iterator it = si().la_name_idx.find(la_del->name);
+				if (it != si().la_name_idx.end()) si().la_name_idx.erase(it);
+			}
+			delete la_del;
+		}
+
+		assert(si().la_name_idx.empty());
+
+		si().res_default = NULL;
+		si().res_default_user = false;
+		si().is_destroy = false;
+	}
+
+public: //-------------------------------------------------------------
+
+	// Удаление одного актора
+	static void destroy(lite_actor_t *la_del) noexcept {
+		if (si().is_destroy) return; // Идет удаление всех
+		if (la_del->home >= 0 && lite_shard_push(la_del->home, la_del, LT_SHARD_DESTROY)) return; // Удаление в потоке актора
+
+		bool is_del = false;
+		// Удаление из списка
+		{
+			lite_lock_t lck(si().mtx_list); // Блокировка
+			for (auto & l : si().la_list) {
+				if (l == la_del) {
+					if (l != si().la_list.back()) { // Если не последний, то перенос в конец
+						l = si().la_list.back();
+					}
+					si().la_list.pop_back();
+					is_del = true;
+					break;
+				}
+			}
+		}
+		if (is_del && !la_del->name.empty()) { // Удаление из индекса
+			lite_lock_t lck(si().mtx_idx); // Блокировка
+			lite_name_idx_t::iterator it = si().la_name_idx.find(la_del->name);
+			if (it != si().la_name_idx.end()) si().la_name_idx.erase(it);
+		}
+		// Дообработка оставщихся сообщений
+		if (is_del) {
+			la_del->timer_set(0);
+			la_del->before_destroy();
+			while (!la_del->msg_queue.empty()) {
+				la_del->run_all();
+				if (!la_del->msg_queue.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(20)); 
+			}
+			la_del->timer_set(0); // Пробуждение после ожидания токенов
+			assert(la_del->msg_queue.empty());
+			delete la_del;
+		}
+	}
+
+	// Получание актора по имени
+	static lite_actor_t* name_find(const std::string& name) {
+		lite_lock_t lck(si().mtx_idx); // Блокировка
+		lite_name_idx_t::iterator it = si().la_name_idx.find(name); // Поиск по индексу
+		lite_actor_t* la = NULL;
+		if (it != si().la_name_idx.end()) {
+			la = it->second;
+		}
+		return la;
+	}
+
+	// Копирование сообщения
+	template <typename T>
+	static T* msg_copy(T* msg) noexcept {
+		if (ti().msg_del == msg) {
+			ti().msg_del = NULL; // Снятие пометки на удаление
+			return msg;
+		} else {
+			T* msg2 = new T(*msg);
+			return msg2;
+		}
+	}
+
+	// Установка максимума ресурсу по умолчанию
+	static void resource_max(int max) noexcept {
+		si().res_default_user = true;
+		resource_default()->max_user_set(max);
+	}
+
+	// Пересчет максимума ресурса по умолчанию после изменения ограничений процессоров
+	static void resource_default_update() noexcept {
+		if (si().res_default != NULL && !si().res_default_user) {
+			si().res_default->max_set(lite_cpu_topology_t::resource_default_max());
+		}
+	}
+
+	// Задержка перехвата актора чужим потоком, мксек. 0 - без задержки
+	static void steal_delay_set(int us) noexcept {
+		si().steal_delay = (us > 0 ? us : 0);
+		lite_opt_t::set(lite_opt_t::LT_OPT_AFFINITY, us > 0);
+	}
+
+	static int steal_delay() noexcept {
+		return si().steal_delay;
+	}
+
+	// Был ли пропущен актор, ожидающий свой поток. Сбрасывает признак
+	static bool affinity_skipped() noexcept {
+		bool ret = ti().affinity_skip;
+		ti().affinity_skip = false;
+		return ret;
+	}
+
+	// Состояние блокирующего вызова для текущего потока (вызывается потоком библиотеки при старте)
+	static void block_set(lite_block_t* b) noexcept {
+		ti().blk = b;
+	}
+
+	// Начало блокирующего участка: единица захваченного ресурса сразу выдается взаймы
+	static void block_begin() noexcept {
+		lite_block_t* b = ti().blk;
+		if (b == NULL || b->scope++ > 0) return;
+		if (block_lend(b)) {
+			#ifdef LT_STAT
+			lite_thread_stat_t::ti().stat_block_scope++;
+			#endif
+		}
+	}
+
+	// Завершение блокирующего участка
+	static void block_end() noexcept {
+		lite_block_t* b = ti().blk;
+		if (b == NULL || --b->scope > 0) return;
+		block_reclaim(b);
+	}
+
+	// Какие акторы выполняет текущий поток: -1 все, иначе привязанные к узлу NUMA numa - 1 (0 не привязанные)
+	static void thread_numa(int numa) noexcept {
+		ti().numa = numa;
+	}
+
+	// Извещение о завершении потока
+	static void thread_end() {
+		thread_info_t::tls_free();
+	}
+};
+
+// Начало запроса сквозной трассировки
+inline void lite_msg_t::trace_begin() noexcept {
+	uint64_t id = lite_actor_t::e2e_sample();
+	e2e_set(id, id != 0 ? lite_clock_ns() : 0);
+}
+
+// Окончание запроса сквозной трассировки
+inline void lite_msg_t::trace_end() noexcept {
+	lite_actor_t::e2e_end(this);
+}
+
+// Снимок графа обменов
+inline std::vector<lite_graph_edge_t> lite_graph_t::snapshot() {
+	edge_map_t map = collect();
+	std::unordered_map<const void*, std::string> names;
+	lite_actor_t::names_get(names);
+	double sec = (double)(lite_clock_ns() - si().start) / 1000000000;
+	if (sec <= 0) sec = 1e-9;
+	std::vector<lite_graph_edge_t> ret;
+	for (auto& it : map) {
+		lite_graph_edge_t e;
+		e.from = it.first.from;
+		e.to = it.first.to;
+		auto nm = names.find(e.from);
+		e.from_name = (e.from == NULL ? "external" : nm != names.end() ? nm->second : "actor#" + std::to_string((size_t)e.from));
+		nm = names.find(e.to);
+		e.to_name = (nm != names.end() ? nm->second : "actor#" + std::to_string((size_t)e.to));
+		e.type = it.first.type;
+		e.type_name = (it.second.type_name != NULL ? it.second.type_name : lite_msg_t::type_name(e.type));
+		e.count = it.second.count;
+		e.bytes = it.second.bytes;
+		e.rate = (double)e.count / sec;
+		e.byte_rate = (double)e.bytes / sec;
+		ret.push_back(e);
+	}
+	std::sort(ret.begin(), ret.end(), [](const lite_graph_edge_t& a, const lite_graph_edge_t& b) { return a.count > b.count; });
+	return ret;
+}
+
+// Выгрузка графа обменов. DOT: толщина ребра по количеству сообщений относительно самого частого
+inline bool lite_graph_t::dump(const std::string& file, bool json) {
+	std::vector<lite_graph_edge_t> edges = snapshot();
+	FILE* f = fopen(file.c_str(), "w");
+	if (f == NULL) return false;
+	if (json) {
+		fprintf(f, "{\"seconds\":%.3f,\"edges\":[", (double)(lite_clock_ns() - si().start) / 1000000000);
+		for (size_t i = 0; i < edges.size(); i++) {
+			const lite_graph_edge_t& e = edges[i];
+			fprintf(f, "%s\n{\"from\":\"%s\",\"to\":\"%s\",\"type\":\"%s\",\"count\":%llu,\"bytes\":%llu,\"rate\":%.1f,\"byte_rate\":%.1f}",
+				(i > 0 ? "," : ""), lite_trace_t::json_str(e.from_name).c_str(), lite_trace_t::json_str(e.to_name).c_str(), 
+				lite_trace_t::json_str(e.type_name).c_str(), (unsigned long long)e.count, (unsigned long long)e.bytes, e.rate, e.byte_rate);
+		}
+		fprintf(f, "\n]}\n");
+	} else {
+		uint64_t max = (edges.empty() ? 1 : edges[0].count);
+		fprintf(f, "digraph lite_thread {\n\tnode [shape=box];\n");
+		for (const lite_graph_edge_t& e : edges) {
+			fprintf(f, "\t\"%s\" -> \"%s\" [label=\"%s\\n%llu msg %.0f/s\\n%llu B %.0f B/s\", penwidth=%.1f];\n",
+				lite_trace_t::json_str(e.from_name).c_str(), lite_trace_t::json_str(e.to_name).c_str(), lite_trace_t::json_str(e.type_name).c_str(),
+				(unsigned long long)e.count, e.rate, (unsigned long long)e.bytes, e.byte_rate, 1 + 5.0 * e.count / max);
+		}
+		fprintf(f, "}\n");
+	}
+	bool ok = (ferror(f) == 0);
+	fclose(f);
+	return ok;
+}
+
+// Выгрузка трассировки. События, перезаписанные или записываемые потоком во время чтения, отбрасываются
+inline bool lite_trace_t::dump(const std::string& file) {
+	std::vector<event_t> list;
+	{
+		std::lock_guard<std::mutex> lck(si().mtx);
+		for (ring_t* r : si().rings) {
+			uint64_t head = r->head.load(std::memory_order_acquire);
+			uint64_t from = (head > LT_TRACE_RING ? head - LT_TRACE_RING : 0);
+			if (from < r->base) from = r->base; // Записанные до start()
+			size_t n = list.size();
+			for (uint64_t i = from; i < head; i++) list.push_back(r->buf[i & (LT_TRACE_RING - 1)]);
+			std::atomic_thread_fence(std::memory_order_acquire); // Копирование до повторного чтения head
+			uint64_t head2 = r->head.load(std::memory_order_relaxed);
+			// Начало перезаписано. Слот head2 поток может записывать прямо сейчас (head еще не увеличен),
+			// поэтому событие head2 - LT_TRACE_RING тоже считается потерянным
+			if (head2 + 1 > from + LT_TRACE_RING) {
+				size_t lost = (size_t)(head2 + 1 - from - LT_TRACE_RING);
+				if (lost > head - from) lost = (size_t)(head - from);
+				list.erase(list.begin() + n, list.begin() + n + lost);
+			}
+		}
+	}
+	std::unordered_map<const void*, std::string> names;
+	lite_resource_manage_t::names_get(names);
+	lite_actor_t::names_get(names);
+	auto name = [&names](const void* p) -> std::string {
+		auto it = names.find(p);
+		if (it != names.end()) return json_str(it->second);
+		return "actor#" + std::to_string((size_t)p); // Удален
+	};
+
+	FILE* f = fopen(file.c_str(), "w");
+	if (f == NULL) return false;
+	fprintf(f, "{\"traceEvents\":[\n");
+	std::map<int, bool> tids;
+	for (const event_t& e : list) tids[e.tid] = true;
+	bool next = false;
+	for (auto& it : tids) {
+		fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s%d\"}}", (next ? ",\n" : ""),
+			it.first, (it.first < 1000 ? "thread#" : "external#"), (it.first < 1000 ? it.first : it.first - 1000));
+		next = true;
+	}
+	for (const event_t& e : list) {
+		double ts = (double)(e.time - si().start) / 1000; // Мксек.
+		fprintf(f, "%s", (next ? ",\n" : ""));
+		next = true;
+		switch (e.type) {
+		case LT_TRACE_RUN:
+			fprintf(f, "{\"ph\":\"X\",\"cat\":\"actor\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"resource\":\"%s\",\"msg\":%llu}}",
+				name(e.obj).c_str(), e.tid, ts, (double)e.dur / 1000, (e.res != NULL ? name(e.res).c_str() : ""), (unsigned long long)e.flow);
+			break;
+		case LT_TRACE_SEND:
+			fprintf(f, "{\"ph\":\"s\",\"cat\":\"msg\",\"name\":\"msg\",\"id\":\"0x%llx\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"to\":\"%s\"}}",
+				(unsigned long long)e.flow, e.tid, ts, name(e.obj).c_str());
+			break;
+		case LT_TRACE_RECV:
+			fprintf(f, "{\"ph\":\"f\",\"bp\":\"e\",\"cat\":\"msg\",\"name\":\"msg\",\"id\":\"0x%llx\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+				(unsigned long long)e.flow, e.tid, ts);
+			break;
+		case LT_TRACE_SLEEP:
+			fprintf(f, "{\"ph\":\"X\",\"cat\":\"thread\",\"name\":\"sleep\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", e.tid, ts, (double)e.dur / 1000);
+			break;
+		case LT_TRACE_WAKE:
+			fprintf(f, "{\"ph\":\"i\",\"s\":\"t\",\"cat\":\"thread\",\"name\":\"wake\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"thread\":%llu}}",
+				e.tid, ts, (unsigned long long)e.flow);
+			break;
+		default: // LT_TRACE_TIMER
+			fprintf(f, "{\"ph\":\"i\",\"s\":\"t\",\"cat\":\"actor\",\"name\":\"timer\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"actor\":\"%s\"}}",
+				e.tid, ts, name(e.obj).c_str());
+		}
+	}
+	fprintf(f, "\n],\"displayTimeUnit\":\"ns\"}\n");
+	bool ok = (ferror(f) == 0);
+	fclose(f);
+	return ok;
+}
+
+// Сообщение на узле NUMA получателя
+inline void* lite_msg_t::operator new(size_t size, lite_resource_t* res) {
+	#ifdef LT_STAT
+	lite_thread_stat_t::ti().stat_msg_create++;
+	#endif
+	return lite_align64_t::alloc_numa(size, res == NULL ? -1 : res->numa_get());
+}
+
+inline void* lite_msg_t::operator new(size_t size, lite_actor_t* la) {
+	#ifdef LT_STAT
+	lite_thread_stat_t::ti().stat_msg_create++;
+	#endif
+	return lite_align64_t::alloc_numa(size, la == NULL ? -1 : la->numa_get());
+}
+
+//-------------------------------------------------------------------------
+//---------------------- ТАЙМЕР -------------------------------------------
+//-------------------------------------------------------------------------
+// Вызов акторов по таймеру.
+
+class lite_timer_t {
+
+	struct task_t { // Задание
+		lite_actor_t* la;	// Актор
+		int step;			// Периодичность оповещения, мс. 0 - однократное пробуждение после throttle()
+	};
+	typedef std::multimap<int64_t, task_t> task_list_t; // Список заданий с сортировкой по времени срабатывания
+
+	task_list_t task_list;
+
+
+	std::thread thread;			// Поток ожидания
+
+	std::mutex mtx;				// Для засыпания
+	std::condition_variable cv;	// Для засыпания
+
+	// Функция потока
+	static void thread_func(lite_timer_t* const tmr) noexcept {
+		#ifdef LT_DEBUG
+		lite_log(0, "timer thread start");
+		#endif
+		std::unique_lock<std::mutex> lck(tmr->mtx);
+		while(!tmr->task_list.empty()) {
+			int64_t now = lite_time_now(), sleep_ms = 0;
+
+			while(true) { // Запуск тех, у кого время наступило
+				task_list_t::iterator it = tmr->task_list.begin();
+				if (it->first > now) {
+					now = lite_time_now();
+					if(it->first > now) {
+						sleep_ms = it->first - now + 1;
+						break;
+					}
+				}
+				if (it->second.step == 0) { // Однократное
+					it->second.la->throttle_alert();
+					tmr->task_list.erase(it);
+					if (tmr->task_list.empty()) break;
+					continue;
+				}
+				it->second.la->timer_alert();
+				int64_t next = it->first + it->second.step;
+				while(next <= now) next += it->second.step;
+				tmr->task_list.insert(std::pair<int64_t, task_t>(next, it->second));
+				tmr->task_list.erase(it);
+			}
+			if (tmr->task_list.empty()) break; // Выполнены последние однократные
+
+			assert(sleep_ms > 0);
+			tmr->cv.wait_for(lck, std::chrono::milliseconds(sleep_ms)); // Ожидание времени следущей сработки
+		}
+		#ifdef LT_DEBUG
+		lite_log(0, "timer thread stop");
+		#endif	
+	}
+
+	// Поиск настроек актора: периодических (once = false) или однократных
+	task_list_t::iterator find(lite_actor_t* la, bool once = false) noexcept {
+		task_list_t::iterator it = task_list.begin();
+		for(; it != task_list.end(); it++) {
+			if (it->second.la == la && (it->second.step == 0) == once) break;
+		}
+		return it;
+	}
+
+	// Добавление задания под блокировкой lck. start_thread - список был пуст, запуск потока
+	void add(std::unique_lock<std::mutex>& lck, bool start_thread, int64_t time, const task_t& t) noexcept {
+		task_list.insert(std::pair<int64_t, task_t>(time, t));
+
+		lck.unlock();
+		if(start_thread) { // Первое задание. Запуск потока.
+			if(thread.joinable()) {
+				cv.notify_all();
+				thread.join();
+			}
+			thread = std::thread(thread_func, this);
+		} else {
+			cv.notify_all();
+		}
+	}
+
+public:
+	// Добавление таймера 
+	void set(lite_actor_t* la, int time_ms) noexcept {
+		std::unique_lock<std::mutex> lck(mtx); // Блокировка
+		bool start_thread = task_list.empty();
+		#ifdef LT_DEBUG
+		lite_log(0, "timer %d ms for %s start_thread = %d", time_ms, la->name_get().c_str(), start_thread);
+		#endif
+		// Удаление предыдущих настроек для la
+		task_list_t::iterator it = find(la);
+		if (it != task_list.end()) task_list.erase(it);
+
+		if (time_ms <= 0) {
+			it = find(la, true); // Остановка таймера отменяет и однократное пробуждение
+			if (it != task_list.end()) {
+				task_list.erase(it);
+				la->throttle_cancel();
+			}
+			cv.notify_all();
+			return; // Остановка таймера
+		}
+
+
+		task_t t;
+		t.la = la;
+		t.step = time_ms;
+		add(lck, start_thread, lite_time_now() + time_ms, t);
+	}
+
+	// Однократное пробуждение актора через time_ms (throttle_alert()). Заменяет ранее назначенное
+	void once(lite_actor_t* la, int time_ms) noexcept {
+		std::unique_lock<std::mutex> lck(mtx); // Блокировка
+		bool start_thread = task_list.empty();
+		task_list_t::iterator it = find(la, true);
+		if (it != task_list.end()) task_list.erase(it);
+
+		task_t t;
+		t.la = la;
+		t.step = 0;
+		add(lck, start_thread, lite_time_now() + (time_ms < 1 ? 1 : time_ms), t);
+	}
+
+	// Остановка всех таймеров
+	void stop_all() {
+		std::unique_lock<std::mutex> lck(mtx); // Блокировка
+		task_list.clear();
+	}
+
+	// Завершение работы
+	~lite_timer_t() {
+		stop_all();
+		if (thread.joinable()) {
+			cv.notify_all();
+			thread.join();
+		}
+	}
+};
+
+//----------------------------------------------------------------------------------
+//----- ПОТОК НА ЯДРО --------------------------------------------------------------
+//----------------------------------------------------------------------------------
+// Режим без общих данных: каждый актор выполняется только своим потоком, привязанным к ядру.
+// Сообщения между потоками передаются через кольцевые буферы на каждую пару потоков.
+
+class lite_shard_t : lite_align64_t {
+	// Элемент очереди: сообщение актору, вызов таймера или удаление актора
+	struct entry_t {
+		lite_actor_t* la;
+		lite_msg_t* msg;
+	};
+
+	// Кольцевой буфер один писатель - один читатель
+	struct ring_t : public lite_align64_t {
+		std::atomic<size_t> head = { 0 };	// Запись, изменяется писателем
+		char pad1[64 - sizeof(std::atomic<size_t>)];
+		std::atomic<size_t> tail = { 0 };	// Чтение, изменяется читателем
+		char pad2[64 - sizeof(std::atomic<size_t>)];
+		entry_t buf[LT_SHARD_RING];
+
+		bool push(const entry_t& e) noexcept {
+			size_t h = head.load(std::memory_order_relaxed);
+			if (h - tail.load(std::memory_order_acquire) >= LT_SHARD_RING) return false;
+			buf[h % LT_SHARD_RING] = e;
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool pop(entry_t& e) noexcept {
+			size_t t = tail.load(std::memory_order_relaxed);
+			if (t == head.load(std::memory_order_acquire)) return false;
+			e = buf[t % LT_SHARD_RING];
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool empty() const noexcept {
+			return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+		}
+	};
+
+	size_t num;									// Номер потока
+	std::deque<entry_t> local;					// Очередь потока, доступна только ему
+	std::vector<std::atomic<ring_t*>> in;		// Входящие буферы от каждого потока, создаются писателем
+	lite_mutex_t mtx_ext;						// Блокировка ext
+	std::vector<entry_t> ext;					// Входящие от потоков вне режима (main, общие потоки, таймер)
+	std::atomic<bool> ext_has = { 0 };			// ext не пустой
+	std::atomic<bool> sleeping = { 0 };			// Поток ожидает
+	std::atomic<size_t> epoch = { 0 };			// Счетчик пробуждений, для определения завершения работы
+	std::mutex mtx_sleep;						// Для засыпания
+	std::condition_variable cv;					// Для засыпания
+	std::thread thread;
+
+	lite_shard_t(size_t num, size_t count) : num(num), in(count) {
+		for (auto& r : in) r = NULL;
+	}
+
+	~lite_shard_t() {
+		for (auto& r : in) delete r.load();
+	}
+
+	// Общие данные
+	struct static_info_t : public lite_static_info_t<static_info_t> {
+		std::vector<lite_shard_t*> list;			// Потоки
+		std::atomic<int> count = { 0 };				// Потоков для push(), 0 - режим выключен или останавливается
+		std::atomic<int> pushing = { 0 };			// Отправок из потоков вне режима, выполняющихся в push()
+		std::atomic<bool> stop = { 0 };				// Остановка потоков
+		size_t home_next = { 0 };					// Следующий поток для нового актора
+		lite_mutex_t mtx;							// Блокировка home_next
+	};
+
+	static static_info_t& si() noexcept {
+		return static_info_t::si();
+	}
+
+	// Поток режима, в котором выполняется код. NULL - другой поток
+	struct thread_info_t : public lite_thread_info_t<thread_info_t> {
+		lite_shard_t* self;
+	};
+
+	static thread_info_t& ti() noexcept {
+		return thread_info_t::tls_get();
+	}
+
+	// Есть входящие
+	bool has_input() noexcept {
+		if (ext_has) return true;
+		for (auto& r : in) {
+			ring_t* rr = r.load(std::memory_order_acquire);
+			if (rr != NULL && !rr->empty()) return true;
+		}
+		return false;
+	}
+
+	// Перенос входящих в локальную очередь
+	void poll() noexcept {
+		entry_t e;
+		for (auto& r : in) {
+			ring_t* rr = r.load(std::memory_order_acquire);
+			if (rr == NULL) continue;
+			while (rr->pop(e)) local.push_back(e);
+		}
+		if (ext_has) {
+			lite_lock_t lck(mtx_ext);
+			for (auto& x : ext) local.push_back(x);
+			ext.clear();
+			ext_has = false;
+		}
+	}
+
+	// Пробуждение ожидающего потока
+	void wake() noexcept {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleeping.load()) {
+			std::lock_guard<std::mutex> lck(mtx_sleep);
+			sleeping = false;
+			cv.notify_one();
+		}
+	}
+
+	// Функция потока
+	static void thread_func(lite_shard_t* sh) noexcept;
+
+public:
+	// Запуск count потоков, count <= 0 - по количеству доступных процессоров
+	static void start(int count) noexcept {
+		assert(si().list.empty());
+		int max = lite_cpu_topology_t::limit().limit; // Потоков больше чем процессоров не имеет смысла
+		if (count <= 0 || count > max) count = max;
+		si().stop = false;
+		si().home_next = 0;
+		for (int i = 0; i < count; i++) {
+			si().list.push_back(new lite_shard_t(i, count));
+		}
+		for (auto sh : si().list) {
+			sh->thread = std::thread(thread_func, sh);
+		}
+		si().count = count;
+	}
+
+	// Режим включен
+	static bool is_on() noexcept {
+		return !si().list.empty();
+	}
+
+	// Поток для нового актора, -1 режим выключен
+	static int home_next() noexcept {
+		int n = si().count;
+		if (n == 0) return -1;
+		lite_lock_t lck(si().mtx);
+		return (int)(si().home_next++ % n);
+	}
+
+	// Количество потоков
+	static int count() noexcept {
+		return si().count;
+	}
+
+	// Отправка в поток home. msg == NULL вызов timer(), msg == LT_SHARD_DESTROY удаление актора
+	// Возвращает false, если режим выключен или останавливается
+	static bool push(int home, lite_actor_t* la, lite_msg_t* msg) noexcept {
+		if (ti().self != NULL) { // Поток режима, stop() удаляет потоки только после их завершения
+			if (home >= si().count) return false;
+			put(home, la, msg);
+			return true;
+		}
+		si().pushing++; // stop() ждет окончания отправки перед удалением потоков
+		bool ok = (home < si().count);
+		if (ok) put(home, la, msg);
+		si().pushing--;
+		return ok;
+	}
+
+private:
+	static void put(int home, lite_actor_t* la, lite_msg_t* msg) noexcept {
+		assert(home >= 0 && home < (int)si().list.size());
+		lite_shard_t* dst = si().list[home];
+		lite_shard_t* self = ti().self;
+		entry_t e = { la, msg };
+		if (self == dst) { // Свой поток
+			dst->local.push_back(e);
+			return;
+		}
+		if (self != NULL) { // Из другого потока режима, через буфер пары
+			ring_t* r = dst->in[self->num].load(std::memory_order_relaxed);
+			if (r == NULL) {
+				r = new ring_t;
+				dst->in[self->num].store(r, std::memory_order_release);
+			}
+			while (!r->push(e)) { // Буфер полон. Разбор своих входящих, чтобы не было взаимной блокировки
+				self->poll();
+				dst->wake();
+				std::this_thread::yield();
+			}
+		} else {
+			lite_lock_t lck(dst->mtx_ext);
+			dst->ext.push_back(e);
+			dst->ext_has = true;
+		}
+		dst->wake();
+	}
+
+public:
+	// Все потоки простаивают и очереди пусты
+	static bool is_idle() noexcept {
+		std::vector<size_t> ep;
+		for (int pass = 0; pass < 2; pass++) {
+			for (size_t i = 0; i < si().list.size(); i++) {
+				lite_shard_t* sh = si().list[i];
+				if (!sh->sleeping || sh->has_input()) return false;
+				if (pass == 0) {
+					ep.push_back(sh->epoch);
+				} else if (ep[i] != sh->epoch) {
+					return false;
+				}
+			}
+			if (pass == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+
+	// Остановка потоков
+	static void stop() noexcept {
+		si().count = 0; // Новые отправки идут мимо потоков режима
+		while (si().pushing > 0) std::this_thread::yield(); // Дождаться начатых
+		si().stop = true;
+		for (auto sh : si().list) {
+			{
+				std::lock_guard<std::mutex> lck(sh->mtx_sleep);
+				sh->sleeping = false;
+				sh->cv.notify_one();
+			}
+			sh->thread.join();
+		}
+		std::vector<lite_shard_t*> list;
+		list.swap(si().list); // Список пуст до удаления потоков
+		for (auto sh : list) { // Сообщения, не обработанные до остановки: буферы пар, ext и очередь потока
+			sh->poll();
+			for (auto& e : sh->local) local_free(e);
+			delete sh;
+		}
+		si().stop = false;
+	}
+
+private:
+	// Удаление необработанного сообщения
+	static void local_free(entry_t& e) noexcept {
+		if (e.msg != NULL && e.msg != LT_SHARD_DESTROY) delete e.msg;
+	}
+};
+
+//----------------------------------------------------------------------------------
+//----- ПОТОКИ ---------------------------------------------------------------------
+//----------------------------------------------------------------------------------
+
+// Состояние регулятора количества потоков за последнее окно LT_MONITOR_MS
+struct lite_thread_ctl_t {
+	int threads;		// Запущено потоков
+	int target;			// Целевое количество потоков
+	int backlog;		// Готовых к запуску акторов
+	double busy;		// Потоков в среднем выполняли акторы
+	double cpu;			// Из них использовали процессор
+	double blocked;		// Из них ожидали (busy - cpu)
+	int lent;			// Ресурсов выдано взаймы заблокированным потокам
+	size_t grow;		// Решений добавить поток
+	size_t shrink;		// Решений убрать поток
+};
+
+class lite_thread_t : lite_align64_t {
+	size_t num;					// Номер потока
+	int numa;					// Класс потока: узел NUMA (или выделенный пул >= LT_POOL_CLASS), акторы которого выполняет поток. -1 общий
+	std::mutex mtx_sleep;		// Для засыпания
+	std::condition_variable cv;	// Для засыпания
+	bool is_free;				// Поток свободен
+	bool is_end;				// Поток завершен, слот может занять новый поток
+	bool is_stop;				// Поток решил завершиться и больше не учитывается
+	std::atomic<bool> searching;// Поток разбужен и еще не нашел работу
+	std::atomic<int64_t> busy_us;	// Время выполнения акторов, мксек.
+	std::atomic<int64_t> busy_start;// Начало текущего выполнения, 0 - не выполняет
+	int64_t busy_prev;			// busy_us на начало окна регулятора
+	int64_t cpu_prev;			// Процессорное время на начало окна регулятора, мксек.
+	int64_t delay_prev;			// Ожидание в очереди планировщика на начало окна регулятора, мксек. -1 нет данных
+	#ifdef __linux__
+	clockid_t cpu_clock;		// Часы процессорного времени потока
+	pid_t tid;					// Идентификатор потока в системе
+	#endif
+	std::atomic<bool> cpu_clock_ok;	// cpu_clock получены
+	lite_block_t blk;			// Состояние блокирующего вызова
+
+	// Конструктор
+	lite_thread_t(size_t num, int numa) : num(num), numa(numa), is_free(true), is_end(false), is_stop(false), searching(true), 
+		busy_us(0), busy_start(0), busy_prev(0), cpu_prev(0), delay_prev(-1), cpu_clock_ok(false) { }
+
+	// Процессорное время потока, мксек. -1 нет данных
+	int64_t cpu_time() noexcept {
+		#ifdef __linux__
+		struct timespec ts;
+		if (cpu_clock_ok && !is_end && clock_gettime(cpu_clock, &ts) == 0) return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+		#endif
+		return -1;
+	}
+
+	// Время ожидания в очереди планировщика (готов к выполнению, но нет процессора), мксек. -1 нет данных
+	int64_t run_delay() noexcept {
+		#ifdef __linux__
+		if (cpu_clock_ok && !is_end) {
+			char path[64];
+			snprintf(path, sizeof(path), "/proc/self/task/%d/schedstat", (int)tid);
+			FILE* f = fopen(path, "r");
+			if (f != NULL) {
+				unsigned long long run = 0, wait = 0;
+				int n = fscanf(f, "%llu %llu", &run, &wait);
+				fclose(f);
+				if (n == 2) return (int64_t)(wait / 1000);
+			}
+		}
+		#endif
+		return -1;
+	}
+
+	// Общие данные всех потоков
+	struct static_info_t : public lite_static_info_t<static_info_t> {
+		std::atomic<lite_thread_t*> worker_free = {0}; // Указатель на свободный поток
+		std::vector<lite_thread_t*> worker_list;	// Массив описателей потоков, слоты завершенных (is_end) занимают новые
+		std::atomic<size_t> thread_count;			// Количество запущеных потоков
+		lite_mutex_t mtx;							// Блокировка доступа к массиву потоков
+		std::atomic<bool> stop = {0};				// Флаг остановки всех потоков
+		std::mutex mtx_end;							// Для ожидания завершения потоков
+		std::condition_variable cv_end;				// Для ожидания завершения потоков
+		lite_timer_t* timer = { 0 };				// Таймер вызова акторов по времени
+		bool pin = { 0 };							// Привязывать потоки к процессорам
+		std::atomic<int> searching = { 0 };			// Потоков, разбуженных и еще не нашедших работу
+		std::atomic<int64_t> create_next = { 0 };	// Время, раньше которого новый поток не создается, мксек.
+		std::atomic<bool> create_pending = { 0 };	// Создание потока отложено ограничением частоты
+		std::atomic<int> create_numa = { 0 };		// Узел отложенного создания
+		std::atomic<int> target = { 0 };			// Целевое количество потоков, лишние завершаются
+		std::thread monitor;						// Поток регулятора
+		bool monitor_run = { 0 };					// Регулятор запущен
+		bool monitor_stop = { 0 };					// Остановка регулятора
+		std::mutex mtx_ctl;							// Блокировка запуска регулятора и ctl
+		std::mutex mtx_monitor;						// Для ожидания регулятора
+		std::condition_variable cv_monitor;			// Для ожидания регулятора
+		lite_thread_ctl_t ctl = {};					// Состояние регулятора
+	};
+
+	static static_info_t& si() {
+		return static_info_t::si();
+	}
+
+	// Создание потока для акторов узла NUMA numa (-1 не привязанных к узлу, >= LT_POOL_CLASS выделенного пула)
+	static void create_thread(int numa = -1) noexcept {
+		if (si().stop) return;
+		if (lite_cpu_topology_t::limit_update()) lite_actor_t::resource_default_update(); // Изменилась квота
+		// Потоков больше суммы ресурсов работать одновременно не может
+		int limit = lite_resource_manage_t::max_total();
+		int limit_numa = lite_resource_manage_t::max_total(numa);
+		lite_pool_t* pool = lite_resource_manage_t::pool_find(numa);
+		int min = (pool == NULL ? 0 : pool->min);
+		lite_thread_t* lt;
+		{
+			lite_lock_t lck(si().mtx); // Блокировка
+			if (limit > 0 && si().thread_count >= (size_t)limit) return;
+			size_t num = si().worker_list.size(); // Первый слот завершенного потока
+			int cnt = 0;
+			for (size_t i = 0; i < si().worker_list.size(); i++) {
+				lite_thread_t* w = si().worker_list[i];
+				if (w->is_end) {
+					if (num > i) num = i;
+				} else if (w->numa == numa && !w->is_stop) {
+					cnt++;
+				}
+			}
+			if (limit_numa > 0 && cnt >= limit_numa) return;
+			// Ограничение частоты создания, кроме первого потока
+			int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			if (cnt > 0 && cnt >= min && now < si().create_next) {
+				#ifdef LT_STAT
+				lite_thread_stat_t::ti().stat_create_skip++;
+				#endif
+				si().create_numa = numa; // Повтор из wake_up() или регулятора
+				si().create_pending = true;
+				return;
+			}
+			si().create_next = now + LT_THREAD_CREATE_US;
+			if (si().worker_list.size() == num) {
+				si().worker_list.push_back(NULL);
+			} else {
+				assert(si().worker_list[num] != NULL);
+				assert(si().worker_list[num]->is_end);
+				if (si().worker_free == si().worker_list[num]) si().worker_free = NULL;
+				delete si().worker_list[num];
+			}
+			lt = new lite_thread_t(num, numa);
+			si().worker_list[num] = lt;
+			si().thread_count++;
+			if (numa < 0) si().searching++; // Новый поток ищет работу
+			if (si().target < (int)si().thread_count) si().target = (int)si().thread_count;
+		}
+		std::thread th(thread_func, lt);
+		th.detach();
+		monitor_start();
+
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_thread_create++;
+		size_t cnt = si().thread_count;
+		if (lite_thread_stat_t::ti().stat_thread_max < cnt) lite_thread_stat_t::ti().stat_thread_max = cnt;
+		#endif
+	}
+
+	// Повтор создания потока, отложенного ограничением частоты
+	static void create_retry() noexcept {
+		if (!si().create_pending) return;
+		int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		if (now < si().create_next) return;
+		if (si().create_pending.exchange(false)) create_thread(si().create_numa);
+	}
+
+	// Запуск регулятора количества потоков
+	static void monitor_start() noexcept {
+		std::lock_guard<std::mutex> lck(si().mtx_ctl);
+		if (si().monitor_run || si().stop) return;
+		if (si().monitor.joinable()) si().monitor.join(); // Завершившийся ранее
+		si().monitor_run = true;
+		si().monitor_stop = false;
+		si().monitor = std::thread(monitor_func);
+	}
+
+	// Остановка регулятора
+	static void monitor_end() noexcept {
+		{
+			std::lock_guard<std::mutex> lck(si().mtx_monitor);
+			si().monitor_stop = true;
+			si().cv_monitor.notify_all();
+		}
+		if (si().monitor.joinable()) si().monitor.join();
+		si().monitor_run = false;
+		si().monitor_stop = false;
+	}
+
+	// Регулятор: раз в окно LT_MONITOR_MS оценивает загрузку потоков и очередь готовых акторов.
+	// Поток добавляется сразу, если все заняты и есть очередь, убирается после LT_SHRINK_TICKS окон
+	// подряд с низкой загрузкой. Между порогами LT_UTIL_LOW и LT_UTIL_HIGH количество не меняется.
+	static void monitor_func() noexcept {
+		int low_ticks = 0;
+		int threads_prev = 0;
+		int64_t t_prev = lite_actor_t::time_us();
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lck(si().mtx_monitor);
+				if (!si().monitor_stop) si().cv_monitor.wait_for(lck, std::chrono::milliseconds(LT_MONITOR_MS));
+				if (si().monitor_stop) break;
+			}
+			int64_t now = lite_actor_t::time_us();
+			double window = (double)(now - t_prev);
+			t_prev = now;
+			if (window <= 0) continue;
+
+			// Загрузка за окно
+			double busy = 0, cpu = 0;
+			int threads, lent = 0;
+			std::vector<lite_block_t*> blocked;
+			std::vector<lite_block_t*> blocked_maybe; // Без данных об очереди планировщика
+			{
+				lite_lock_t lck(si().mtx); // Блокировка
+				threads = (int)si().thread_count;
+				for (lite_thread_t* w : si().worker_list) {
+					if (w->is_end) continue;
+					int64_t start = w->busy_start;
+					int64_t b = w->busy_us + (start > 0 && now > start ? now - start : 0);
+					double d = (double)(b - w->busy_prev);
+					busy += (d < 0 ? 0 : (d > window ? window : d));
+					w->busy_prev = b;
+					int64_t c = w->cpu_time();
+					if (c >= 0) {
+						int64_t q = w->run_delay();
+						if (w->cpu_prev > 0) {
+							d = (double)(c - w->cpu_prev);
+							if (d < 0) d = 0;
+							cpu += (d > window ? window : d);
+							// Занят все окно и почти не использовал процессор - заблокирован в recv() либо не
+							// получал процессор. Во втором случае растет ожидание в очереди планировщика
+							if (start > 0 && start <= now - (int64_t)window && d < window * LT_BLOCK_CPU / 100) {
+								if (q < 0 || w->delay_prev < 0) {
+									blocked_maybe.push_back(&w->blk);
+								} else if (q - w->delay_prev < window * LT_BLOCK_CPU / 100) {
+									blocked.push_back(&w->blk);
+								}
+							}
+						}
+						w->cpu_prev = c;
+						w->delay_prev = q;
+					}
+					if (w->blk.res_lent != NULL) {
+						if (start == 0 && w->blk.scope == 0) {
+							lite_actor_t::block_reclaim(&w->blk); // Поток уже свободен
+						} else {
+							lent++;
+						}
+					}
+				}
+			}
+			// Без schedstat - только если потоки не заняли все процессоры, иначе займ добавит поток в очередь
+			if (!blocked_maybe.empty() && cpu + window <= lite_cpu_topology_t::limit().limit * window) {
+				blocked.insert(blocked.end(), blocked_maybe.begin(), blocked_maybe.end());
+			}
+			// Компенсация заблокированных потоков
+			for (lite_block_t* b : blocked) {
+				if (lite_actor_t::block_lend(b)) {
+					lent++;
+					#ifdef LT_STAT
+					lite_thread_stat_t::ti().stat_block_lend++;
+					#endif
+				}
+			}
+			busy /= window;
+			cpu /= window;
+			int backlog = (int)lite_actor_t::count_ready();
+			int max = lite_resource_manage_t::max_total();
+			if (backlog > 0) {
+				create_retry(); // Отложенное создание, если с тех пор не было wake_up()
+			} else {
+				si().create_pending = false; // Работы нет, поток не нужен
+			}
+
+			// Решение
+			bool grow = false;
+			if (threads > threads_prev) low_ticks = 0; // Потоки добавлены по требованию, убирать рано
+			threads_prev = threads;
+			if (backlog > 0 && busy >= threads * LT_UTIL_HIGH / 100.0 && (max <= 0 || threads < max)) {
+				grow = true;
+				low_ticks = 0;
+				si().target = threads + 1;
+			} else if (threads > 0 && backlog == 0 && busy <= (threads - 1) * LT_UTIL_LOW / 100.0) {
+				if (++low_ticks >= LT_SHRINK_TICKS) {
+					low_ticks = 0;
+					si().target = threads - 1;
+					{
+						std::lock_guard<std::mutex> lck(si().mtx_ctl);
+						si().ctl.shrink++;
+					}
+					#ifdef LT_STAT
+					lite_thread_stat_t::ti().stat_ctl_shrink++;
+					#endif
+					// Пробуждение свободных потоков, первый лишний из них завершится (retire)
+					lite_lock_t lck(si().mtx); // Блокировка
+					for (lite_thread_t* w : si().worker_list) {
+						if (w->is_free && !w->is_end) w->cv.notify_one();
+					}
+				}
+			} else {
+				low_ticks = 0;
+			}
+			{
+				std::lock_guard<std::mutex> lck(si().mtx_ctl);
+				lite_thread_ctl_t& c = si().ctl;
+				c.threads = threads;
+				c.target = si().target;
+				c.backlog = backlog;
+				c.busy = busy;
+				c.cpu = cpu;
+				c.blocked = (cpu > 0 && busy > cpu ? busy - cpu : 0);
+				c.lent = lent;
+				if (grow) c.grow++;
+			}
+			if (grow) {
+				#ifdef LT_STAT
+				lite_thread_stat_t::ti().stat_ctl_grow++;
+				#endif
+				create_thread();
+			}
+			#ifdef LT_STAT
+			lite_thread_stat_t::ti().store();
+			#endif
+			// Потоков нет и не нужно - регулятор завершается, запустится с новым потоком
+			std::lock_guard<std::mutex> lck(si().mtx_ctl);
+			if (si().thread_count == 0 && si().target == 0) {
+				si().monitor_run = false;
+				break;
+			}
+		}
+		lite_actor_t::thread_end();
+		lite_trace_t::thread_end();
+		lite_graph_t::thread_end();
+		#ifdef LT_STAT
+		lite_thread_stat_t::thread_end();
+		#endif
+	}
+
+	// Поиск свободного потока узла NUMA numa (-1 общего)
+	static lite_thread_t* find_free(int numa = -1) noexcept {
+		lite_thread_t* wf = si().worker_free;
+		if(wf != NULL && wf->is_free && wf->numa == numa) return wf;
+
+		if (si().thread_count == 0) return NULL;
+		wf = NULL;
+		lite_lock_t lck(si().mtx); // Блокировка
+		size_t max = si().worker_list.size();
+		for (size_t i = 0; i < max; i++) {
+			lite_thread_t* w = si().worker_list[i];
+			assert(w != NULL);
+			if (w->is_free && !w->is_end && w->numa == numa) {
+				wf = w;
+				break;
+			}
+		}
+
+		if (numa < 0) si().worker_free = wf;
+		return wf;
+	}
+
+	// Количество потоков класса numa
+	static int class_count(int numa) noexcept {
+		lite_lock_t lck(si().mtx); // Блокировка
+		int cnt = 0;
+		for (lite_thread_t* w : si().worker_list) {
+			if (w->numa == numa && !w->is_end && !w->is_stop) cnt++;
+		}
+		return cnt;
+	}
+
+	// Подсчет работающих потоков
+	static size_t thread_work() noexcept {
+		lite_lock_t lck(si().mtx); // Блокировка
+		size_t ret = 0;
+		for (lite_thread_t* w : si().worker_list) {
+			if (!w->is_free && !w->is_end) ret++;
+		}
+		#ifdef LT_STAT
+		if (lite_thread_stat_t::ti().stat_parallel_run < ret) lite_thread_stat_t::ti().stat_parallel_run = ret;
+		#endif		
+		return ret;
+	}
+
+	// Обработка сообщений
+	static void work_msg(lite_actor_t* la = NULL) noexcept {
+		if (la == NULL) la = lite_actor_t::find_ready();
+		while (la != NULL) {
+			la->run_all();
+			la = lite_actor_t::find_ready();
+			if (la == NULL && lite_actor_t::resource_release()) la = lite_actor_t::find_ready(); // Мог стать готовым тяжелый
+		}
+		lite_actor_t::resource_lock(NULL);
+	}
+
+	// Решение о завершении свободного потока lt: потоков больше целевого (регулятор), потоков пула - больше min.
+	// Завершается любой лишний поток, не только последний: поток пула, удерживаемый min, не мешает уменьшению
+	// общих. Решение под блокировкой, одновременно проснувшиеся потоки не опускают количество ниже цели
+	static bool retire(lite_thread_t* lt, lite_pool_t* pool) noexcept {
+		lite_lock_t lck(si().mtx); // Блокировка
+		int live = 0, cnt = 0;
+		for (lite_thread_t* w : si().worker_list) {
+			if (w->is_end || w->is_stop) continue;
+			live++;
+			if (w->numa == lt->numa) cnt++;
+		}
+		if (live <= si().target || (pool != NULL && cnt <= pool->min)) return false;
+		lt->is_stop = true;
+		lt->is_free = false;
+		return true;
+	}
+
+	// Функция потока
+	static void thread_func(lite_thread_t* const lt) noexcept {
+		#ifdef LT_DEBUG
+		lite_log(0, "thread#%d start", (int)lt->num);
+		#endif
+		this_num(lt->num);
+		#ifdef __linux__
+		lt->tid = (pid_t)syscall(SYS_gettid);
+		if (pthread_getcpuclockid(pthread_self(), &lt->cpu_clock) == 0) lt->cpu_clock_ok = true;
+		#endif
+		lite_actor_t::thread_numa(lt->numa + 1);
+		lite_actor_t::block_set(&lt->blk);
+		lite_pool_t* pool = lite_resource_manage_t::pool_find(lt->numa);
+		if (pool != NULL) {
+			lite_cpu_topology_t::thread_name_set(pool->name + "#" + std::to_string(lt->num));
+			pool->policy_set = lite_cpu_topology_t::sched_set(pool->policy, pool->prio);
+			if (pool->numa >= 0 || si().pin) lite_cpu_topology_t::pin(pool->numa, lt->num);
+		} else if (lt->numa >= 0 || si().pin) {
+			lite_cpu_topology_t::pin(lt->numa, lt->num);
+		}
+		// Цикл обработки сообщений
+		while(true) {
+			// Проверка необходимости и создание новых потоков
+			lite_actor_t* la = lite_actor_t::find_ready();
+			if (search_end(lt)) { // Поиск после пробуждения закончен
+				// Последний ищущий нашел работу, а в кэше свободного ресурса есть еще - будит следующий поток
+				if (la != NULL && lite_resource_manage_t::cache_any(lt->numa)) {
+					lt->is_free = false;
+					wake_up(lt->numa);
+				}
+			}
+			if(la != NULL) { // Есть что обрабатывать
+				lt->is_free = false;
+				// Обработка сообщений
+				int64_t start = lite_actor_t::time_us();
+				lt->busy_start = start;
+				work_msg(la);
+				lt->busy_start = 0;
+				lt->busy_us += lite_actor_t::time_us() - start;
+			}
+			// Есть акторы, ожидающие свой поток - проверить снова через steal_delay. Поток при этом считается работающим
+			bool skip = lite_actor_t::affinity_skipped();
+			lt->is_free = !skip;
+			if (si().stop) break;
+			// Уход в ожидание
+			bool stop = false;
+			{
+				#ifdef LT_DEBUG
+				lite_log(0, "thread#%d sleep at %lld ms", (int)lt->num, lite_time_now());
+				#endif
+				if(thread_work() == 0) si().cv_end.notify_one(); // Если никто не работает, то разбудить ожидание завершения
+				lite_thread_t* wf = si().worker_free;
+				while(lt->numa < 0 && !skip && (wf == NULL || wf->num > lt->num)) { // Следующим будить поток с меньшим номером
+					si().worker_free.compare_exchange_weak(wf, lt);
+				}
+				std::chrono::microseconds wait(skip ? lite_actor_t::steal_delay() : 1000000);
+				std::unique_lock<std::mutex> lck(lt->mtx_sleep);
+				lt->is_free = !skip;
+				// Повторная проверка под блокировкой ожидания: актор мог стать готовым, пока поток был занят или
+				// искал работу, а пробуждение его не нашло (повторные сообщения и сообщения занятому ресурсу потоки
+				// не будят). Пробуждение после проверки ждет блокировку и не теряется
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t sleep_start = (lite_trace_t::on() ? lite_clock_ns() : 0);
+				if (lt->searching) {
+					// Разбудили до засыпания
+				} else if (!skip && lite_actor_t::ready_missed()) {
+					// Работа есть, ожидание не нужно
+				} else if(lt->cv.wait_for(lck, wait) == std::cv_status::timeout) {	// Проснулся по таймауту
+					if (lite_cpu_topology_t::limit_update()) lite_actor_t::resource_default_update(); // Изменилась квота
+					#ifdef LT_DEBUG
+					lite_log(0, "thread#%d wake up (total: %d, work: %d)", (int)lt->num, (int)si().thread_count, (int)thread_work());
+					#endif
+				} else {
+					#ifdef LT_DEBUG
+					lite_log(0, "thread#%d wake up", (int)lt->num);
+					#endif
+					#ifdef LT_STAT
+					lite_thread_stat_t::ti().stat_thread_wake_up++;
+					#endif
+				}
+				if (sleep_start != 0) lite_trace_t::add(lite_trace_t::LT_TRACE_SLEEP, sleep_start, lite_clock_ns() - sleep_start, NULL, NULL, 0);
+				stop = !skip && !lt->searching && retire(lt, pool);
+				if (si().worker_free == lt) {
+					wf = lt;
+					si().worker_free.compare_exchange_weak(wf, NULL);
+				}
+			}
+			if (stop) {
+				lt->is_free = false;
+				break;
+			}
+		}
+		search_end(lt);
+		lite_actor_t::block_reclaim(&lt->blk);
+		lite_actor_t::block_set(NULL);
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().store(); // Сохранение счетчиков потока
+		#endif
+		lite_lock_t lck(si().mtx); // Блокировка
+		lt->is_end = true;
+		lt->is_free = false;
+		if (si().worker_free == lt) si().worker_free = NULL;
+		si().thread_count--;
+		si().cv_end.notify_one(); // пробуждение end()
+		#ifdef LT_DEBUG
+		lite_log(0, "thread#%d stop", (int)lt->num);
+		#endif
+		lite_actor_t::thread_end();
+		lite_trace_t::thread_end();
+		lite_graph_t::thread_end();
+		#ifdef LT_STAT
+		lite_thread_stat_t::thread_end();
+		#endif
+	}
+
+public: //-------------------------------------
+	// Окончание поиска работы потоком lt. true - это был последний ищущий поток
+	static bool search_end(lite_thread_t* lt) noexcept {
+		if (!lt->searching.exchange(false)) return false;
+		return lt->numa < 0 && --si().searching == 0; // Учитываются только общие потоки
+	}
+
+	// Пробуждение потока wf с пометкой "ищет работу"
+	static void notify(lite_thread_t* wf) noexcept {
+		if (!wf->searching.exchange(true) && wf->numa < 0) si().searching++;
+		{ std::lock_guard<std::mutex> lck(wf->mtx_sleep); } // Поток либо еще не проверил searching, либо уже ждет
+		wf->cv.notify_one();
+		if (lite_trace_t::on()) lite_trace_t::instant(lite_trace_t::LT_TRACE_WAKE, NULL, wf->num);
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().stat_try_wake_up++;
+		#endif
+	}
+
+	// Пробуждение свободного потока узла NUMA numa (-1 общего). Если какой-то поток уже разбужен и ищет 
+	// работу - не требуется, он найдет и при необходимости разбудит следующий
+	static void wake_up(int numa = -1) noexcept {
+		create_retry();
+		if (numa < 0 && si().searching > 0) {
+			#ifdef LT_STAT
+			lite_thread_stat_t::ti().stat_wake_skip++;
+			#endif
+			return;
+		}
+		lite_thread_t* wf = find_free(numa);
+		if (wf != NULL) {
+			notify(wf);
+		} else {
+			create_thread(numa);
+		}
+	}
+
+	// Пробуждение или создание потока взамен заблокированного, без учета ищущих потоков
+	static void wake_up_block(int numa) noexcept {
+		if (si().stop) return;
+		lite_thread_t* wf = find_free(numa);
+		if (wf != NULL) {
+			notify(wf);
+		} else {
+			create_thread(numa);
+		}
+	}
+
+	// Состояние регулятора количества потоков
+	static lite_thread_ctl_t ctl_get() noexcept {
+		std::lock_guard<std::mutex> lck(si().mtx_ctl);
+		return si().ctl;
+	}
+
+	// Пробуждение потока num, если он свободен, иначе любого свободного
+	static void wake_up_prefer(int numa, size_t num) noexcept {
+		if (si().thread_count > 0) {
+			lite_lock_t lck(si().mtx); // Блокировка
+			if (num < si().worker_list.size()) {
+				lite_thread_t* w = si().worker_list[num];
+				if (w->is_free && !w->is_end && w->numa == numa) {
+					notify(w);
+					return;
+				}
+			}
+		}
+		wake_up(numa);
+	}
+
+	// Запуск min потоков выделенного пула
+	static void pool_start(lite_pool_t* pool) noexcept {
+		for (int i = class_count(pool->cls); i < pool->min; i++) create_thread(pool->cls);
+	}
+
+	// Включение привязки потоков к процессорам. Потоки узлов NUMA привязываются к процессорам узла всегда
+	static void pin_set(bool on) noexcept {
+		si().pin = on;
+	}
+
+	// Установка таймера для la
+	static void timer_set(lite_actor_t* la, int time_ms) noexcept {
+		if(si().timer == NULL) {
+			if (time_ms <= 0) return;
+			si().timer = new lite_timer_t;
+		}
+		si().timer->set(la, time_ms);
+	}
+
+	// Однократное пробуждение la через time_ms
+	static void timer_once(lite_actor_t* la, int time_ms) noexcept {
+		if(si().timer == NULL) si().timer = new lite_timer_t;
+		si().timer->once(la, time_ms);
+	}
+
+	// Завершение, ожидание всех потоков
+	static void end() noexcept {
+		// Рассчет еще не начался
+		if(si().thread_count == 1 && thread_work() == 0) {
+			#ifdef LT_DEBUG
+			lite_log(0, "--- wait start ---");
+			#endif	
+			std::this_thread::sleep_for(std::chrono::milliseconds(100)); // для запуска потоков
+		}
+		#ifdef LT_DEBUG
+		lite_log(0, "--- wait all ---");
+		#endif	
+		// Ожидание завершения расчетов. 
+		do {
+			while(thread_work() > 0) {
+				std::unique_lock<std::mutex> lck(si().mtx_end);
+				si().cv_end.wait_for(lck, std::chrono::milliseconds(300));
+			}
+		} while ((lite_shard_t::is_on() && !lite_shard_t::is_idle()) // Потоки режима "поток на ядро"
+			|| lite_actor_t::throttled_wait()); // Ожидающие токены ограничения скорости
+		#ifdef LT_DEBUG
+		lite_log(0, "--- stop all ---");
+		#endif	
+		// Остановка таймеров
+		if (si().timer != NULL) {
+			delete si().timer;
+			si().timer = NULL;
+		}
+		// Остановка потоков
+		monitor_end();
+		if (lite_shard_t::is_on()) {
+			while (!lite_shard_t::is_idle()) { // Дообработка вызовов таймера
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			lite_shard_t::stop();
+		}
+		si().stop = true;
+		while(true) { // Ожидание остановки всех потоков
+			bool is_end = true;
+			{
+				lite_lock_t lck(si().mtx); // Блокировка
+				for (auto& w : si().worker_list) {
+					if(!w->is_end) { // Поток не завершился
+						w->cv.notify_one(); // Пробуждение потока
+						is_end = false;
+					}
+				}
+			}
+			if (is_end) {
+				break;
+			} else { // Ожидание пока какой-нибудь завершившийся поток не разбудит
+				std::unique_lock<std::mutex> lck(si().mtx_end);
+				si().cv_end.wait_for(lck, std::chrono::milliseconds(100));
+			}
+		}
+		// Завершены все потоки
+		assert(si().thread_count == 0);
+
+		// Очистка данных потоков
+		lite_lock_t lck(si().mtx); // Блокировка
+		for (auto& w : si().worker_list) {
+			assert(w != NULL);
+			delete w;
+			w = NULL;
+		}
+		si().worker_list.clear();
+		si().worker_free = NULL;
+		si().searching = 0;
+		si().create_next = 0;
+		si().create_pending = false;
+		si().target = 0;
+		// Дообработка необработанных сообщений. 
+		lite_actor_t::thread_numa(-1);
+		work_msg();
+		lite_actor_t::thread_numa(0);
+		lite_trace_t::end(); // Выгрузка трассировки и графа обменов, пока акторы и ресурсы не удалены
+		lite_graph_t::end();
+		// Удаление акторов
+		lite_actor_t::clear();
+		// Очистка памяти под ресурсы
+		lite_resource_manage_t::clear();
+		#ifdef LT_STAT
+		lite_thread_stat_t::ti().print_stat();
+		#endif		
+		lite_actor_t::thread_end();
+		lite_trace_t::thread_end();
+		lite_graph_t::thread_end();
+		#ifdef LT_STAT
+		lite_thread_stat_t::thread_end();
+		#endif		
+		#ifdef LT_DEBUG
+		printf("         !!! end !!!\n");
+		#endif
+		si().stop = false;
+
+	}
+
+	// Номер текущего потока
+	static size_t this_num(size_t num = 999) noexcept {
+		#ifdef LT_XP_DLL
+		num = GetCurrentThreadId();
+		return num;
+		#else
+		thread_local size_t n = 999;
+		if (num != 999) {
+			n = num;
+		}
+		return n;
+		#endif
+	}
+};
+
+// Функция потока режима "поток на ядро"
+inline void lite_shard_t::thread_func(lite_shard_t* sh) noexcept {
+	ti().self = sh;
+	lite_thread_t::this_num(sh->num);
+	lite_cpu_topology_t::pin(-1, sh->num);
+	while (true) {
+		sh->poll();
+		// Обработка пачкой, затем проверка входящих
+		for (size_t n = sh->local.size(); n > 0 && !sh->local.empty(); n--) {
+			entry_t e = sh->local.front();
+			sh->local.pop_front();
+			e.la->run_shard(e.msg);
+		}
+		if (!sh->local.empty()) continue;
+		if (si().stop) break;
+		// Ожидание входящих: сначала активно, затем засыпание
+		bool found = false;
+		for (int i = 0; i < LT_SHARD_SPIN && !found; i++) found = sh->has_input();
+		if (found) continue;
+		sh->sleeping = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!sh->has_input()) {
+			int64_t sleep_start = (lite_trace_t::on() ? lite_clock_ns() : 0);
+			std::unique_lock<std::mutex> lck(sh->mtx_sleep);
+			sh->cv.wait_for(lck, std::chrono::milliseconds(100), [sh]() { return !sh->sleeping || si().stop; });
+			if (sleep_start != 0) lite_trace_t::add(lite_trace_t::LT_TRACE_SLEEP, sleep_start, lite_clock_ns() - sleep_start, NULL, NULL, 0);
+		}
+		sh->epoch++;
+		sh->sleeping = false;
+	}
+	#ifdef LT_STAT
+	lite_thread_stat_t::ti().store(); // Сохранение счетчиков потока
+	#endif
+	ti().self = NULL;
+	thread_info_t::tls_free();
+	lite_actor_t::thread_end();
+	lite_trace_t::thread_end();
+	lite_graph_t::thread_end();
+	#ifdef LT_STAT
+	lite_thread_stat_t::thread_end();
+	#endif
+}
+
+static int lite_shard_home() noexcept {
+	return lite_shard_t::home_next();
+}
+
+static bool lite_shard_push(int home, lite_actor_t* la, lite_msg_t* msg) noexcept {
+	return lite_shard_t::push(home, la, msg);
+}
+
+//----------------------------------------------------------------------------------
+//----- ВЫВОД В ЛОГ ----------------------------------------------------------------
+//----------------------------------------------------------------------------------
+#ifndef LITE_LOG_BUF_SIZE
+#define LITE_LOG_BUF_SIZE 4096
+#endif
+
+// Сообщение
+struct lite_msg_log_t : public lite_msg_t {
+	lite_msg_log_t(int err, const char* str) : data(str), err_num(err) { }
+
+	std::string data;
+	int err_num;
+};
+
+// Вывод по умолчанию в консоль. При необходимости зарегистрировать свой актор "log"
+class lite_actor_log_t : public lite_actor_t {
+public:
+	void recv(lite_msg_t* msg) override { // Обработчик сообщения
+		lite_msg_log_t* m = dynamic_cast<lite_msg_log_t*>(msg);
+		assert(m != NULL);
+		printf("%s\n", m->data.c_str() + 9);
+	}
+};
+
+// Запись в лог
+static void lite_log(int err, const char* data, ...) noexcept {
+	va_list ap;
+	va_start(ap, data);
+	char buf[LITE_LOG_BUF_SIZE];
+
+	time_t rawtime;
+	time(&rawtime);
+
+	size_t size = 0;
+	char* p = buf;
+
+#ifdef WIN32
+	struct tm timeinfo;
+	localtime_s(&timeinfo, &rawtime);
+	if(err > 0) {
+		size += sprintf_s(p, LITE_LOG_BUF_SIZE - size, "%02d.%02d.%02d %02d:%02d:%02d !!! ERROR %d: ", timeinfo.tm_mday, timeinfo.tm_mon, timeinfo.tm_year % 100, timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec, err);
+	} else {
+		size += sprintf_s(p, LITE_LOG_BUF_SIZE - size, "%02d.%02d.%02d %02d:%02d:%02d ", timeinfo.tm_mday, timeinfo.tm_mon, timeinfo.tm_year % 100, timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+	}
+	p += size;
+	size += vsprintf_s(p, LITE_LOG_BUF_SIZE - size, data, ap);
+	p += size;
+#else
+	struct tm * timeinfo;
+	timeinfo = localtime(&rawtime);
+	if (err > 0) {
+		size += snprintf(p, LITE_LOG_BUF_SIZE - size, "%02d.%02d.%02d %02d:%02d:%02d !!! ERROR %d: ", timeinfo->tm_mday, timeinfo->tm_mon, timeinfo->tm_year % 100, timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, err);
+	} else {
+		size += snprintf(p, LITE_LOG_BUF_SIZE - size, "%02d.%02d.%02d %02d:%02d:%02d ", timeinfo->tm_mday, timeinfo->tm_mon, timeinfo->tm_year % 100, timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
+	}
+	p += size;
+	size += vsnprintf(p, LITE_LOG_BUF_SIZE - size, data, ap);
+	p += size;
+#endif
+	va_end(ap);
+	assert(size < LITE_LOG_BUF_SIZE);
+	*p = 0;
+	lite_msg_log_t* msg = new lite_msg_log_t(err, buf);
+	// Отправка на вывод
+	lite_actor_t* log = lite_actor_t::name_find("log");
+	if(log == NULL) { // Нет актора "log"
+		// Регистрация lite_actor_log_t()
+		log = new lite_actor_log_t();
+		log->name_set("log");
+	}
+	#ifdef LT_DEBUG_LOG
+	log->recv(msg);
+	delete msg;
+	#else
+	log->run(msg);
+	#endif
+}
+
+//----------------------------------------------------------------------------------
+//----- ОБЕРТКИ --------------------------------------------------------------------
+//----------------------------------------------------------------------------------
+#pragma warning( push )
+#pragma warning( disable : 4505 ) // unreferenced local function has been removed
+
+// Получение типа сообщения
+template <typename T>
+static size_t lite_msg_type() {
+	return lite_msg_t::type_get<T>();
+}
+
+// Получения указателя на актор по имени
+static lite_actor_t* lite_actor_get(const std::string& name) noexcept {
+	return lite_actor_t::name_find(name);
+}
+
+// Удаление актора
+static void lite_actor_destroy(lite_actor_t* la) noexcept {
+	return lite_actor_t::destroy(la);
+}
+
+// Завершение с ожиданием всех
+static void lite_thread_end() noexcept {
+	lite_thread_t::end();
+}
+
+// Номер текущего потока
+static size_t lite_thread_num() noexcept {
+	return lite_thread_t::this_num();
+}
+
+// Установка максимума ресурсу по умолчанию
+static void lite_thread_max(int max) noexcept {
+	return lite_actor_t::resource_max(max);
+}
+
+// Создание ресурса. numa >= 0 - акторы выполняются только на процессорах узла NUMA numa
+static lite_resource_t* lite_resource_create(const std::string& name, int max, int numa = -1) noexcept {
+	return lite_resource_manage_t::get(name, max, numa);
+}
+
+// Копирование сообщения
+template <typename T>
+static T* lite_msg_copy(T* msg) noexcept {
+	return lite_actor_t::msg_copy(msg);
+}
+
+// Пробуждение потока
+static void lite_thread_wake_up() noexcept {
+	lite_thread_t::wake_up();
+}
+
+// Пробуждение потока узла NUMA
+static void lite_thread_wake_up_numa(int numa) noexcept {
+	lite_thread_t::wake_up(numa);
+}
+
+// Пробуждение потока num или любого свободного
+static void lite_thread_wake_up_prefer(int numa, size_t num) noexcept {
+	lite_thread_t::wake_up_prefer(numa, num);
+}
+
+// Состояние регулятора количества потоков
+static lite_thread_ctl_t lite_thread_ctl() noexcept {
+	return lite_thread_t::ctl_get();
+}
+
+// Пробуждение или создание потока взамен заблокированного
+static void lite_thread_wake_up_block(int numa) noexcept {
+	lite_thread_t::wake_up_block(numa);
+}
+
+// Отметка блокирующего участка внутри recv(): на время участка единица ресурса актора выдается
+// взаймы, чтобы другие акторы ресурса могли выполняться
+class lite_blocking_scope {
+public:
+	lite_blocking_scope() noexcept {
+		lite_actor_t::block_begin();
+	}
+
+	~lite_blocking_scope() noexcept {
+		lite_actor_t::block_end();
+	}
+
+	lite_blocking_scope(const lite_blocking_scope&) = delete;
+	lite_blocking_scope& operator=(const lite_blocking_scope&) = delete;
+};
+
+// Задержка перехвата актора чужим потоком, мксек. 0 - выключено
+static void lite_thread_affinity(int steal_delay_us) noexcept {
+	lite_actor_t::steal_delay_set(steal_delay_us);
+}
+
+// Взвешенный выбор между уровнями приоритета акторов, по умолчанию строгий
+static void lite_thread_priority_weighted(bool on) noexcept {
+	lite_actor_t::priority_weighted_set(on);
+}
+
+// Включение счетчиков акторов во время работы, без LT_STAT. latency - гистограммы задержек
+static void lite_stats_enable(bool on, bool latency = false) noexcept {
+	lite_actor_t::metrics_set(on, latency);
+}
+
+// Снимок счетчиков акторов, из любого потока в любой момент
+static std::vector<lite_actor_stats_t> lite_stats_snapshot() {
+	return lite_actor_t::metrics_snapshot();
+}
+
+// Включение трассировки: каждый sample-й запуск актора в потоке. file - выгрузка в lite_thread_end()
+static void lite_trace_start(const std::string& file = "", int sample = 1) noexcept {
+	lite_trace_t::start(file, sample);
+}
+
+// Выключение трассировки, записанное сохраняется до следующего включения
+static void lite_trace_stop() noexcept {
+	lite_trace_t::stop();
+}
+
+// Выгрузка трассировки в файл формата Chrome trace (JSON). false - ошибка записи
+static bool lite_trace_dump(const std::string& file) {
+	return lite_trace_t::dump(file);
+}
+
+// Доля запросов сквозной трассировки (0 - выключена, 0.01 - каждый сотый, 1 - все)
+static void lite_e2e_sample(double fraction) noexcept {
+	lite_actor_t::e2e_sample_set(fraction);
+}
+
+// Сквозные задержки запросов по конечным акторам
+static std::vector<lite_e2e_stats_t> lite_e2e_snapshot() {
+	return lite_actor_t::e2e_snapshot();
+}
+
+// Включение записи графа обменов акторов. file - выгрузка в lite_thread_end(), .json - JSON, иначе DOT
+static void lite_graph_enable(bool on, const std::string& file = "") noexcept {
+	lite_graph_t::enable(on, file);
+}
+
+// Ребра графа обменов по убыванию количества сообщений
+static std::vector<lite_graph_edge_t> lite_graph_snapshot() {
+	return lite_graph_t::snapshot();
+}
+
+// Выгрузка графа обменов в формате Graphviz DOT. false - ошибка записи
+static bool lite_graph_dot(const std::string& file) {
+	return lite_graph_t::dump(file, false);
+}
+
+// Выгрузка графа обменов в JSON. false - ошибка записи
+static bool lite_graph_json(const std::string& file) {
+	return lite_graph_t::dump(file, true);
+}
+
+// Выбор актора со старейшим ожидающим сообщением вместо кэшей и порядка списка
+static void lite_thread_oldest_first(bool on) noexcept {
+	lite_actor_t::oldest_first_set(on);
+}
+
+// Привязка потоков к процессорам
+static void lite_thread_pin(bool on) noexcept {
+	lite_thread_t::pin_set(on);
+}
+
+// Выделенный пул потоков ресурса: min потоков запускается сразу, не больше max (0 - максимум ресурса).
+// policy и prio - политика планирования потоков пула (см. lite_sched_t), name - имя потоков
+static lite_pool_t* lite_resource_pool(lite_resource_t* res, int min, int max = 0, lite_sched_t policy = LT_SCHED_NORMAL, int prio = 0, const std::string& name = "") {
+	lite_pool_t* pool = lite_resource_manage_t::pool_set(res, min, max, policy, prio, name);
+	lite_thread_t::pool_start(pool);
+	return pool;
+}
+
+// Включение режима "поток на ядро" с count потоками (<= 0 по количеству процессоров)
+static void lite_thread_shard(int count = 0) noexcept {
+	if (!lite_shard_t::is_on()) lite_shard_t::start(count);
+}
+
+// Запуск с повторами по таймеру
+static void lite_timer_run(lite_actor_t* actor, int time_ms) noexcept {
+	lite_thread_t::timer_set(actor, time_ms);
+}
+
+// Однократное пробуждение актора, остановленного ограничением скорости ресурса
+static void lite_timer_once(lite_actor_t* actor, int time_ms) noexcept {
+	lite_thread_t::timer_once(actor, time_ms);
+}
+
+// Описание процессоров, доступных процессу
+static const lite_cpu_info_t& lite_cpu_info() noexcept {
+	return lite_cpu_topology_t::info();
+}
+
+// Ограничение процессоров cgroup (квота и cpuset). reload = true перечитать, root - свой каталог cgroup
+static lite_cpu_limit_t lite_cpu_limit(bool reload = false, const char* root = NULL) noexcept {
+	lite_cpu_limit_t cl = lite_cpu_topology_t::limit(reload, root);
+	if (reload || root != NULL) lite_actor_t::resource_default_update();
+	return cl;
+}
+
+#ifdef LT_STAT
+// Счетчики статистики с момента запуска или предыдущего сброса, reset = true сброс в 0
+static lite_stat_data_t lite_stat_get(bool reset = false) noexcept {
+	return lite_thread_stat_t::get(reset);
+}
+
+// Включение/отключение вывода статистики в lite_thread_end()
+static void lite_stat_print(bool on) noexcept {
+	lite_thread_stat_t::print_on() = on;
+}
+#endif
+#pragma warning( pop )
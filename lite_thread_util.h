@@ -1,101 +1,191 @@
-﻿#pragma once
-/* lite_thread_util.h
-
-Вспомогательные классы для работы с lite_thread.h
-
-*/
-
-#include "lite_thread.h"
-#include <map>
-
-//----------------------------------------------------------------------------------
-//------ ВОССТАНОВЛЕНИЕ ПОСЛЕДОВАТЕЛЬНОСТИ СООБЩЕНИЙ -------------------------------
-//----------------------------------------------------------------------------------
-/* Актор, восстанавливающий порядок прохождения сообщений, утерянный из-за
-   распараллеливания в процессе обработки.
-
-   Перед началом работы принимает сообщение с хэндлом актора, которому отправлять
-   упорядоченную последовательность.
-
-   Принимает на вход сообщения типа Т, пришедшие не по порядку кэширует.
-
-   тип сообщения T должен иметь поле size_t idx 
-   при отправке сообщений нумеровать idx с нуля.
-
-*/
-
-template <typename T>
-class lite_order_t : public lite_actor_t {
-	typedef std::map<size_t, lite_msg_t*> cache_t;
-
-	cache_t cache;			// Кэш для пришедших в неправильном порядке
-	size_t next;			// Номер следующего на отправку
-	lite_actor_t* send_to;	// Адрес отправки упорядоченной последовательности
-
-public:
-	lite_order_t(const std::string next_actor) : next(0) {
-		send_to = lite_actor_get(next_actor);
-		if (send_to == NULL) { // Не задан адрес пересылки
-			lite_log(LITE_ERROR_USER, "Can`t find actor '%s'", next_actor.c_str());
-			assert(send_to == NULL);
-			return;
-		}
-		// Типы принимаемых сообщений
-		type_add(lite_msg_type<T>());
-	}
-
-	~lite_order_t() {
-		if(cache.size() != 0) {
-			lite_log(LITE_ERROR_USER, "%s have %d msg in cache", name_get().c_str(), cache.size());
-			for(auto& it : cache) {
-				delete it.second; // Явное удаление, т.к. было копирование
-			}
-			cache.clear();
-		}
-	}
-
-	// Обработка сообщения
-	void recv(lite_msg_t* msg) override {
-		T* m = static_cast<T*>(msg);
-
-		if(m->idx == next) {
-			// Сообщение пришло по порядку
-			send_to->run(msg);
-			next++;
-			// Поиск в кэше и отправка 
-			cache_t::iterator it = cache.find(next);
-			while(it != cache.end() && it->first == next) {
-				send_to->run(it->second);
-				cache_t::iterator it_del = it;
-				it++;
-				next++;
-				cache.erase(it_del);
-			}
-		} else {
-			// Пришло не по порядку, сохранение в кэш
-			cache_t::iterator it = cache.find(m->idx);
-			if(it != cache.end()) { // Сообщение с таким номером уже есть в кэше
-				lite_log(LITE_ERROR_USER, "%s receive two msg with idx#%llu", name_get().c_str(), (uint64_t)m->idx);
-				return;
-			}
-			cache[m->idx] = lite_msg_copy(m);
-		}
-	}
-};
-
-//----------------------------------------------------------------------------------
-//------ КОЛИЧЕСТВО ЯДЕР ПРОЦЕССОРА ------------------------------------------------
-//----------------------------------------------------------------------------------
-#ifdef LT_WIN
-#include <windows.h>
-int lite_processor_count() {
-	SYSTEM_INFO sysinfo;
-	GetSystemInfo(&sysinfo);
-	return (int)(sysinfo.dwNumberOfProcessors > 0 ? sysinfo.dwNumberOfProcessors : 1);
-}
-#else
-int lite_processor_count() {
-	return 4;
-}
-#endif
-
+﻿#pragma once
+/* lite_thread_util.h
+
+Вспомогательные классы для работы с lite_thread.h
+
+*/
+
+#include "lite_thread.h"
+#include <map>
+#include <vector>
+
+//----------------------------------------------------------------------------------
+//------ ВОССТАНОВЛЕНИЕ ПОСЛЕДОВАТЕЛЬНОСТИ СООБЩЕНИЙ -------------------------------
+//----------------------------------------------------------------------------------
+/* Актор, восстанавливающий порядок прохождения сообщений, утерянный из-за
+   распараллеливания в процессе обработки.
+
+   Перед началом работы принимает сообщение с хэндлом актора, которому отправлять
+   упорядоченную последовательность.
+
+   Принимает на вход сообщения типа Т, пришедшие не по порядку кэширует.
+
+   тип сообщения T должен иметь поле size_t idx 
+   при отправке сообщений нумеровать idx с нуля.
+
+*/
+
+template <typename T>
+class lite_order_t : public lite_actor_t {
+	typedef std::map<size_t, lite_msg_t*> cache_t;
+
+	cache_t cache;			// Кэш для пришедших в неправильном порядке
+	size_t next;			// Номер следующего на отправку
+	lite_actor_t* send_to;	// Адрес отправки упорядоченной последовательности
+
+public:
+	lite_order_t(const std::string next_actor) : next(0) {
+		send_to = lite_actor_get(next_actor);
+		if (send_to == NULL) { // Не задан адрес пересылки
+			lite_log(LITE_ERROR_USER, "Can`t find actor '%s'", next_actor.c_str());
+			assert(send_to == NULL);
+			return;
+		}
+		// Типы принимаемых сообщений
+		type_add(lite_msg_type<T>());
+	}
+
+	~lite_order_t() {
+		if(cache.size() != 0) {
+			lite_log(LITE_ERROR_USER, "%s have %d msg in cache", name_get().c_str(), cache.size());
+			for(auto& it : cache) {
+				delete it.second; // Явное удаление, т.к. было копирование
+			}
+			cache.clear();
+		}
+	}
+
+	// Обработка сообщения
+	void recv(lite_msg_t* msg) override {
+		T* m = static_cast<T*>(msg);
+
+		if(m->idx == next) {
+			// Сообщение пришло по порядку
+			send_to->run(msg);
+			next++;
+			// Поиск в кэше и отправка 
+			cache_t::iterator it = cache.find(next);
+			while(it != cache.end() && it->first == next) {
+				send_to->run(it->second);
+				cache_t::iterator it_del = it;
+				it++;
+				next++;
+				cache.erase(it_del);
+			}
+		} else {
+			// Пришло не по порядку, сохранение в кэш
+			cache_t::iterator it = cache.find(m->idx);
+			if(it != cache.end()) { // Сообщение с таким номером уже есть в кэше
+				lite_log(LITE_ERROR_USER, "%s receive two msg with idx#%llu", name_get().c_str(), (uint64_t)m->idx);
+				return;
+			}
+			cache[m->idx] = lite_msg_copy(m);
+		}
+	}
+};
+
+//----------------------------------------------------------------------------------
+//------ КОЛИЧЕСТВО ЯДЕР ПРОЦЕССОРА ------------------------------------------------
+//----------------------------------------------------------------------------------
+// Количество логических процессоров, доступных процессу
+int lite_processor_count() {
+	return lite_cpu_info().cpu_count;
+}
+
+//----------------------------------------------------------------------------------
+//------ ЗАМЕР МАСШТАБИРУЕМОСТИ ----------------------------------------------------
+//----------------------------------------------------------------------------------
+/* Прогон задачи на 1..max потоках по reps раз с выводом в out строк CSV:
+
+   threads,rep,time_ms,msg,msg_per_sec,speedup,efficiency[,счетчики LT_STAT]
+
+   func(threads) - выполняет задачу целиком, включая lite_thread_end(), и возвращает количество
+   обработанных сообщений (если 0, то берется msg_send из LT_STAT, без LT_STAT остается 0).
+   speedup - среднее время всех reps прогонов на 1 потоке / время прогона, efficiency = speedup / threads.
+   При включенном LT_STAT счетчики сбрасываются перед каждым прогоном и выводятся в конце строки.
+*/
+
+#ifdef LT_STAT
+// Счетчики LT_STAT в столбцах CSV: заголовок и значения строятся по одной таблице
+struct lite_sweep_field_t {
+	const char* name;
+	size_t lite_stat_data_t::* field;
+};
+
+static const lite_sweep_field_t lite_sweep_fields[] = {
+	{"thread_max", &lite_stat_data_t::stat_thread_max},
+	{"parallel_run", &lite_stat_data_t::stat_parallel_run},
+	{"thread_create", &lite_stat_data_t::stat_thread_create},
+	{"thread_wake_up", &lite_stat_data_t::stat_thread_wake_up},
+	{"try_wake_up", &lite_stat_data_t::stat_try_wake_up},
+	{"actor_find", &lite_stat_data_t::stat_actor_find},
+	{"actor_not_run", &lite_stat_data_t::stat_actor_not_run},
+	{"cache_found", &lite_stat_data_t::stat_cache_found},
+	{"cache_bad", &lite_stat_data_t::stat_cache_bad},
+	{"cache_full", &lite_stat_data_t::stat_cache_full},
+	{"resource_lock", &lite_stat_data_t::stat_res_lock},
+	{"msg_send", &lite_stat_data_t::stat_msg_send},
+	{"affinity_hit", &lite_stat_data_t::stat_affinity_hit},
+	{"affinity_miss", &lite_stat_data_t::stat_affinity_miss},
+	{"wake_skip", &lite_stat_data_t::stat_wake_skip},
+	{"create_skip", &lite_stat_data_t::stat_create_skip},
+	{"ctl_grow", &lite_stat_data_t::stat_ctl_grow},
+	{"ctl_shrink", &lite_stat_data_t::stat_ctl_shrink},
+	{"block_lend", &lite_stat_data_t::stat_block_lend},
+	{"block_scope", &lite_stat_data_t::stat_block_scope},
+	{"throttle", &lite_stat_data_t::stat_throttle},
+	{"resource_move", &lite_stat_data_t::stat_res_move},
+	{"msg_expired", &lite_stat_data_t::stat_msg_expired},
+};
+#endif
+
+template <typename F>
+void lite_sweep(int max, int reps, F func, FILE* out = stdout) {
+	if (max < 1) max = 1;
+	if (reps < 1) reps = 1;
+	fprintf(out, "threads,rep,time_ms,msg,msg_per_sec,speedup,efficiency");
+	#ifdef LT_STAT
+	for (auto& f : lite_sweep_fields) fprintf(out, ",%s", f.name);
+	lite_stat_print(false);
+	lite_stat_get(true);
+	#endif
+	fprintf(out, "\n");
+
+	double base_ms = 0; // Среднее время на 1 потоке
+	for (int threads = 1; threads <= max; threads++) {
+		// Прогоны, вывод после всех повторов, чтобы base_ms был средним по всем прогонам на 1 потоке
+		std::vector<int64_t> times;
+		std::vector<uint64_t> msgs;
+		#ifdef LT_STAT
+		std::vector<lite_stat_data_t> stats;
+		#endif
+		for (int rep = 0; rep < reps; rep++) {
+			std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+			uint64_t msg = (uint64_t)func(threads);
+			int64_t time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t).count();
+			if (time_us <= 0) time_us = 1;
+			#ifdef LT_STAT
+			stats.push_back(lite_stat_get(true));
+			if (msg == 0) msg = stats.back().stat_msg_send;
+			#endif
+			times.push_back(time_us);
+			msgs.push_back(msg);
+		}
+		if (threads == 1) {
+			for (auto& tm : times) base_ms += tm / 1000.0;
+			base_ms /= times.size();
+		}
+		for (int rep = 0; rep < reps; rep++) {
+			double speedup = base_ms / (times[rep] / 1000.0);
+			fprintf(out, "%d,%d,%.3f,%llu,%.0f,%.3f,%.3f", threads, rep, times[rep] / 1000.0, (unsigned long long)msgs[rep], msgs[rep] * 1000000.0 / times[rep], speedup, speedup / threads);
+			#ifdef LT_STAT
+			for (auto& f : lite_sweep_fields) fprintf(out, ",%llu", (unsigned long long)(stats[rep].*f.field));
+			#endif
+			fprintf(out, "\n");
+		}
+		fflush(out);
+	}
+	#ifdef LT_STAT
+	lite_stat_print(true);
+	#endif
+}
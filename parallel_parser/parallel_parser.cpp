@@ -1,154 +1,302 @@
-﻿/* Параллельная обработка потока MSG_COUNT сообщений WORKER_COUNT обработчиками.
-*/
-
-#ifndef _DEBUG
-#define WORKER_COUNT 3  // Количество обработчиков
-#define MSG_COUNT	1000000	// Количество сообщений
-#else
-#define WORKER_COUNT 3  // Количество обработчиков
-#define MSG_COUNT	100	// Количество сообщений
-#endif
-
-#define CPU_MAX 8 // Максимальное количество одновременно работающих потоков
-//---------------------------------------------------------------------
-//#define LT_DEBUG
-#define LT_STAT
-//#define LT_STAT_QUEUE
-//#define LT_DEBUG_LOG
-//#define LT_XP_DLL
-#ifdef NDEBUG
-#undef NDEBUG
-#endif
-#include "../lite_thread.h"
-#include <atomic>
-#include <vector>
-#include <stdio.h>
-#include <string.h>
-
-//---------------------------------------------------------------------
-// Содержимое сообщения
-struct msg_t : public lite_msg_t {
-	int number;	// Номер сообщения
-};
-
-//---------------------------------------------------------------------
-class worker_t : public lite_actor_t {
-	lite_actor_t* next; // Следующий обработчик
-	int64_t sum = 0; // Контрольная сумма
-
-	void recv(lite_msg_t* msg) override {
-		msg_t* m = static_cast<msg_t*>(msg);
-
-		// Обработка сообщения
-		sum += m->number;
-
-		// Передеча дальше
-		next->run(m);
-	}
-
-public:
-	// Конструктор
-	worker_t(lite_actor_t* next) : next(next) {	
-		type_add(lite_msg_type<msg_t>());
-	}
-
-	// Завершение работы актора
-	~worker_t() {
-		lite_log(0, "sum %lld", sum);
-	}
-
-};
-
-//---------------------------------------------------------------------
-// Подготовка сообщения и отправка на обработку
-class start_t : public lite_actor_t {
-	int count = {MSG_COUNT}; // Счетчик исходящих сообщений
-	lite_actor_t* next; // Следующий обработчик
-
-	void recv(lite_msg_t* msg) override {
-		if (count <= 0) return;
-			
-		msg_t* m = static_cast<msg_t*>(msg);
-		
-		// Создание сообщения
-		m->number = --count;
-
-		next->run(m);
-	}
-public:
-	// Конструктор
-	start_t() {
-		type_add(lite_msg_type<msg_t>());
-	}
-
-	// Следующий обработчик
-	void next_set(lite_actor_t* next) {
-		this->next = next;
-	}
-};
-
-//---------------------------------------------------------------------
-// Проверка заполнения сообщения
-class finish_t : public lite_actor_t {
-	lite_actor_t* next; // Следующий обработчик
-	int64_t start; // Время запуска
-
-	void recv(lite_msg_t* msg) override {
-		msg_t* m = static_cast<msg_t*>(msg);
-
-		if(m->number == 0) { // Последнее сообщение
-			uint32_t time = (uint32_t)(lite_time_now() - start);
-			lite_log(0, "time %d msec  speed %d msg/sec\n", time, MSG_COUNT * 1000 / (time == 0 ? 1 : time));
-		} else {
-			next->run(m);
-		}
-	}
-public:
-	// Конструктор
-	finish_t(lite_actor_t* next) : next(next) {	
-		start = lite_time_now();
-		type_add(lite_msg_type<msg_t>());
-	}
-};
-
-
-int main()
-{
-	lite_log(0, "compile %s %s", __DATE__, __TIME__);
-	lite_log(0, "START workers: %d  messages: %d", WORKER_COUNT, MSG_COUNT);
-
-	// Установка ограничения количества потоков
-	lite_thread_max(CPU_MAX);
-
-	// Инициализация акторов
-	start_t* start = new start_t;
-	start->name_set("start");
-
-	lite_actor_t* next = start;
-
-	for(size_t i = 0; i!= WORKER_COUNT; i++) {
-		next = new worker_t(next);
-		next->name_set(std::string("worker#") + std::to_string(i));
-	}
-
-	finish_t* finish = new finish_t(next);
-	finish->name_set("finish");
-
-	start->next_set(finish);
-
-	// Создание сообщений
-	for(size_t i = 0; i != 100; i++) {
-		msg_t* msg = new msg_t();
-		start->run(msg);
-	}
-	
-	lite_thread_end(); // Ожидание окончания расчета
-
-	printf("compile %s %s with %s\n", __DATE__, __TIME__, LOCK_TYPE_LT);
-
-#ifdef _DEBUG
-	printf("Press any key ...");
-	getchar();
-#endif
-	return 0;
-}
+﻿/* Параллельная обработка потока MSG_COUNT сообщений WORKER_COUNT обработчиками.
+
+Запуск:
+parallel_parser.exe
+	однократный прогон с ограничением CPU_MAX потоков
+
+parallel_parser.exe --sweep [max_threads] [reps]
+	замер масштабируемости: прогон на 1..max_threads потоках по reps раз (по умолчанию CPU_MAX и 3)
+	с выводом CSV: время, сообщений в секунду, ускорение, эффективность и счетчики LT_STAT.
+
+parallel_parser.exe --shard ...
+	то же в режиме "поток на ядро" (lite_thread_shard), можно сочетать с --sweep
+
+parallel_parser.exe --affinity us ...
+	то же с задержкой перехвата актора чужим потоком us мксек. (lite_thread_affinity), можно сочетать 
+	с --sweep
+
+parallel_parser.exe --numa [count]
+	передача count блоков по NUMA_BLOCK байт между акторами на ресурсах, привязанных к узлам NUMA,
+	для каждой пары узлов: память блока на узле получателя (local) и на узле отправителя (remote).
+*/
+
+#ifndef _DEBUG
+#define WORKER_COUNT 3  // Количество обработчиков
+#define MSG_COUNT	1000000	// Количество сообщений
+#else
+#define WORKER_COUNT 3  // Количество обработчиков
+#define MSG_COUNT	100	// Количество сообщений
+#endif
+
+#define CPU_MAX 8 // Максимальное количество одновременно работающих потоков
+#define NUMA_BLOCK (64 * 1024) // Размер блока данных для --numa
+#define NUMA_COUNT 20000 // Количество блоков для --numa
+#define NUMA_WINDOW 16 // Блоков в обработке одновременно для --numa
+//---------------------------------------------------------------------
+//#define LT_DEBUG
+#define LT_STAT
+//#define LT_STAT_QUEUE
+//#define LT_DEBUG_LOG
+//#define LT_XP_DLL
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include "../lite_thread_util.h"
+#include <atomic>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+bool verbose = true; // Вывод в лог, отключается при замере масштабируемости
+bool shard = false; // Режим "поток на ядро"
+int affinity = 0; // Задержка перехвата актора чужим потоком, мксек.
+
+//---------------------------------------------------------------------
+// Содержимое сообщения
+struct msg_t : public lite_msg_t {
+	int number;	// Номер сообщения
+};
+
+//---------------------------------------------------------------------
+class worker_t : public lite_actor_t {
+	lite_actor_t* next; // Следующий обработчик
+	int64_t sum = 0; // Контрольная сумма
+
+	void recv(lite_msg_t* msg) override {
+		msg_t* m = static_cast<msg_t*>(msg);
+
+		// Обработка сообщения
+		sum += m->number;
+
+		// Передеча дальше
+		next->run(m);
+	}
+
+public:
+	// Конструктор
+	worker_t(lite_actor_t* next) : next(next) {	
+		type_add(lite_msg_type<msg_t>());
+	}
+
+	// Завершение работы актора
+	~worker_t() {
+		if (verbose) lite_log(0, "sum %lld", sum);
+	}
+
+};
+
+//---------------------------------------------------------------------
+// Подготовка сообщения и отправка на обработку
+class start_t : public lite_actor_t {
+	int count = {MSG_COUNT}; // Счетчик исходящих сообщений
+	lite_actor_t* next; // Следующий обработчик
+
+	void recv(lite_msg_t* msg) override {
+		if (count <= 0) return;
+			
+		msg_t* m = static_cast<msg_t*>(msg);
+		
+		// Создание сообщения
+		m->number = --count;
+
+		next->run(m);
+	}
+public:
+	// Конструктор
+	start_t() {
+		type_add(lite_msg_type<msg_t>());
+	}
+
+	// Следующий обработчик
+	void next_set(lite_actor_t* next) {
+		this->next = next;
+	}
+};
+
+//---------------------------------------------------------------------
+// Проверка заполнения сообщения
+class finish_t : public lite_actor_t {
+	lite_actor_t* next; // Следующий обработчик
+	int64_t start; // Время запуска
+
+	void recv(lite_msg_t* msg) override {
+		msg_t* m = static_cast<msg_t*>(msg);
+
+		if(m->number == 0) { // Последнее сообщение
+			uint32_t time = (uint32_t)(lite_time_now() - start);
+			if (verbose) lite_log(0, "time %d msec  speed %d msg/sec\n", time, MSG_COUNT * 1000 / (time == 0 ? 1 : time));
+		} else {
+			next->run(m);
+		}
+	}
+public:
+	// Конструктор
+	finish_t(lite_actor_t* next) : next(next) {	
+		start = lite_time_now();
+		type_add(lite_msg_type<msg_t>());
+	}
+};
+
+
+// Прогон MSG_COUNT сообщений с ограничением threads потоков
+void run(int threads) {
+	// Установка ограничения количества потоков
+	lite_thread_max(threads);
+	if (shard) lite_thread_shard(threads);
+	lite_thread_affinity(affinity);
+
+	// Инициализация акторов
+	start_t* start = new start_t;
+	start->name_set("start");
+
+	lite_actor_t* next = start;
+
+	for(size_t i = 0; i!= WORKER_COUNT; i++) {
+		next = new worker_t(next);
+		next->name_set(std::string("worker#") + std::to_string(i));
+	}
+
+	finish_t* finish = new finish_t(next);
+	finish->name_set("finish");
+
+	start->next_set(finish);
+
+	// Создание сообщений
+	for(size_t i = 0; i != 100; i++) {
+		msg_t* msg = new msg_t();
+		start->run(msg);
+	}
+	
+	lite_thread_end(); // Ожидание окончания расчета
+}
+
+//---------------------------------------------------------------------
+// Замер передачи блоков между узлами NUMA
+struct msg_block_t : public lite_msg_t {
+	uint64_t data[NUMA_BLOCK / sizeof(uint64_t)];
+};
+
+struct msg_go_t : public lite_msg_t {
+};
+
+// Получатель, читает блок и разрешает отправку следующего
+class numa_sink_t : public lite_actor_t {
+	lite_actor_t* src = {0}; // Отправитель
+	uint64_t sum = {0}; // Контрольная сумма
+
+	void recv(lite_msg_t* msg) override {
+		msg_block_t* b = static_cast<msg_block_t*>(msg);
+		for (auto& d : b->data) sum += d;
+		src->run(new msg_go_t);
+	}
+public:
+	void src_set(lite_actor_t* src_) {
+		src = src_;
+	}
+};
+
+// Отправитель, заполняет блок. local = true - память на узле получателя
+class numa_source_t : public lite_actor_t {
+	int count;
+	bool local;
+	lite_actor_t* dst;
+
+	void recv(lite_msg_t*) override {
+		if (count <= 0) return;
+		count--;
+		msg_block_t* b = local ? new(dst) msg_block_t : new msg_block_t;
+		for (auto& d : b->data) d = (uint64_t)count;
+		dst->run(b);
+	}
+public:
+	numa_source_t(int count, bool local, lite_actor_t* dst) : count(count), local(local), dst(dst) {
+	}
+};
+
+// Передача count блоков с узла src на узел dst, возвращает время в мсек.
+int64_t numa_run(int src, int dst, bool local, int count) {
+	lite_resource_t* rs = lite_resource_create("NUMA_SRC", 1, src);
+	lite_resource_t* rd = lite_resource_create("NUMA_DST", 1, dst);
+	numa_sink_t* sink = new(rd) numa_sink_t;
+	numa_source_t* source = new(rs) numa_source_t(count, local, sink);
+	sink->src_set(source);
+
+	int64_t start = lite_time_now();
+	for (int i = 0; i != NUMA_WINDOW; i++) {
+		source->run(new msg_go_t);
+	}
+	lite_thread_end();
+	return lite_time_now() - start;
+}
+
+void numa_bench(int count) {
+	std::vector<int> nodes;
+	for (auto& c : lite_cpu_info().cpu) {
+		bool found = false;
+		for (int n : nodes) found = found || (n == c.numa);
+		if (!found) nodes.push_back(c.numa);
+	}
+
+#ifdef LT_STAT
+	lite_stat_print(false);
+#endif
+	printf("src,dst,memory,time_ms,blocks_per_sec,mb_per_sec\n");
+	for (int src : nodes) {
+		for (int dst : nodes) {
+			for (int local = 1; local >= 0; local--) {
+				int64_t time = numa_run(src, dst, local != 0, count);
+				if (time <= 0) time = 1;
+				double bps = count * 1000.0 / time;
+				printf("%d,%d,%s,%lld,%.0f,%.1f\n", src, dst, local ? "local" : "remote", (long long)time, bps, bps * NUMA_BLOCK / (1024 * 1024));
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++) { // Ключи --shard и --affinity us в любом месте
+		int n = 0;
+		if (strcmp(argv[i], "--shard") == 0) {
+			shard = true;
+			n = 1;
+		} else if (strcmp(argv[i], "--affinity") == 0 && i + 1 < argc) {
+			affinity = atoi(argv[i + 1]);
+			n = 2;
+		}
+		if (n > 0) {
+			for (int j = i; j < argc - n; j++) argv[j] = argv[j + n];
+			argc -= n;
+			i--;
+		}
+	}
+	if (argc > 1 && strcmp(argv[1], "--numa") == 0) { // Замер передачи между узлами NUMA, вывод CSV
+		numa_bench(argc > 2 ? atoi(argv[2]) : NUMA_COUNT);
+		return 0;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--sweep") == 0) { // Замер масштабируемости, вывод CSV
+		int max = (argc > 2 ? atoi(argv[2]) : CPU_MAX);
+		int reps = (argc > 3 ? atoi(argv[3]) : 3);
+		verbose = false;
+		lite_sweep(max, reps, [](int threads) {
+			run(threads);
+			return MSG_COUNT;
+		});
+		return 0;
+	}
+
+	lite_log(0, "compile %s %s", __DATE__, __TIME__);
+	lite_log(0, "START workers: %d  messages: %d%s", WORKER_COUNT, MSG_COUNT, shard ? "  mode: shard" : "");
+
+	run(CPU_MAX);
+
+	printf("compile %s %s with %s\n", __DATE__, __TIME__, LOCK_TYPE_LT);
+
+#ifdef _DEBUG
+	printf("Press any key ...");
+	getchar();
+#endif
+	return 0;
+}
@@ -1,296 +1,622 @@
-﻿/* Тест работоспособности.
-При успешном завершении выдает в конце "Test OK. worked: ... msg (min ... max ...)"
-
-Создается ACTOR_COUNT акторов обработчиков для каждого сообщения.
-Запускается MSG_COUNT сообщений (от количества сообщений зависит сколько максимум потоков потребуется)
-
-Каждое сообщение содержит карту акторов и отметки прохождения акторов, при очередной пересылке 
-случайным образом выбирается следующий непройденный актор и пересылается ему. 
-
-Каждый актор ставит свой флаг обработки. По прохождению STEP_COUNT акторов сообщение отправляется на финиш.
-На финише проверка что все акторы пройдены и запуск нового сообщения.
-
-Сообщения гоняются по кругу TEST_TIME секунд
-*/
-
-#ifndef _DEBUG
-#define ACTOR_COUNT 1000  // Количество обработчиков
-#define STEP_COUNT  100  // Количество шагов, которое должно пройти сообщение
-#define MSG_COUNT	100  // Количество одновременно идущих сообщений
-#define TEST_TIME	10  // Время теста, сек.
-#else
-#define ACTOR_COUNT 100
-#define STEP_COUNT  10
-#define MSG_COUNT	2
-#define TEST_TIME	3
-#endif
-
-#define CPU_MAX 8 // Максимальное количество одновременно работающих потоков
-//---------------------------------------------------------------------
-//#define LT_DEBUG
-#define LT_STAT
-//#define LT_STAT_QUEUE
-//#define LT_DEBUG_LOG
-//#define LT_XP_DLL
-#ifdef NDEBUG
-#undef NDEBUG
-#endif
-#include "../lite_thread.h"
-#include <atomic>
-#include <vector>
-#include <stdio.h>
-#include <string.h>
-
-//---------------------------------------------------------------------
-std::atomic<int> msg_count = { 0 }; // Счетчик сообщений дошедших до финиша
-std::atomic<int> msg_total = { 0 }; // Счетчик сообщений прошедших через обработчика
-std::atomic<int> msg_count_min = { 999999999 }; // Мин. количество кругов пройденных одним сообщением
-std::atomic<int> msg_count_max = { 0 }; // Макс. количество кругов пройденных одним сообщением
-std::atomic<int> msg_finished = { 0 }; // Счетчик сообщений пришедших после остановки теста
-std::atomic<int> time_alert = { 500 }; // Время следующего вывода состояния теста
-std::atomic<bool> stop_all = { 0 }; // Флаг завершения работы
-
-//---------------------------------------------------------------------
-// Содержимое сообщения
-struct msg_t : public lite_msg_t {
-	size_t worker_num;		// Номер обработчика сообщения
-	size_t rand;			// Для генерации следующего шага
-	int count_all;		// Количество пройденных циклов
-	size_t step_count;	// Количество пройденных шагов
-	lite_actor_t* map[ACTOR_COUNT]; // Список акторов
-	bool mark[ACTOR_COUNT]; // Отметка актора об обработке сообщения
-};
-
-//---------------------------------------------------------------------
-// Обработчик ошибок и вывод лога
-class log_t : public lite_actor_t {
-	void recv(lite_msg_t* msg) override {
-		lite_msg_log_t* m = dynamic_cast<lite_msg_log_t*>(msg);
-		assert(m != NULL);
-		printf("%s\n", m->data.c_str());
-		if(m->err_num != 0) {
-			stop_all = true;
-		}
-	}
-};
-
-//---------------------------------------------------------------------
-
-class worker_t : public lite_actor_t {
-	static std::atomic<int> worker_end; // Счетчик завершивших работу
-
-	int count = 0; // Количество вызовов
-	std::atomic<int> parallel = {0}; // Количество парралельных запусков
-	// Указатель на актор конца обработки
-	lite_actor_t* finish;
-
-	// Обработка сообщения
-	void recv(lite_msg_t* msg) override {
-		parallel++;
-		if(parallel != 1) {
-			lite_log(LITE_ERROR_USER, "parralel %d", (int)parallel);
-			return;
-		}
-		msg_t* m = static_cast<msg_t*>(msg);
-
-		if(m == NULL) { // Неверный тип сообщения
-			lite_log(LITE_ERROR_USER, "wrong msg type");
-			return;
-		}
-		if(m->worker_num < 0 || m->worker_num >= ACTOR_COUNT) { // Индекс за пределами массива
-			lite_log(LITE_ERROR_USER, "worker_num = %d", (int)m->worker_num);
-			return;
-		}
-		if(m->map[m->worker_num] != this) { // Сообщение пришло не тому обработчику
-			lite_log(LITE_ERROR_USER, "wrong worker");
-			return;
-		}
-		if (m->mark[m->worker_num]) { // Сообщение уже обработано этим обработчиком
-			lite_log(LITE_ERROR_USER, "msg already worked");
-			return;
-		}
-		// Отметка что актор пройден
-		m->mark[m->worker_num] = true;
-		m->step_count++;
-		if(m->step_count >= STEP_COUNT) { 
-			// Пройдено нужное количество шагов. Отправка на проверку
-			finish->run(msg);
-		} else {
-			// Выбор следующего
-			for(size_t i = 0; i < 5; i++) {
-				m->rand = m->rand * 1023 + 65537;
-				m->worker_num = m->rand % ACTOR_COUNT;
-				if (!m->mark[m->worker_num]) break; // актор m->worker_num не пройден
-			}
-			if(m->mark[m->worker_num]) { // актор m->worker_num пройден
-				// Поиск следующего непройденного
-				for(size_t i = m->worker_num; i < ACTOR_COUNT; i++) {
-					if(!m->mark[i]) { // Актор i не пройден
-						m->worker_num = i;
-						break;
-					}
-				}
-			}
-			if (m->mark[m->worker_num]) { // актор m->worker_num пройден
-				// Поиск следующего непройденного
-				for (size_t i = 0; i < m->worker_num; i++) {
-					if (!m->mark[i]) { // Актор i не пройден
-						m->worker_num = i;
-						break;
-					}
-				}
-			}
-
-			// Отправка сообщения следующему
-			m->map[m->worker_num]->run(msg);
-		}
-		count++;
-		parallel--;
-	}
-
-public:
-	// Конструктор
-	worker_t() {
-		finish = lite_actor_get("finish");
-		assert(finish != NULL);
-		count = 0;
-		type_add(lite_msg_type<msg_t>());
-	}
-
-	// Завершение работы актора
-	~worker_t() {
-		msg_total += count;
-		worker_end++;
-		if (count == 0 && !stop_all) printf("WARNING: worker count = 0\n");
-		return;
-	}
-
-	// Количество обработанных сообщений
-	int count_msg() {
-		return count;
-	}
-	// Количество завершивших работу
-	static int count_end() {
-		return worker_end;
-	}
-};
-std::atomic<int> worker_t::worker_end = { 0 };  // Счетчик завершивших работу 
-
-//---------------------------------------------------------------------
-// Подготовка сообщения и отправка на обработку
-class start_t : public lite_actor_t {
-	void recv(lite_msg_t* msg) override {
-		msg_t* m = static_cast<msg_t*>(msg);
-		if(m == NULL) {
-			lite_log(LITE_ERROR_USER, "start: wrong msg type");
-			return;
-		}
-		// Очистка отметок выполнения
-		m->count_all++;
-		m->rand = m->rand * 1023 + 65537;
-		m->worker_num = m->rand % ACTOR_COUNT;
-		m->step_count = 0;
-		memset(m->mark, 0, sizeof(m->mark));
-		// Отправка дальше
-		m->map[m->worker_num]->run(msg);
-	}
-};
-
-//---------------------------------------------------------------------
-// Проверка заполнения сообщения
-class finish_t : public lite_actor_t {
-	void recv(lite_msg_t* msg) override {
-		msg_t* m = static_cast<msg_t*>(msg);
-		if (m == NULL) {
-			lite_log(LITE_ERROR_USER, "finish: wrong msg type");
-			return;
-		}
-		// Проверка прохождения всех обработчиков
-		size_t count = 0;
-		for(size_t i = 0; i < ACTOR_COUNT; i++) {
-			if (m->mark[i]) count++;
-		}
-		if(count != STEP_COUNT) {
-			lite_log(LITE_ERROR_USER, "skipped %d actors", (int)(ACTOR_COUNT - count));
-			return;
-		}
-
-		msg_count++;
-
-		int64_t time = lite_time_now();
-		if(stop_all || time > TEST_TIME * 1000) {
-			// Время теста истекло
-			msg_finished++;
-			if (msg_count_max < m->count_all) msg_count_max = m->count_all;
-			if (msg_count_min > m->count_all) msg_count_min = m->count_all;
-			return;
-		} else if(time > time_alert) {
-			// Вывод текущего состояния раз 0.5 сек
-			time_alert += 500;
-			lite_log(0, "%5lld: worked %d msg", lite_time_now(), (int)msg_count);
-		}
-		// Проверки пройдены, запуск следующего
-		static lite_actor_t* start = NULL;
-		if (start == NULL) start = lite_actor_get("start");
-		start->run(msg);
-		//lite_thread_run(msg, start);
-	}
-};
-
-
-int main()
-{
-	// Установка обработчика ошибок
-	log_t* log = new log_t;
-	log->name_set("log");
-
-	lite_log(0, "compile %s %s", __DATE__, __TIME__);
-	lite_log(0, "START workers: %d  messages: %d  time: %d sec", ACTOR_COUNT, MSG_COUNT, TEST_TIME);
-
-	// Инициализация указателей
-	start_t* start = new start_t;
-	start->name_set("start");
-	start->parallel_set(5);
-
-	finish_t* finish = new finish_t;
-	finish->name_set("finish");
-	finish->parallel_set(5);
-
-	lite_actor_t* worker_list[ACTOR_COUNT];
-	for(size_t i = 0; i < ACTOR_COUNT; i++) {
-		worker_list[i] = new worker_t;
-	}
-
-	// Установка ограничения количества потоков
-	lite_thread_max(CPU_MAX);
-
-	// Создание сообщений
-	for(size_t i = 0; i < MSG_COUNT; i++) {
-		msg_t* msg = new msg_t();
-		msg->rand = i;
-		msg->count_all = 0;
-		for (size_t j = 0; j < ACTOR_COUNT; j++) msg->map[j] = worker_list[j];
-
-		start->run(msg);
-	}
-	
-	lite_thread_end(); // Ожидание окончания расчета
-
-	if(msg_finished != MSG_COUNT) {
-		printf("ERROR: lost %d messages\n", MSG_COUNT - msg_finished);
-	} else if (worker_t::count_end() != ACTOR_COUNT) {
-		printf("ERROR: lost %d worker finish\n", ACTOR_COUNT - worker_t::count_end());
-	}else if (msg_total != msg_count * STEP_COUNT) {
-		printf("ERROR: total %d need %d\n", (int)msg_total, msg_count * STEP_COUNT);
-	} else {
-		printf("Test OK. worked: %d msg (min %d max %d)\n", (int)msg_count, (int)msg_count_min, (int)msg_count_max);
-	}
-	printf("compile %s %s with %s\n", __DATE__, __TIME__, LOCK_TYPE_LT);
-
-
-#ifdef _DEBUG
-	printf("Press any key ...");
-	getchar();
-#endif
-	return 0;
-}
+﻿/* Тест работоспособности.
+При успешном завершении выдает в конце "Test OK. worked: ... msg (min ... max ...)"
+
+Создается ACTOR_COUNT акторов обработчиков для каждого сообщения.
+Запускается MSG_COUNT сообщений (от количества сообщений зависит сколько максимум потоков потребуется)
+
+Каждое сообщение содержит карту акторов и отметки прохождения акторов, при очередной пересылке 
+случайным образом выбирается следующий непройденный актор и пересылается ему. 
+
+Каждый актор ставит свой флаг обработки. По прохождению STEP_COUNT акторов сообщение отправляется на финиш.
+На финише проверка что все акторы пройдены и запуск нового сообщения.
+
+Сообщения гоняются по кругу TEST_TIME секунд
+
+stress_test --latency [msg_per_sec]
+Замер задержки от постановки в очередь до recv() (p50, p99, max) при обычном выборе актора и при
+lite_thread_oldest_first(true). Один поток, генератор с заданной частотой (по умолчанию 30000/сек.)
+отправляет 80% сообщений нескольким "тяжелым" акторам пачками, остальные - случайным из 200 легких.
+
+stress_test --stats
+Цена счетчиков акторов: сообщения по кругу из 10 акторов без счетчиков, со счетчиками lite_stats_enable(true),
+с гистограммами задержек lite_stats_enable(true, true) и с трассировкой всех и каждого 64-го запуска,
+время на сообщение и добавка к нему. В конце процентили гистограмм одного актора.
+
+stress_test --trace file
+Основной тест с трассировкой каждого 64-го запуска, выгрузка в file (Chrome trace JSON).
+
+stress_test --e2e [fraction]
+Основной тест с замером сквозной задержки круга start -> STEP_COUNT акторов -> finish для доли fraction
+кругов (по умолчанию 0.01), в конце процентили задержки на конечном акторе.
+
+stress_test --pool
+Уменьшение количества потоков рядом с выделенным пулом: сначала нагрузка на общие потоки, затем создается
+пул (min 1) и нагружается до максимума. Поток пула, удерживаемый min, получает больший номер, чем общие.
+После нагрузки количество потоков (lite_thread_ctl) должно снизиться до min пула. При успехе "pool OK".
+
+stress_test --cgroup
+Проверка чтения квоты контейнера: во временном каталоге создаются файлы cgroup v2 (cpu.max) и v1
+(cpu.cfs_quota_us, cpu.cfs_period_us), для каждого варианта сверяется lite_cpu_limit(true, каталог)
+с ожидаемым количеством процессоров. При успехе "cgroup OK", иначе строки "ERROR" и код возврата 1.
+*/
+
+#ifndef _DEBUG
+#define ACTOR_COUNT 1000  // Количество обработчиков
+#define STEP_COUNT  100  // Количество шагов, которое должно пройти сообщение
+#define MSG_COUNT	100  // Количество одновременно идущих сообщений
+#define TEST_TIME	10  // Время теста, сек.
+#else
+#define ACTOR_COUNT 100
+#define STEP_COUNT  10
+#define MSG_COUNT	2
+#define TEST_TIME	3
+#endif
+
+#define CPU_MAX 8 // Максимальное количество одновременно работающих потоков
+//---------------------------------------------------------------------
+//#define LT_DEBUG
+#define LT_STAT
+//#define LT_STAT_QUEUE
+//#define LT_DEBUG_LOG
+//#define LT_XP_DLL
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include "../lite_thread.h"
+#include <atomic>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#ifndef LT_WIN
+#include <unistd.h>
+#endif
+
+//---------------------------------------------------------------------
+std::atomic<int> msg_count = { 0 }; // Счетчик сообщений дошедших до финиша
+std::atomic<int> msg_total = { 0 }; // Счетчик сообщений прошедших через обработчика
+std::atomic<int> msg_count_min = { 999999999 }; // Мин. количество кругов пройденных одним сообщением
+std::atomic<int> msg_count_max = { 0 }; // Макс. количество кругов пройденных одним сообщением
+std::atomic<int> msg_finished = { 0 }; // Счетчик сообщений пришедших после остановки теста
+bool e2e_on = false; // Замер сквозной задержки (--e2e)
+std::atomic<int> time_alert = { 500 }; // Время следующего вывода состояния теста
+std::atomic<bool> stop_all = { 0 }; // Флаг завершения работы
+
+//---------------------------------------------------------------------
+// Содержимое сообщения
+struct msg_t : public lite_msg_t {
+	size_t worker_num;		// Номер обработчика сообщения
+	size_t rand;			// Для генерации следующего шага
+	int count_all;		// Количество пройденных циклов
+	size_t step_count;	// Количество пройденных шагов
+	lite_actor_t* map[ACTOR_COUNT]; // Список акторов
+	bool mark[ACTOR_COUNT]; // Отметка актора об обработке сообщения
+};
+
+//---------------------------------------------------------------------
+// Обработчик ошибок и вывод лога
+class log_t : public lite_actor_t {
+	void recv(lite_msg_t* msg) override {
+		lite_msg_log_t* m = dynamic_cast<lite_msg_log_t*>(msg);
+		assert(m != NULL);
+		printf("%s\n", m->data.c_str());
+		if(m->err_num != 0) {
+			stop_all = true;
+		}
+	}
+};
+
+//---------------------------------------------------------------------
+
+class worker_t : public lite_actor_t {
+	static std::atomic<int> worker_end; // Счетчик завершивших работу
+
+	int count = 0; // Количество вызовов
+	std::atomic<int> parallel = {0}; // Количество парралельных запусков
+	// Указатель на актор конца обработки
+	lite_actor_t* finish;
+
+	// Обработка сообщения
+	void recv(lite_msg_t* msg) override {
+		parallel++;
+		if(parallel != 1) {
+			lite_log(LITE_ERROR_USER, "parralel %d", (int)parallel);
+			return;
+		}
+		msg_t* m = static_cast<msg_t*>(msg);
+
+		if(m == NULL) { // Неверный тип сообщения
+			lite_log(LITE_ERROR_USER, "wrong msg type");
+			return;
+		}
+		if(m->worker_num < 0 || m->worker_num >= ACTOR_COUNT) { // Индекс за пределами массива
+			lite_log(LITE_ERROR_USER, "worker_num = %d", (int)m->worker_num);
+			return;
+		}
+		if(m->map[m->worker_num] != this) { // Сообщение пришло не тому обработчику
+			lite_log(LITE_ERROR_USER, "wrong worker");
+			return;
+		}
+		if (m->mark[m->worker_num]) { // Сообщение уже обработано этим обработчиком
+			lite_log(LITE_ERROR_USER, "msg already worked");
+			return;
+		}
+		// Отметка что актор пройден
+		m->mark[m->worker_num] = true;
+		m->step_count++;
+		if(m->step_count >= STEP_COUNT) { 
+			// Пройдено нужное количество шагов. Отправка на проверку
+			finish->run(msg);
+		} else {
+			// Выбор следующего
+			for(size_t i = 0; i < 5; i++) {
+				m->rand = m->rand * 1023 + 65537;
+				m->worker_num = m->rand % ACTOR_COUNT;
+				if (!m->mark[m->worker_num]) break; // актор m->worker_num не пройден
+			}
+			if(m->mark[m->worker_num]) { // актор m->worker_num пройден
+				// Поиск следующего непройденного
+				for(size_t i = m->worker_num; i < ACTOR_COUNT; i++) {
+					if(!m->mark[i]) { // Актор i не пройден
+						m->worker_num = i;
+						break;
+					}
+				}
+			}
+			if (m->mark[m->worker_num]) { // актор m->worker_num пройден
+				// Поиск следующего непройденного
+				for (size_t i = 0; i < m->worker_num; i++) {
+					if (!m->mark[i]) { // Актор i не пройден
+						m->worker_num = i;
+						break;
+					}
+				}
+			}
+
+			// Отправка сообщения следующему
+			m->map[m->worker_num]->run(msg);
+		}
+		count++;
+		parallel--;
+	}
+
+public:
+	// Конструктор
+	worker_t() {
+		finish = lite_actor_get("finish");
+		assert(finish != NULL);
+		count = 0;
+		type_add(lite_msg_type<msg_t>());
+	}
+
+	// Завершение работы актора
+	~worker_t() {
+		msg_total += count;
+		worker_end++;
+		if (count == 0 && !stop_all) printf("WARNING: worker count = 0\n");
+		return;
+	}
+
+	// Количество обработанных сообщений
+	int count_msg() {
+		return count;
+	}
+	// Количество завершивших работу
+	static int count_end() {
+		return worker_end;
+	}
+};
+std::atomic<int> worker_t::worker_end = { 0 };  // Счетчик завершивших работу 
+
+//---------------------------------------------------------------------
+// Подготовка сообщения и отправка на обработку
+class start_t : public lite_actor_t {
+	void recv(lite_msg_t* msg) override {
+		msg_t* m = static_cast<msg_t*>(msg);
+		if(m == NULL) {
+			lite_log(LITE_ERROR_USER, "start: wrong msg type");
+			return;
+		}
+		// Очистка отметок выполнения
+		m->count_all++;
+		m->rand = m->rand * 1023 + 65537;
+		m->worker_num = m->rand % ACTOR_COUNT;
+		m->step_count = 0;
+		memset(m->mark, 0, sizeof(m->mark));
+		m->trace_begin(); // Новый круг - новый запрос
+		// Отправка дальше
+		m->map[m->worker_num]->run(msg);
+	}
+};
+
+//---------------------------------------------------------------------
+// Вывод сквозной задержки кругов (до удаления акторов в lite_thread_end())
+static void e2e_print() {
+	std::vector<lite_e2e_stats_t> list = lite_e2e_snapshot();
+	for (size_t i = 0; i < list.size(); i++) {
+		const lite_hist_t& h = list[i].latency_ns;
+		printf("E2E %-8s  count %8llu  p50 %8llu  p99 %8llu  p99.9 %8llu  max %8llu ns\n", list[i].name.c_str(),
+			(unsigned long long)h.total, (unsigned long long)h.percentile(50), (unsigned long long)h.percentile(99),
+			(unsigned long long)h.percentile(99.9), (unsigned long long)h.percentile(100));
+	}
+}
+
+//---------------------------------------------------------------------
+// Проверка заполнения сообщения
+class finish_t : public lite_actor_t {
+	void recv(lite_msg_t* msg) override {
+		msg_t* m = static_cast<msg_t*>(msg);
+		if (m == NULL) {
+			lite_log(LITE_ERROR_USER, "finish: wrong msg type");
+			return;
+		}
+		// Проверка прохождения всех обработчиков
+		size_t count = 0;
+		for(size_t i = 0; i < ACTOR_COUNT; i++) {
+			if (m->mark[i]) count++;
+		}
+		if(count != STEP_COUNT) {
+			lite_log(LITE_ERROR_USER, "skipped %d actors", (int)(ACTOR_COUNT - count));
+			return;
+		}
+
+		msg_count++;
+		m->trace_end(); // Круг пройден
+
+		int64_t time = lite_time_now();
+		if(stop_all || time > TEST_TIME * 1000) {
+			// Время теста истекло
+			if (msg_count_max < m->count_all) msg_count_max = m->count_all;
+			if (msg_count_min > m->count_all) msg_count_min = m->count_all;
+			if (++msg_finished == MSG_COUNT && e2e_on) e2e_print();
+			return;
+		} else if(time > time_alert) {
+			// Вывод текущего состояния раз 0.5 сек
+			time_alert += 500;
+			lite_log(0, "%5lld: worked %d msg", lite_time_now(), (int)msg_count);
+		}
+		// Проверки пройдены, запуск следующего
+		static lite_actor_t* start = NULL;
+		if (start == NULL) start = lite_actor_get("start");
+		start->run(msg);
+		//lite_thread_run(msg, start);
+	}
+};
+
+//---------------------------------------------------------------------
+// Замер задержки очереди: обычный выбор и выбор старейшего сообщения
+#define LAT_TIME_NS	2000000000LL // Время замера, нсек.
+#define LAT_COST_US	20			// Время обработки сообщения, мксек.
+
+struct lat_msg_t : public lite_msg_t {
+	int64_t sent;	// Плановое время отправки, нсек.
+};
+
+std::vector<int64_t> lat_list; // Задержки, нсек.
+std::mutex lat_mtx;
+
+static void lat_spin(int us) {
+	int64_t end = lite_clock_ns() + us * 1000;
+	while (lite_clock_ns() < end);
+}
+
+class lat_worker_t : public lite_actor_t {
+	void recv(lite_msg_t* msg) override {
+		lat_spin(LAT_COST_US);
+		std::lock_guard<std::mutex> lck(lat_mtx);
+		lat_list.push_back(lite_clock_ns() - static_cast<lat_msg_t*>(msg)->sent);
+	}
+public:
+	lat_worker_t() {
+		type_add(lite_msg_type<lat_msg_t>());
+	}
+};
+
+// Генератор: сообщения по плановому времени, независимо от того, как часто его запускают
+class lat_gen_t : public lite_actor_t {
+	std::vector<lite_actor_t*> heavy, light;
+	int64_t start, sent = 0;
+	int rate;
+	uint32_t rnd = 1;
+
+	void recv(lite_msg_t*) override {
+		int64_t now = lite_clock_ns();
+		if (now > start + LAT_TIME_NS) return;
+		int64_t need = (now - start) * rate / 1000000000LL;
+		for (; sent < need; sent++) {
+			lat_msg_t* m = new lat_msg_t;
+			m->sent = start + sent * 1000000000LL / rate;
+			rnd = rnd * 1103515245 + 12345;
+			if ((rnd >> 8) % 10 < 8) {
+				heavy[(sent / 500) % heavy.size()]->run(m);
+			} else {
+				light[(rnd >> 12) % light.size()]->run(m);
+			}
+		}
+		run(new lite_msg_t);
+	}
+public:
+	lat_gen_t(int rate) : rate(rate) {
+		for (int i = 0; i < 4; i++) heavy.push_back(new lat_worker_t);
+		for (int i = 0; i < 200; i++) light.push_back(new lat_worker_t);
+		start = lite_clock_ns();
+	}
+};
+
+void latency_test(int rate, bool oldest) {
+	lat_list.clear();
+	lite_thread_max(1);
+	lite_thread_oldest_first(oldest);
+	lat_gen_t* gen = new lat_gen_t(rate);
+	gen->run(new lite_msg_t);
+	lite_thread_end();
+	lite_thread_oldest_first(false);
+	std::sort(lat_list.begin(), lat_list.end());
+	size_t n = lat_list.size();
+	if (n == 0) return;
+	printf("%-8s rate %d msg %d  p50 %lld us  p99 %lld us  max %lld us\n", (oldest ? "oldest" : "default"), rate, (int)n,
+		(long long)lat_list[n / 2] / 1000, (long long)lat_list[n * 99 / 100] / 1000, (long long)lat_list[n - 1] / 1000);
+}
+
+//---------------------------------------------------------------------
+// Цена счетчиков и гистограмм задержек акторов
+#define STATS_ACTORS	10		// Акторов в круге
+#define STATS_HOPS		300000	// Пересылок каждого сообщения
+
+struct stats_msg_t : public lite_msg_t {
+	int hops;
+};
+
+std::atomic<int> stats_done = { 0 }; // Сообщений, прошедших все пересылки
+
+class stats_actor_t : public lite_actor_t {
+	void recv(lite_msg_t* msg) override {
+		if (--static_cast<stats_msg_t*>(msg)->hops > 0) {
+			next->run(msg);
+		} else {
+			stats_done++;
+		}
+	}
+public:
+	lite_actor_t* next = NULL;
+	stats_actor_t() {
+		type_add(lite_msg_type<stats_msg_t>());
+	}
+};
+
+// Время на сообщение, нсек. trace - выборка трассировки, 0 выключена
+static double stats_run(bool on, bool latency, int trace, lite_actor_stats_t* st) {
+	lite_thread_max(1);
+	lite_stats_enable(on, latency);
+	if (trace > 0) lite_trace_start("", trace);
+	std::vector<stats_actor_t*> ring;
+	for (int i = 0; i < STATS_ACTORS; i++) ring.push_back(new stats_actor_t);
+	for (int i = 0; i < STATS_ACTORS; i++) ring[i]->next = ring[(i + 1) % STATS_ACTORS];
+	stats_done = 0;
+	int64_t start = lite_clock_ns();
+	for (int i = 0; i < STATS_ACTORS; i++) {
+		stats_msg_t* m = new stats_msg_t;
+		m->hops = STATS_HOPS;
+		ring[i]->run(m);
+	}
+	while (stats_done < STATS_ACTORS) std::this_thread::yield(); // Снимок нужен до удаления акторов
+	double ns = (double)(lite_clock_ns() - start) / ((double)STATS_ACTORS * STATS_HOPS);
+	if (st != NULL) {
+		for (auto& it : lite_stats_snapshot()) {
+			if (it.actor == ring[0]) *st = it;
+		}
+	}
+	lite_trace_stop();
+	lite_thread_end();
+	lite_stats_enable(false);
+	return ns;
+}
+
+void stats_test() {
+	lite_stat_print(false);
+	lite_actor_stats_t st;
+	double base = 0, counters = 0, latency = 0, trace = 0, trace64 = 0;
+	for (int i = 0; i < 3; i++) { // Лучшее из трех
+		double t = stats_run(false, false, 0, NULL);
+		if (i == 0 || t < base) base = t;
+		t = stats_run(true, false, 0, NULL);
+		if (i == 0 || t < counters) counters = t;
+		t = stats_run(true, true, 0, &st);
+		if (i == 0 || t < latency) latency = t;
+		t = stats_run(false, false, 1, NULL);
+		if (i == 0 || t < trace) trace = t;
+		t = stats_run(false, false, 64, NULL);
+		if (i == 0 || t < trace64) trace64 = t;
+	}
+	printf("off        %6.1f ns/msg\n", base);
+	printf("counters   %6.1f ns/msg  +%.1f\n", counters, counters - base);
+	printf("histograms %6.1f ns/msg  +%.1f\n", latency, latency - base);
+	printf("trace      %6.1f ns/msg  +%.1f\n", trace, trace - base);
+	printf("trace 1/64 %6.1f ns/msg  +%.1f\n", trace64, trace64 - base);
+	printf("actor 0: msg %llu  wait p50 %llu p99 %llu p999 %llu ns  recv p50 %llu p99 %llu p999 %llu ns\n",
+		(unsigned long long)st.recv_ns.total,
+		(unsigned long long)st.wait_ns.percentile(50), (unsigned long long)st.wait_ns.percentile(99), (unsigned long long)st.wait_ns.percentile(99.9),
+		(unsigned long long)st.recv_ns.percentile(50), (unsigned long long)st.recv_ns.percentile(99), (unsigned long long)st.recv_ns.percentile(99.9));
+}
+
+//---------------------------------------------------------------------
+// Уменьшение количества потоков рядом с выделенным пулом
+#define POOL_MIN		1		// Потоков пула не меньше
+#define POOL_WAIT_MS	20000	// Ожидание уменьшения, мсек.
+
+class pool_worker_t : public lite_actor_t {
+	void recv(lite_msg_t*) override {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5)); // Занимает поток
+	}
+};
+
+int pool_test() {
+	lite_thread_max(4);
+	std::vector<lite_actor_t*> gen, pooled;
+	for (int i = 0; i < 8; i++) gen.push_back(new pool_worker_t);
+	for (int i = 0; i < 400; i++) gen[i % gen.size()]->run(new lite_msg_t);
+	std::this_thread::sleep_for(std::chrono::milliseconds(300)); // Общие потоки созданы
+	// Потоки пула получают номера после общих
+	lite_resource_t* res = lite_resource_create("pool", 3);
+	lite_resource_pool(res, POOL_MIN, 3);
+	for (int i = 0; i < 8; i++) {
+		pooled.push_back(new pool_worker_t);
+		pooled.back()->resource_set(res);
+	}
+	for (int i = 0; i < 400; i++) pooled[i % pooled.size()]->run(new lite_msg_t);
+	int peak = 0, threads;
+	int64_t end = lite_time_now() + POOL_WAIT_MS;
+	do {
+		std::this_thread::sleep_for(std::chrono::milliseconds(LT_MONITOR_MS));
+		threads = lite_thread_ctl().threads;
+		if (peak < threads) peak = threads;
+	} while (threads > POOL_MIN && lite_time_now() < end);
+	bool ok = (peak > POOL_MIN + 1 && threads <= POOL_MIN);
+	printf("%speak %d threads, after %d (need <= %d)\n", (ok ? "" : "ERROR: "), peak, threads, POOL_MIN);
+	lite_thread_end();
+	if (ok) printf("pool OK\n");
+	return (ok ? 0 : 1);
+}
+
+//---------------------------------------------------------------------
+// Чтение квоты cgroup из временного каталога
+#ifndef LT_WIN
+static std::string cg_dir; // Временный корень cgroup
+
+// Запись файла name в cg_dir, text = NULL удаление файла
+static void cg_file(const char* name, const char* text) {
+	std::string path = cg_dir + "/" + name;
+	if (text == NULL) {
+		remove(path.c_str());
+		return;
+	}
+	FILE* f = fopen(path.c_str(), "w");
+	if (f == NULL) return;
+	fputs(text, f);
+	fclose(f);
+}
+
+// Сверка квоты и итогового количества процессоров, возвращает true при совпадении
+static bool cg_check(const char* name, double quota, int limit) {
+	lite_cpu_limit_t cl = lite_cpu_limit(true, cg_dir.c_str());
+	bool ok = (cl.quota > quota - 0.001 && cl.quota < quota + 0.001 && cl.limit == limit);
+	printf("%s%-12s quota %.3f limit %d (need quota %.3f limit %d)\n", (ok ? "" : "ERROR: "), name, cl.quota, cl.limit, quota, limit);
+	return ok;
+}
+
+int cgroup_test() {
+	char tmpl[] = "/tmp/lite_cgroup_XXXXXX";
+	if (mkdtemp(tmpl) == NULL) {
+		printf("ERROR: mkdtemp\n");
+		return 1;
+	}
+	cg_dir = tmpl;
+	int n = lite_cpu_info().cpu_count;
+	// Квота округляется вверх и не больше числа процессоров
+	auto need = [n](int q) { return (q < n ? q : n); };
+	bool ok = true;
+
+	ok &= cg_check("missing", 0, n); // Нет файлов - без ограничения
+
+	cg_file("cpu.max", "150000 100000\n"); // v2: 1.5 процессора
+	ok &= cg_check("v2", 1.5, need(2));
+	cg_file("cpu.max", "max 100000\n"); // v2 без ограничения
+	ok &= cg_check("v2 max", 0, n);
+	cg_file("cpu.max", "50000 100000\n");
+	ok &= cg_check("v2 0.5", 0.5, 1);
+	cg_file("cpu.max", NULL);
+
+	cg_file("cpu.cfs_quota_us", "250000\n"); // v1: 2.5 процессора
+	cg_file("cpu.cfs_period_us", "100000\n");
+	ok &= cg_check("v1", 2.5, need(3));
+	cg_file("cpu.cfs_quota_us", "-1\n"); // v1 без ограничения
+	ok &= cg_check("v1 -1", 0, n);
+	cg_file("cpu.cfs_period_us", NULL); // Нет периода
+	cg_file("cpu.cfs_quota_us", "50000\n");
+	ok &= cg_check("v1 no period", 0, n);
+	cg_file("cpu.cfs_quota_us", NULL);
+
+	rmdir(cg_dir.c_str());
+	lite_cpu_limit(true, LT_CGROUP_ROOT); // Возврат к настоящим ограничениям
+	if (ok) printf("cgroup OK\n");
+	return (ok ? 0 : 1);
+}
+#endif
+
+int main(int argc, char** argv)
+{
+#ifndef LT_WIN
+	if (argc > 1 && strcmp(argv[1], "--cgroup") == 0) return cgroup_test();
+#endif
+	if (argc > 1 && strcmp(argv[1], "--pool") == 0) return pool_test();
+	if (argc > 1 && strcmp(argv[1], "--stats") == 0) {
+		stats_test();
+		return 0;
+	}
+	if (argc > 2 && strcmp(argv[1], "--trace") == 0) lite_trace_start(argv[2], 64);
+	if (argc > 1 && strcmp(argv[1], "--e2e") == 0) {
+		e2e_on = true;
+		lite_e2e_sample(argc > 2 ? atof(argv[2]) : 0.01);
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--latency") == 0) {
+		int rate = (argc > 2 ? atoi(argv[2]) : 30000);
+		latency_test(rate, false);
+		latency_test(rate, true);
+		return 0;
+	}
+
+	// Установка обработчика ошибок
+	log_t* log = new log_t;
+	log->name_set("log");
+
+	lite_log(0, "compile %s %s", __DATE__, __TIME__);
+	lite_log(0, "START workers: %d  messages: %d  time: %d sec", ACTOR_COUNT, MSG_COUNT, TEST_TIME);
+
+	// Инициализация указателей
+	start_t* start = new start_t;
+	start->name_set("start");
+	start->parallel_set(5);
+
+	finish_t* finish = new finish_t;
+	finish->name_set("finish");
+	finish->parallel_set(5);
+
+	lite_actor_t* worker_list[ACTOR_COUNT];
+	for(size_t i = 0; i < ACTOR_COUNT; i++) {
+		worker_list[i] = new worker_t;
+	}
+
+	// Установка ограничения количества потоков
+	lite_thread_max(CPU_MAX);
+
+	// Создание сообщений
+	for(size_t i = 0; i < MSG_COUNT; i++) {
+		msg_t* msg = new msg_t();
+		msg->rand = i;
+		msg->count_all = 0;
+		for (size_t j = 0; j < ACTOR_COUNT; j++) msg->map[j] = worker_list[j];
+
+		start->run(msg);
+	}
+	
+	lite_thread_end(); // Ожидание окончания расчета
+
+	if(msg_finished != MSG_COUNT) {
+		printf("ERROR: lost %d messages\n", MSG_COUNT - msg_finished);
+	} else if (worker_t::count_end() != ACTOR_COUNT) {
+		printf("ERROR: lost %d worker finish\n", ACTOR_COUNT - worker_t::count_end());
+	}else if (msg_total != msg_count * STEP_COUNT) {
+		printf("ERROR: total %d need %d\n", (int)msg_total, msg_count * STEP_COUNT);
+	} else {
+		printf("Test OK. worked: %d msg (min %d max %d)\n", (int)msg_count, (int)msg_count_min, (int)msg_count_max);
+	}
+	printf("compile %s %s with %s\n", __DATE__, __TIME__, LOCK_TYPE_LT);
+
+
+#ifdef _DEBUG
+	printf("Press any key ...");
+	getchar();
+#endif
+	return 0;
+}